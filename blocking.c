@@ -0,0 +1,197 @@
+/*
+ * Files that syscalls block on (fifos, ttys, some /dev nodes) cost a child
+ * a whole second each time, until the alarm goes off. Remember which
+ * (file, syscall) pairs did that, so we stop doing it.
+ *
+ * The first time, we set O_NONBLOCK on the fd. Inherited fds share the open
+ * file with main and every other child, so that fixes it for everyone.
+ * If it blocks again anyway (flock, fsync...), we stop picking that fd for
+ * that syscall. Anon inode fds (eventfd, epoll, timerfd...) all share one
+ * dev and ino, so for those we stop at O_NONBLOCK, and the syscalls that
+ * ignore it (epoll_wait) keep their own timeouts short instead.
+ *
+ * The table is in shm so everyone learns from everyone else's timeouts.
+ * Entries only ever get added, and the timeout count is set last, so
+ * fd_blocks() can look without taking the lock.
+ */
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "trinity.h"
+#include "shm.h"
+#include "blocking.h"
+#include "fdinfo.h"
+#include "syscall.h"
+#include "log.h"
+
+/* Blocking this many times with O_NONBLOCK set means we give up on it. */
+#define AVOID_AFTER 2
+
+static unsigned int hash_blocking(dev_t dev, ino_t ino, unsigned int call)
+{
+	unsigned long h;
+
+	h = (dev * 31) + ino;
+	h = (h * 31) + call;
+	return (h ^ (h >> 16)) % NR_BLOCKING_FDS;
+}
+
+static struct blocking_fd * find_blocking(dev_t dev, ino_t ino, unsigned int call)
+{
+	struct blocking_fd *b;
+	unsigned int i, slot;
+
+	slot = hash_blocking(dev, ino, call);
+	for (i = 0; i < NR_BLOCKING_FDS; i++) {
+		b = &shm->blocking_fds[(slot + i) % NR_BLOCKING_FDS];
+		if (b->timeouts == 0)
+			return NULL;
+		if (b->dev == dev && b->ino == ino && b->call == call)
+			return b;
+	}
+	return NULL;
+}
+
+/* Returns how many times it has blocked now, or 0 if the table is full. */
+static unsigned int add_blocking(int fd, dev_t dev, ino_t ino, unsigned int call)
+{
+	struct blocking_fd *b;
+	char path[32];
+	unsigned int i, slot, ret = 0;
+	ssize_t len;
+
+	lock(&shm->blocking_lock);
+
+	b = find_blocking(dev, ino, call);
+	if (b != NULL) {
+		ret = ++b->timeouts;
+		goto out;
+	}
+
+	slot = hash_blocking(dev, ino, call);
+	for (i = 0; i < NR_BLOCKING_FDS; i++) {
+		b = &shm->blocking_fds[(slot + i) % NR_BLOCKING_FDS];
+		if (b->timeouts != 0)
+			continue;
+
+		b->dev = dev;
+		b->ino = ino;
+		b->call = call;
+		b->avoided = 0;
+
+		sprintf(path, "/proc/self/fd/%d", fd);
+		len = readlink(path, b->name, sizeof(b->name) - 1);
+		if (len < 0)
+			len = 0;
+		b->name[len] = '\0';
+
+		__sync_synchronize();
+		b->timeouts = ret = 1;
+		break;
+	}
+out:
+	unlock(&shm->blocking_lock);
+	return ret;
+}
+
+static void note_fd_timeout(int fd, unsigned int call)
+{
+	struct stat sb;
+	dev_t dev;
+	ino_t ino;
+	int flags;
+
+	if (is_anon_inode_fd(fd) == TRUE)
+		goto set_nonblock;
+
+	if (get_fd_identity(fd, &dev, &ino) == FALSE) {
+		if (fstat(fd, &sb) == -1)
+			return;
+		dev = sb.st_dev;
+		ino = sb.st_ino;
+	}
+
+	if (add_blocking(fd, dev, ino, call) != 1)
+		return;
+
+set_nonblock:
+	flags = fcntl(fd, F_GETFL);
+	if (flags != -1 && !(flags & O_NONBLOCK))
+		(void)fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+/*
+ * Called when we come back from the SIGALRM handler, so the child's
+ * syscallno and args are still what timed out.
+ */
+void note_syscall_timeout(int childno)
+{
+	struct childdata *child = &shm->children[childno];
+	struct syscall *entry = syscalls[child->syscallno].entry;
+	unsigned int call = child->syscallno;
+
+	if (child->do32bit == TRUE)
+		call |= BLOCKING_32BIT;
+
+	if (entry->num_args >= 1 && is_fd_argtype(entry->arg1type) == TRUE)
+		note_fd_timeout(child->a1, call);
+	if (entry->num_args >= 2 && is_fd_argtype(entry->arg2type) == TRUE)
+		note_fd_timeout(child->a2, call);
+	if (entry->num_args >= 3 && is_fd_argtype(entry->arg3type) == TRUE)
+		note_fd_timeout(child->a3, call);
+	if (entry->num_args >= 4 && is_fd_argtype(entry->arg4type) == TRUE)
+		note_fd_timeout(child->a4, call);
+	if (entry->num_args >= 5 && is_fd_argtype(entry->arg5type) == TRUE)
+		note_fd_timeout(child->a5, call);
+	if (entry->num_args >= 6 && is_fd_argtype(entry->arg6type) == TRUE)
+		note_fd_timeout(child->a6, call);
+}
+
+/* Has this fd kept blocking in this syscall, even with O_NONBLOCK? */
+bool fd_blocks(int fd, unsigned int call, bool do32bit)
+{
+	struct blocking_fd *b;
+	dev_t dev;
+	ino_t ino;
+
+	if (get_fd_identity(fd, &dev, &ino) == FALSE || is_anon_inode_fd(fd) == TRUE)
+		return FALSE;
+
+	if (do32bit == TRUE)
+		call |= BLOCKING_32BIT;
+
+	b = find_blocking(dev, ino, call);
+	if (b == NULL || b->timeouts < AVOID_AFTER)
+		return FALSE;
+
+	__sync_fetch_and_add(&b->avoided, 1);
+	return TRUE;
+}
+
+/* Each timeout cost a child a second, and so would each one we avoided. */
+void dump_blocking_fds(void)
+{
+	struct blocking_fd *b;
+	unsigned long timeouts = 0, avoided = 0;
+	unsigned int i;
+
+	for (i = 0; i < NR_BLOCKING_FDS; i++) {
+		b = &shm->blocking_fds[i];
+		if (b->timeouts == 0)
+			continue;
+
+		timeouts += b->timeouts;
+		avoided += b->avoided;
+		output(1, "%s blocked in %s %u times, avoided %u times.\n",
+			b->name[0] ? b->name : "?",
+			print_syscall_name(b->call & ~BLOCKING_32BIT, (b->call & BLOCKING_32BIT) ? TRUE : FALSE),
+			b->timeouts, b->avoided);
+	}
+
+	if (timeouts != 0)
+		printf("Syscalls on fds timed out %lu times, and we avoided fds that would have blocked %lu times (up to %lus saved).\n",
+			timeouts, avoided, avoided);
+}
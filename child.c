@@ -22,6 +22,9 @@
 #include "pids.h"
 #include "params.h"	// for 'debug'
 
+/* Which pidslot this process is running in, -1 if it isn't a child. */
+int this_child = -1;
+
 static struct rlimit oldrlimit;
 
 static void disable_coredumps(void)
@@ -91,9 +94,12 @@ static void use_fpu(void)
 
 void init_child(int childno)
 {
+	struct childdata *child = &shm->children[childno];
 	cpu_set_t set;
 	pid_t pid = getpid();
 
+	this_child = childno;
+
 	set_seed(childno);
 
 	disable_coredumps();
@@ -104,11 +110,13 @@ void init_child(int childno)
 		sched_setaffinity(pid, sizeof(set), &set);
 	}
 
-	shm->child_syscall_count[childno] = 0;
+	child->syscall_count = 0;
+
+	init_syscall_timer();
 
 	set_make_it_fail();
 
-	if (rand() % 100 < 50)
+	if (rnd_below(100) < 50)
 		use_fpu();
 }
 
@@ -136,16 +144,18 @@ void check_parent_pid(void)
 	output(0, BUGTXT "Last syscalls:\n");
 
 	for (i = 0; i < MAX_NR_CHILDREN; i++) {
+		struct childdata *child = &shm->children[i];
+
 		// Skip over 'boring' entries.
 		if ((shm->pids[i] == -1) &&
-		    (shm->previous_syscallno[i] == 0) &&
-		    (shm->child_syscall_count[i] == 0))
+		    (child->previous_syscallno == 0) &&
+		    (child->syscall_count == 0))
 			continue;
 
-		output(0, "[%d]  pid:%d call:%s callno:%d\n",
+		output(0, "[%d]  pid:%d call:%s callno:%lu\n",
 			i, shm->pids[i],
-			print_syscall_name(shm->previous_syscallno[i], shm->do32bit[i]),	// FIXME: need previous do32bit
-			shm->child_syscall_count[i]);
+			print_syscall_name(child->previous_syscallno, child->do32bit),	// FIXME: need previous do32bit
+			child->syscall_count);
 	}
 	shm->exit_reason = EXIT_REPARENT_PROBLEM;
 	exit(EXIT_FAILURE);
@@ -0,0 +1,327 @@
+/*
+ * What each fd we know about actually is, so syscalls that only make sense
+ * on one kind of fd (sockets, epoll fds, directories...) can be given one
+ * of those, without having to go fishing through every fd we have.
+ *
+ * Like file_fds, this is per-process: main fills it in for the fds every
+ * child inherits, and children add what they harvest. Each kind has a list
+ * of its fds, and each fd remembers where it is in that list, so adding,
+ * removing and picking are all O(1).
+ */
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "trinity.h"
+#include "fdinfo.h"
+#include "ioctls.h"
+#include "log.h"
+#include "params.h"	// fd_mismatch
+#include "random.h"
+
+struct fdinfo {
+	bool registered;
+	enum fd_kind kind;
+	int flags;				/* F_GETFL when we registered it */
+	dev_t dev;
+	ino_t ino;
+	bool anon;				/* dev and ino are shared with every other anon inode */
+	const struct ioctl_group *grp;		/* NULL if no ioctl group wants it */
+	unsigned short pos;			/* where it is in kind_fds[kind] */
+	unsigned short ioctl_pos;		/* and in ioctl_fds, if grp != NULL */
+};
+
+static struct fdinfo fds[FD_SLOT_MAX];
+
+static unsigned short kind_fds[NR_FD_KINDS][FD_SLOT_MAX];
+static unsigned int nr_kind_fds[NR_FD_KINDS];
+
+/* fds that some ioctl group knows what to do with. */
+static unsigned short ioctl_fds[FD_SLOT_MAX];
+static unsigned int nr_ioctl_fds;
+
+static const char *kind_names[NR_FD_KINDS] = {
+	[FD_KIND_OTHER] = "other",
+	[FD_KIND_REG] = "regular",
+	[FD_KIND_DIR] = "dir",
+	[FD_KIND_CHR] = "chardev",
+	[FD_KIND_BLK] = "blockdev",
+	[FD_KIND_SOCKET] = "socket",
+	[FD_KIND_PIPE] = "pipe",
+	[FD_KIND_EPOLL] = "epoll",
+	[FD_KIND_EVENTFD] = "eventfd",
+	[FD_KIND_TIMERFD] = "timerfd",
+	[FD_KIND_SIGNALFD] = "signalfd",
+	[FD_KIND_INOTIFY] = "inotify",
+	[FD_KIND_FANOTIFY] = "fanotify",
+	[FD_KIND_PERF] = "perf",
+};
+
+/* What the anon inode ones look like in /proc/self/fd */
+static const struct {
+	const char *link;
+	enum fd_kind kind;
+} anon_kinds[] = {
+	{ "anon_inode:[eventpoll]", FD_KIND_EPOLL },
+	{ "anon_inode:[eventfd]", FD_KIND_EVENTFD },
+	{ "anon_inode:[timerfd]", FD_KIND_TIMERFD },
+	{ "anon_inode:[signalfd]", FD_KIND_SIGNALFD },
+	{ "anon_inode:inotify", FD_KIND_INOTIFY },
+	{ "anon_inode:[fanotify]", FD_KIND_FANOTIFY },
+	{ "anon_inode:[perf_event]", FD_KIND_PERF },
+};
+
+#define ANON_INODE_PREFIX "anon_inode:"
+
+static enum fd_kind classify_fd(int fd, const struct stat *sb, bool *anon)
+{
+	char path[32], link[64];
+	ssize_t len;
+	unsigned int i;
+
+	*anon = FALSE;
+
+	switch (sb->st_mode & S_IFMT) {
+	case S_IFREG:	return FD_KIND_REG;
+	case S_IFDIR:	return FD_KIND_DIR;
+	case S_IFCHR:	return FD_KIND_CHR;
+	case S_IFBLK:	return FD_KIND_BLK;
+	case S_IFSOCK:	return FD_KIND_SOCKET;
+	case S_IFIFO:	return FD_KIND_PIPE;
+	default:
+		break;
+	}
+
+	sprintf(path, "/proc/self/fd/%d", fd);
+	len = readlink(path, link, sizeof(link) - 1);
+	if (len <= 0)
+		return FD_KIND_OTHER;
+	link[len] = '\0';
+
+	if (strncmp(link, ANON_INODE_PREFIX, strlen(ANON_INODE_PREFIX)) == 0)
+		*anon = TRUE;
+
+	for (i = 0; i < ARRAY_SIZE(anon_kinds); i++) {
+		if (strcmp(link, anon_kinds[i].link) == 0)
+			return anon_kinds[i].kind;
+	}
+	return FD_KIND_OTHER;
+}
+
+void unregister_fd(int fd)
+{
+	struct fdinfo *info;
+	unsigned int last;
+
+	if (fd < 0 || fd >= FD_SLOT_MAX)
+		return;
+
+	info = &fds[fd];
+	if (info->registered == FALSE)
+		return;
+
+	/* Move whatever's at the end of the list into our place. */
+	last = kind_fds[info->kind][--nr_kind_fds[info->kind]];
+	kind_fds[info->kind][info->pos] = last;
+	fds[last].pos = info->pos;
+
+	if (info->grp != NULL) {
+		last = ioctl_fds[--nr_ioctl_fds];
+		ioctl_fds[info->ioctl_pos] = last;
+		fds[last].ioctl_pos = info->ioctl_pos;
+	}
+
+	info->registered = FALSE;
+}
+
+/* Work out what fd is, and add it to the list for that kind. */
+void register_fd(int fd)
+{
+	struct fdinfo *info;
+	struct stat sb;
+
+	if (fd < 0 || fd >= FD_SLOT_MAX)
+		return;
+
+	/* The kernel reuses numbers, so this may not be what it was last time. */
+	unregister_fd(fd);
+
+	if (fstat(fd, &sb) == -1)
+		return;
+
+	info = &fds[fd];
+	info->dev = sb.st_dev;
+	info->ino = sb.st_ino;
+	info->kind = classify_fd(fd, &sb, &info->anon);
+	info->flags = fcntl(fd, F_GETFL);
+	info->grp = find_ioctl_group(fd);
+
+	info->pos = nr_kind_fds[info->kind];
+	kind_fds[info->kind][nr_kind_fds[info->kind]++] = fd;
+
+	if (info->grp != NULL) {
+		info->ioctl_pos = nr_ioctl_fds;
+		ioctl_fds[nr_ioctl_fds++] = fd;
+	}
+
+	info->registered = TRUE;
+
+	output(2, "fd[%d] is a %s, flags 0x%x%s\n", fd, kind_names[info->kind],
+		info->flags, info->grp != NULL ? ", has ioctls" : "");
+}
+
+enum fd_kind get_fd_kind(int fd)
+{
+	if (fd < 0 || fd >= FD_SLOT_MAX || fds[fd].registered == FALSE)
+		return FD_KIND_OTHER;
+	return fds[fd].kind;
+}
+
+/* The F_GETFL flags it had when it was registered, or -1 if we don't know it. */
+int get_fd_flags(int fd)
+{
+	if (fd < 0 || fd >= FD_SLOT_MAX || fds[fd].registered == FALSE)
+		return -1;
+	return fds[fd].flags;
+}
+
+/* Which file it is, so other processes with a different fd for it can tell. */
+bool get_fd_identity(int fd, dev_t *dev, ino_t *ino)
+{
+	if (fd < 0 || fd >= FD_SLOT_MAX || fds[fd].registered == FALSE)
+		return FALSE;
+	*dev = fds[fd].dev;
+	*ino = fds[fd].ino;
+	return TRUE;
+}
+
+/* eventfds, epoll fds and the like all share one inode, so dev and ino don't say which. */
+bool is_anon_inode_fd(int fd)
+{
+	char path[32], link[64];
+	ssize_t len;
+
+	if (fd >= 0 && fd < FD_SLOT_MAX && fds[fd].registered == TRUE)
+		return fds[fd].anon;
+
+	sprintf(path, "/proc/self/fd/%d", fd);
+	len = readlink(path, link, sizeof(link) - 1);
+	if (len <= 0)
+		return FALSE;
+	link[len] = '\0';
+	return strncmp(link, ANON_INODE_PREFIX, strlen(ANON_INODE_PREFIX)) == 0;
+}
+
+/* What find_ioctl_group() said when we registered it, without the fstat and lookups. */
+const struct ioctl_group * get_fd_ioctl_group(int fd)
+{
+	if (fd < 0 || fd >= FD_SLOT_MAX || fds[fd].registered == FALSE)
+		return find_ioctl_group(fd);
+	return fds[fd].grp;
+}
+
+bool is_fd_argtype(enum argtype type)
+{
+	switch (type) {
+	case ARG_FD:
+	case ARG_FD_SOCKET:
+	case ARG_FD_DIR:
+	case ARG_FD_EPOLL:
+	case ARG_FD_TIMERFD:
+	case ARG_FD_INOTIFY:
+	case ARG_FD_FANOTIFY:
+	case ARG_FD_IOCTL:
+		return TRUE;
+	case ARG_UNDEFINED:
+	case ARG_RANDOM_INT:
+	case ARG_LEN:
+	case ARG_ADDRESS:
+	case ARG_MODE_T:
+	case ARG_NON_NULL_ADDRESS:
+	case ARG_PID:
+	case ARG_RANGE:
+	case ARG_OP:
+	case ARG_LIST:
+	case ARG_RANDPAGE:
+	case ARG_CPU:
+	case ARG_PATHNAME:
+	case ARG_IOVEC:
+	case ARG_IOVECLEN:
+	case ARG_SOCKADDR:
+	case ARG_SOCKADDRLEN:
+	default:
+		return FALSE;
+	}
+}
+
+/*
+ * An fd of the kind the arg wants, or -1 if we don't have one, or if this
+ * is one of the times (see --fd-mismatch) we give it any old fd instead.
+ */
+int get_typed_fd(enum argtype type)
+{
+	enum fd_kind kind;
+
+	if (rnd_below(100) < fd_mismatch)
+		return -1;
+
+	switch (type) {
+	case ARG_FD_SOCKET:	kind = FD_KIND_SOCKET;
+		break;
+	case ARG_FD_DIR:	kind = FD_KIND_DIR;
+		break;
+	case ARG_FD_EPOLL:	kind = FD_KIND_EPOLL;
+		break;
+	case ARG_FD_TIMERFD:	kind = FD_KIND_TIMERFD;
+		break;
+	case ARG_FD_INOTIFY:	kind = FD_KIND_INOTIFY;
+		break;
+	case ARG_FD_FANOTIFY:	kind = FD_KIND_FANOTIFY;
+		break;
+	case ARG_FD_IOCTL:
+		if (nr_ioctl_fds == 0)
+			return -1;
+		return ioctl_fds[rnd_below(nr_ioctl_fds)];
+	case ARG_FD:
+	case ARG_UNDEFINED:
+	case ARG_RANDOM_INT:
+	case ARG_LEN:
+	case ARG_ADDRESS:
+	case ARG_MODE_T:
+	case ARG_NON_NULL_ADDRESS:
+	case ARG_PID:
+	case ARG_RANGE:
+	case ARG_OP:
+	case ARG_LIST:
+	case ARG_RANDPAGE:
+	case ARG_CPU:
+	case ARG_PATHNAME:
+	case ARG_IOVEC:
+	case ARG_IOVECLEN:
+	case ARG_SOCKADDR:
+	case ARG_SOCKADDRLEN:
+	default:
+		return -1;
+	}
+
+	if (nr_kind_fds[kind] == 0)
+		return -1;
+	return kind_fds[kind][rnd_below(nr_kind_fds[kind])];
+}
+
+void dump_fd_kinds(void)
+{
+	char buf[512], *p = buf;
+	unsigned int i;
+
+	for (i = 0; i < NR_FD_KINDS; i++) {
+		if (nr_kind_fds[i] != 0)
+			p += sprintf(p, "%u %s, ", nr_kind_fds[i], kind_names[i]);
+	}
+	if (p == buf)
+		return;
+
+	output(1, "fds: %s%u with ioctls.\n", buf, nr_ioctl_fds);
+}
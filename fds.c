@@ -1,35 +1,39 @@
 #include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
+#include "trinity.h"
 #include "shm.h"
 #include "files.h"
 #include "pids.h"
 #include "net.h"
 #include "log.h"
 #include "params.h"
+#include "random.h"
+#include "syscall.h"
+#include "harvest.h"
+#include "fdinfo.h"
 
 unsigned int nr_file_fds = 0;
 
-static void open_pipes(void)
-{
-	int pipes[2];
-	unsigned int i;
+/*
+ * The file fds don't live in shm. Every process has its own copy of these,
+ * inherited along with the fds themselves, so they always match its fd table.
+ * Main replaces a few at a time (see roll_fds), and children carry on with
+ * the ones they were forked with.
+ */
+int file_fds[NR_FILE_FDS];
+unsigned int fd_generation = 0;
 
-	for (i = 0; i < MAX_PIPE_FDS; i+=2) {
-		if (pipe(pipes) < 0) {
-			perror("pipe fail.\n");
-			exit(EXIT_FAILURE);
-		}
-		shm->pipe_fds[i] = pipes[0];
-		shm->pipe_fds[i+1] = pipes[1];
+/* which generation of each pool slot we have. shm has the latest. */
+static unsigned int file_fd_gen[NR_FILE_FDS];
 
-		output(2, "fd[%d] = pipe\n", shm->pipe_fds[i]);
-		output(2, "fd[%d] = pipe\n", shm->pipe_fds[i+1]);
-	}
-}
+/* fd number -> pool slot + 1, so results can be charged to the right slot. */
+static unsigned short fd_slot[FD_SLOT_MAX];
 
 static int get_new_random_fd(void)
 {
@@ -39,7 +43,7 @@ static int get_new_random_fd(void)
 	int fd = 0;
 	int ret;
 
-	i = rand() % 3;
+	i = rnd_below(3);
 
 	if (do_specific_proto == TRUE)
 		i = 1;
@@ -63,8 +67,8 @@ static int get_new_random_fd(void)
 	switch (i) {
 	case 0:
 retry_file:
-		fd_index = rand() % nr_file_fds;
-		fd = shm->file_fds[fd_index];
+		fd_index = rnd_below(nr_file_fds);
+		fd = file_fds[fd_index];
 
 		/* avoid stdin/stdout/stderr */
 		if (logging == FALSE)
@@ -105,12 +109,12 @@ retry_file:
 			else
 				goto do_pipe;
 		}
-		fd = shm->socket_fds[rand() % nr_sockets];
+		fd = shm->sockets[rnd_below(nr_sockets)].fd;
 		break;
 
 	case 2:
 do_pipe:
-		fd = shm->pipe_fds[rand() % MAX_PIPE_FDS];
+		fd = shm->pipe_fds[rnd_below(MAX_PIPE_FDS)];
 		break;
 	default:
 		break;
@@ -119,26 +123,95 @@ do_pipe:
 	return fd;
 }
 
+/*
+ * Each child keeps coming back to the same fd for a while, so it gets to
+ * do several things in a row to one object. This is per-process, so one
+ * child blocking in read() only makes that child pick another fd.
+ */
+static int sticky_fd = -1;
+static unsigned int sticky_left;	/* syscalls until we pick another */
+
+/* fds that syscalls recently succeeded on, for --fd-success-bias */
+static int good_fds[FD_GOOD_MAX];
+static unsigned int nr_good_fds;
+static unsigned int next_good_fd;	/* what gets replaced once we're full */
+
+static void remember_good_fd(int fd)
+{
+	unsigned int i;
+
+	for (i = 0; i < nr_good_fds; i++) {
+		if (good_fds[i] == fd)
+			return;
+	}
+
+	if (nr_good_fds < FD_GOOD_MAX) {
+		good_fds[nr_good_fds++] = fd;
+		return;
+	}
+	good_fds[next_good_fd] = fd;
+	next_good_fd = (next_good_fd + 1) % FD_GOOD_MAX;
+}
+
+static void forget_good_fd(int fd)
+{
+	unsigned int i;
+
+	for (i = 0; i < nr_good_fds; i++) {
+		if (good_fds[i] == fd) {
+			good_fds[i] = good_fds[--nr_good_fds];
+			if (next_good_fd >= nr_good_fds)
+				next_good_fd = 0;
+			return;
+		}
+	}
+}
+
+static void pick_sticky_fd(void)
+{
+	if (nr_good_fds != 0 && rnd_below(100) < fd_success_bias)
+		sticky_fd = good_fds[rnd_below(nr_good_fds)];
+	else {
+		do {
+			sticky_fd = get_new_random_fd();
+		} while (sticky_fd == 0);
+	}
+
+	sticky_left = rnd_below(FD_STICKY_SYSCALLS) + 5;
+}
+
+/* harvest_result() closed this one to make room, so stop handing it out. */
+void forget_closed_fd(int fd)
+{
+	forget_good_fd(fd);
+	if (fd == sticky_fd)
+		drop_sticky_fd();
+}
+
+/* Called from the SIGALRM handler too, so nothing more than this. */
+void drop_sticky_fd(void)
+{
+	sticky_left = 0;
+}
+
+/* mkcall() calls this once per syscall, that's what the lifetime is counted in. */
+void sticky_fd_tick(void)
+{
+	if (sticky_left != 0)
+		sticky_left--;
+}
+
 int get_random_fd(void)
 {
 	/* 25% chance of returning something new. */
-	if ((rand() % 4) == 0)
+	if (rnd_below(4) == 0)
 		return get_new_random_fd();
 
 	/* the rest of the time, return the same fd as last time. */
-regen:
-	if (shm->fd_lifetime == 0) {
-		shm->current_fd = get_new_random_fd();
-		shm->fd_lifetime = (rand() % shm->max_children) + 5;
-	} else
-		shm->fd_lifetime--;
-
-	if (shm->current_fd == 0) {
-		shm->fd_lifetime = 0;
-		goto regen;
-	}
+	if (sticky_left == 0 || sticky_fd == -1)
+		pick_sticky_fd();
 
-	return shm->current_fd;
+	return sticky_fd;
 }
 
 void setup_fds(void)
@@ -154,13 +227,173 @@ void setup_fds(void)
 		return;
 
 	open_files();
+
+	dump_fd_kinds();
 }
 
-void regenerate_fds(void)
+static void track_file_fd(unsigned int slot, int fd)
 {
-	if (no_files == TRUE)
+	int old = file_fds[slot];
+
+	if (old > 0 && old < FD_SLOT_MAX)
+		fd_slot[old] = 0;
+	unregister_fd(old);
+
+	file_fds[slot] = fd;
+	if (fd > 0 && fd < FD_SLOT_MAX)
+		fd_slot[fd] = slot + 1;
+	register_fd(fd);
+}
+
+void set_file_fd(unsigned int slot, int fd)
+{
+	track_file_fd(slot, fd);
+
+	file_fd_gen[slot]++;
+	shm->file_fd_gen[slot] = file_fd_gen[slot];
+	shm->file_fd_errors[slot] = 0;
+}
+
+/*
+ * The zygote's side of roll_fds: main replaced this slot and sent us its
+ * new fd. Main already bumped the generation, so just catch up with it.
+ */
+void adopt_file_fd(unsigned int slot, int fd)
+{
+	int old = file_fds[slot];
+
+	track_file_fd(slot, fd);
+	file_fd_gen[slot] = shm->file_fd_gen[slot];
+
+	if (old > 0)
+		close(old);
+}
+
+/* One of the fds every child got from main, or stdio/the logfiles? */
+bool is_shared_fd(int fd)
+{
+	unsigned int i;
+	FILE *file;
+
+	if (fd <= 2)
+		return TRUE;
+	if (fd < FD_SLOT_MAX && fd_slot[fd] != 0)
+		return TRUE;
+	if (find_socket(fd) != NULL)
+		return TRUE;
+
+	for (i = 0; i < MAX_PIPE_FDS; i++) {
+		if (shm->pipe_fds[i] == fd)
+			return TRUE;
+	}
+
+	if (logging == TRUE) {
+		for_each_pidslot(i) {
+			file = shm->logfiles[i];
+			if (file != NULL && fileno(file) == fd)
+				return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/* These mean the fd itself is no use any more, rather than the args being bad. */
+static bool fd_went_bad(int err)
+{
+	switch (err) {
+	case EBADF:
+	case EIO:
+	case ENXIO:
+	case ENODEV:
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+
+/*
+ * Called by children after a syscall that took an fd. Only counts if our
+ * copy of that pool slot is the current one, otherwise we'd be blaming the
+ * replacement for what our old fd did.
+ */
+void note_fd_result(int fd, unsigned long ret, int err)
+{
+	unsigned int slot;
+
+	/* EBADF also means 'not open for writing' etc, so check it really went away. */
+	if (IS_ERR(ret) && err == EBADF && fcntl(fd, F_GETFD) == -1) {
+		forget_harvested_fd(fd);
+		unregister_fd(fd);
+		forget_good_fd(fd);
+	}
+
+	if (IS_ERR(ret)) {
+		if (fd == sticky_fd && fd_went_bad(err) == TRUE)
+			drop_sticky_fd();
+	} else if (fd > 2)
+		remember_good_fd(fd);
+
+	if (fd <= 0 || fd >= FD_SLOT_MAX || fd_slot[fd] == 0)
 		return;
 
-	close_files();
-	open_files();
+	slot = fd_slot[fd] - 1;
+	if (file_fd_gen[slot] != shm->file_fd_gen[slot])
+		return;
+
+	if (IS_ERR(ret) && fd_went_bad(err) == TRUE)
+		shm->file_fd_errors[slot]++;
+	else if (shm->file_fd_errors[slot] != 0)
+		shm->file_fd_errors[slot] = 0;
+}
+
+/*
+ * Replace file fds a few at a time, at roughly the rate the old bulk
+ * regeneration got through them, so the pool is never empty or cold.
+ * Fds that keep failing go first, then the oldest. Each new fd also goes
+ * to the zygote, so the children it forks from now on get it too.
+ * Returns how many were replaced.
+ */
+unsigned int roll_fds(void)
+{
+	static unsigned int cursor = 0;
+	static time_t last = 0;
+	unsigned long total, quota;
+	unsigned int i, replaced = 0;
+	time_t now;
+
+	if (no_files == TRUE || nr_file_fds == 0)
+		return 0;
+
+	now = time(NULL);
+	if (now == last)
+		return 0;
+	last = now;
+
+	total = total_syscalls_done();
+	quota = (total - shm->fds_rolled_at) / FD_ROLL_SYSCALLS;
+	shm->fds_rolled_at += quota * FD_ROLL_SYSCALLS;
+	if (quota > FD_ROLL_MAX)
+		quota = FD_ROLL_MAX;
+
+	for (i = 0; i < nr_file_fds; i++) {
+		if (shm->file_fd_errors[i] < FD_ERROR_STREAK)
+			continue;
+		output(1, "[%d] fd %d failed %u times in a row, replacing it.\n",
+			getpid(), file_fds[i], shm->file_fd_errors[i]);
+		if (replace_file_fd(i) == TRUE)
+			zygote_send_fd(i, file_fds[i]);
+		replaced++;
+	}
+
+	while (replaced < quota) {
+		if (replace_file_fd(cursor) == TRUE)
+			zygote_send_fd(cursor, file_fds[cursor]);
+		cursor = (cursor + 1) % nr_file_fds;
+		replaced++;
+	}
+
+	if (replaced != 0)
+		fd_generation++;
+
+	return replaced;
 }
@@ -0,0 +1,193 @@
+/*
+ * On-disk cache of the filename index, so we don't have to walk /proc and
+ * /sys every time we start, and so the same seed picks the same files from
+ * one run to the next.
+ *
+ * The file is laid out the same way as the in-memory index: a header, the
+ * offset of each name, the mode of each name, then the NUL terminated names
+ * themselves. We mmap it read-only and point filenames, fileindex and
+ * filemodes straight into it, so nothing gets copied. Entries that have gone
+ * away since (dead pids in /proc etc) are only noticed when we try to use
+ * them, see get_filename().
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/sysinfo.h>
+
+#include "trinity.h"
+#include "files.h"
+#include "log.h"
+#include "params.h"	// victim_path
+
+static const char *cachefilename = "trinity.filecache";
+
+#define FILECACHE_MAGIC		0x31454c49464e5254ULL	/* "TRNFILE1" */
+#define FILECACHE_VERSION	2
+
+struct filecache_header {
+	uint64_t magic;
+	uint32_t version;
+	uint32_t nr_entries;
+	uint32_t pool_size;
+	uint32_t uid;
+	uint32_t gid;
+	uint32_t filters;	/* file_filters_hash() of what we left out */
+	int64_t created;
+	char roots[PATH_MAX];	/* what we walked to get this list */
+};
+
+static void describe_roots(char *roots)
+{
+	memset(roots, 0, PATH_MAX);
+	if (victim_path != NULL)
+		strncpy(roots, victim_path, PATH_MAX - 1);
+	else
+		strcpy(roots, "/dev:/proc:/sys");
+}
+
+/* Anything created before we booted is full of pids that don't exist any more. */
+static bool cache_from_this_boot(const struct filecache_header *hdr)
+{
+	struct sysinfo si;
+
+	if (sysinfo(&si) == -1)
+		return FALSE;
+
+	return hdr->created > (time(NULL) - si.uptime);
+}
+
+bool load_filecache(void)
+{
+	const struct filecache_header *hdr;
+	const unsigned int *offsets, *modes;
+	const char *pool;
+	char roots[PATH_MAX];
+	struct stat sb;
+	unsigned int i;
+	void *p;
+	int fd;
+
+	fd = open(cachefilename, O_RDONLY);
+	if (fd == -1)
+		return FALSE;
+
+	if (fstat(fd, &sb) == -1 || (size_t) sb.st_size < sizeof(struct filecache_header)) {
+		close(fd);
+		return FALSE;
+	}
+
+	p = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (p == MAP_FAILED)
+		return FALSE;
+
+	hdr = p;
+	offsets = p + sizeof(struct filecache_header);
+	modes = offsets + hdr->nr_entries;
+	pool = (const char *) (modes + hdr->nr_entries);
+
+	describe_roots(roots);
+
+	if ((hdr->magic != FILECACHE_MAGIC) ||
+	    (hdr->version != FILECACHE_VERSION) ||
+	    (hdr->uid != getuid()) || (hdr->gid != getgid()) ||
+	    (strcmp(hdr->roots, roots) != 0) ||
+	    (hdr->filters != file_filters_hash()) ||
+	    (hdr->nr_entries == 0) || (hdr->pool_size == 0) ||
+	    ((size_t) sb.st_size != sizeof(struct filecache_header) +
+		(hdr->nr_entries * 2 * sizeof(unsigned int)) + hdr->pool_size) ||
+	    (pool[hdr->pool_size - 1] != '\0')) {
+		output(0, "Ignoring %s, it doesn't match this run.\n", cachefilename);
+		goto fail;
+	}
+
+	if (cache_from_this_boot(hdr) == FALSE) {
+		output(0, "%s is from before the last boot, rebuilding it.\n", cachefilename);
+		goto fail;
+	}
+
+	for (i = 0; i < hdr->nr_entries; i++) {
+		if (offsets[i] >= hdr->pool_size) {
+			output(0, "%s is corrupt, rebuilding it.\n", cachefilename);
+			goto fail;
+		}
+	}
+
+	filenames = (char *) pool;
+	filenames_size = hdr->pool_size;
+	fileindex = (unsigned int *) offsets;
+	filemodes = (unsigned int *) modes;
+	files_in_index = hdr->nr_entries;
+
+	output(0, "Using %u filenames from %s. Delete it to walk %s again.\n",
+		files_in_index, cachefilename, roots);
+	return TRUE;
+
+fail:
+	munmap(p, sb.st_size);
+	return FALSE;
+}
+
+/* Write to a temporary file and rename it, so other instances never see half a cache. */
+void save_filecache(void)
+{
+	struct filecache_header hdr;
+	char tmpname[64];
+	FILE *fp;
+
+	if (filenames_size > UINT32_MAX)
+		return;
+
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.magic = FILECACHE_MAGIC;
+	hdr.version = FILECACHE_VERSION;
+	hdr.nr_entries = files_in_index;
+	hdr.pool_size = filenames_size;
+	hdr.uid = getuid();
+	hdr.gid = getgid();
+	hdr.created = time(NULL);
+	hdr.filters = file_filters_hash();
+	describe_roots(hdr.roots);
+
+	sprintf(tmpname, "%s.%d", cachefilename, getpid());
+	fp = fopen(tmpname, "w");
+	if (fp == NULL) {
+		output(0, "Couldn't create %s: %s\n", tmpname, strerror(errno));
+		return;
+	}
+
+	if (fwrite(&hdr, sizeof(hdr), 1, fp) != 1 ||
+	    fwrite(fileindex, sizeof(unsigned int), files_in_index, fp) != files_in_index ||
+	    fwrite(filemodes, sizeof(unsigned int), files_in_index, fp) != files_in_index ||
+	    fwrite(filenames, filenames_size, 1, fp) != 1)
+		goto fail;
+
+	if (fclose(fp) != 0) {
+		fp = NULL;
+		goto fail;
+	}
+
+	if (rename(tmpname, cachefilename) == -1) {
+		output(0, "Couldn't rename %s: %s\n", tmpname, strerror(errno));
+		unlink(tmpname);
+		return;
+	}
+
+	output(1, "Saved %u filenames to %s\n", files_in_index, cachefilename);
+	return;
+
+fail:
+	output(0, "Couldn't write %s\n", tmpname);
+	if (fp != NULL)
+		fclose(fp);
+	unlink(tmpname);
+}
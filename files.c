@@ -1,4 +1,3 @@
-#include <ftw.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -6,6 +5,13 @@
 #include <fcntl.h>
 #include <dirent.h>
 #include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 
@@ -17,121 +23,60 @@
 #include "shm.h"
 #include "sanitise.h"
 #include "constants.h"
+#include "random.h"
 
 static int files_added = 0;
-char **fileindex;
+/*
+ * All the filenames live in one read-only arena, NUL separated, in
+ * sorted order. It's mapped shared, so children never get a copy of it.
+ * fileindex[] has the offset of each name in there.
+ */
+char *filenames;
+unsigned long filenames_size;
+unsigned int *fileindex;
+unsigned int *filemodes;	/* st_mode of each, when we found it */
 unsigned int files_in_index = 0;
 
-struct namelist {
-	struct namelist *prev;
-	struct namelist *next;
-	char *name;
+#define indexed_filename(i)	(filenames + fileindex[(i)])
+
+/*
+ * Set for filenames that turned out not to exist any more. The index might
+ * have come from the cache, so this happens. It's shared, so nobody else
+ * tries them again, and we keep them in the index so nothing else moves.
+ */
+static unsigned char *dead_files;
+
+/*
+ * /proc and /sys have tens of thousands of entries between them, and /dev
+ * only a few hundred, so picking from the whole index hardly ever gets a
+ * device node. So the index is also split up by where each file lives and
+ * what it is, and we pick a bucket by weight first, then a file from it.
+ */
+enum { ROOT_DEV, ROOT_PROC, ROOT_SYS, ROOT_OTHER, NR_ROOTS };
+enum { TYPE_CHR, TYPE_BLK, TYPE_REG, TYPE_DIR, TYPE_SPECIAL, NR_TYPES };
+#define NR_BUCKETS (NR_ROOTS * NR_TYPES)
+
+static const char *root_names[NR_ROOTS] = { "dev", "proc", "sys", "other" };
+static const char *type_names[NR_TYPES] = { "chr", "blk", "reg", "dir", "special" };
+
+static unsigned int root_weights[NR_ROOTS] = { 1, 1, 1, 1 };
+static unsigned int type_weights[NR_TYPES] = { 4, 4, 4, 1, 1 };
+
+struct bucket {
+	unsigned int start;	/* into bucket_files[] */
+	unsigned int count;
 };
+static struct bucket buckets[NR_BUCKETS];
+static unsigned int *bucket_files;	/* fileindex entries, grouped by bucket */
 
-static struct namelist *names = NULL;
+/* Each slot is a bucket number, with as many slots as its share of the weight. */
+#define BUCKET_TABLE_SIZE 1024
+static unsigned char bucket_table[BUCKET_TABLE_SIZE];
+static bool buckets_ready = FALSE;
 
 static uid_t my_uid;
 static gid_t my_gid;
 
-static int ignore_files(const char *path)
-{
-	unsigned int i, j;
-	unsigned int pathlen, offset = 0;
-
-	/* These are exact matches. */
-	const char *ignored_paths[] = {
-		".", "..",
-
-		/* dangerous/noisy/annoying stuff in /proc */
-		"/proc/sysrq-trigger", "/proc/kmem", "/proc/kcore",
-
-		/* dangerous/noisy/annoying stuff in /dev */
-		"/dev/log", "/dev/mem", "/dev/kmsg",
-		NULL
-	};
-
-	/* Partial matches. */	//FIXME: This whole function should just use globs to pattern match.
-	const char *ignored_patterns[] = {
-
-		/* dangerous/noisy/annoying per-process stuff. */
-		"coredump_filter", "make-it-fail", "oom_adj", "oom_score_adj",
-		NULL
-	};
-
-	pathlen = strlen(path);
-
-	/* First do the exact matches */
-	for (i = 0; ignored_paths[i]; i++) {
-		if (strlen(ignored_paths[i]) != pathlen) {
-			continue;
-		}
-
-		if (!strcmp(path, ignored_paths[i])) {
-//			printf("Skipping %s\n", path);
-			return 1;
-		}
-	}
-
-	/* Now make sure none of the patterns match the end of the pathname */
-	for (j = 0; j < pathlen; j++) {
-		if (path[j] == '/')
-			offset = j;
-	}
-	offset++;
-
-	if (offset == 1)
-		return 0;
-
-	for (i = 0; ignored_patterns[i]; i++) {
-		if (!strcmp(path + offset, ignored_patterns[i])) {
-//			printf("Skipping pattern %s\n", path);
-			return 1;
-		}
-	}
-
-	/* special case to match tty* until I do globbing */
-	if (!strncmp(path + offset, "tty", 3)) {
-//		printf("Skipping %s\n", path);
-		return 1;
-	}
-	return 0;
-}
-
-static struct namelist *list_alloc(void)
-{
-	struct namelist *node;
-
-	node = malloc(sizeof(struct namelist));
-	if (node == NULL)
-		exit(EXIT_FAILURE);
-	memset(node, 0, sizeof(struct namelist));
-	return node;
-}
-
-static void __list_add(struct namelist *new, struct namelist *prev, struct namelist *next)
-{
-	next->prev = new;
-	new->next = next;
-	new->prev = prev;
-	prev->next = new;
-}
-
-static void list_add(struct namelist *list, const char *name)
-{
-	struct namelist *newnode;
-
-	newnode = list_alloc();
-
-	if (list == NULL) {
-		list = names = newnode;
-		list->next = list;
-		list->prev = list;
-	}
-	newnode->name = strdup(name);
-
-	__list_add(newnode, list, list->next);
-}
-
 static int check_stat_file(const struct stat *sb)
 {
 	int openflag;
@@ -176,68 +121,551 @@ static int check_stat_file(const struct stat *sb)
 	return openflag;
 }
 
-static int file_tree_callback(const char *fpath, const struct stat *sb, __unused__ int typeflag, __unused__ struct FTW *ftwbuf)
+/*
+ * The walk of /dev, /proc and /sys used to be a single nftw(), which on
+ * big machines dominated startup. Now each root gets walked by a thread per
+ * CPU. Each walker has its own queue of directories still to be read, and
+ * takes from the front of someone else's when it runs dry.
+ *
+ * Same rules as the nftw walk had: don't cross mountpoints (FTW_MOUNT),
+ * and don't follow symlinks unless walking a victim path (FTW_PHYS).
+ * That walk was FTW_DEPTH, so skipping an ignored directory's subtree never
+ * actually happened. We keep it that way: ignored directories aren't added,
+ * but what's inside them still is.
+ */
+#define MAX_WALKERS 16
+
+struct linux_dirent64 {
+	uint64_t	d_ino;
+	int64_t		d_off;
+	unsigned short	d_reclen;
+	unsigned char	d_type;
+	char		d_name[];
+};
+
+struct found_file {
+	char *name;
+	unsigned int mode;
+};
+
+struct walker {
+	pthread_t thread;
+	unsigned int id;
+
+	/* directories to read. we take from the back, thieves from the front. */
+	pthread_mutex_t lock;
+	char **dirs;
+	unsigned int head, tail, size;
+
+	/* what we found, merged into the fileindex when everyone is done. */
+	struct found_file *found;
+	unsigned int nr_found, found_size;
+
+	/* the names themselves, packed into big chunks rather than a malloc each. */
+	char *chunk;
+	unsigned int chunk_used;
+};
+
+static struct walker walkers[MAX_WALKERS];
+static unsigned int max_walkers;	/* one per cpu */
+static unsigned int nr_walkers;		/* how many we managed to start */
+
+/* directories queued or being read. when it hits zero, the walk is over. */
+static volatile unsigned long walk_pending;
+
+static dev_t walk_dev;
+static bool walk_follow;
+
+/* When following symlinks, directories we already queued, so loops end. */
+struct dev_ino {
+	dev_t dev;
+	ino_t ino;
+};
+static pthread_mutex_t visited_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct dev_ino *visited;
+static unsigned int nr_visited, visited_size;
+
+static bool first_visit(const struct stat *sb)
+{
+	unsigned int i, h;
+
+	pthread_mutex_lock(&visited_lock);
+
+	if ((nr_visited + 1) * 2 > visited_size) {
+		struct dev_ino *old = visited;
+		unsigned int old_size = visited_size;
+
+		visited_size = visited_size ? visited_size * 2 : 1024;
+		visited = calloc(visited_size, sizeof(struct dev_ino));
+		if (visited == NULL)
+			exit(EXIT_FAILURE);
+		for (i = 0; i < old_size; i++) {
+			if (old[i].ino == 0)
+				continue;
+			h = (old[i].ino ^ old[i].dev) % visited_size;
+			while (visited[h].ino != 0)
+				h = (h + 1) % visited_size;
+			visited[h] = old[i];
+		}
+		free(old);
+	}
+
+	h = (sb->st_ino ^ sb->st_dev) % visited_size;
+	while (visited[h].ino != 0) {
+		if (visited[h].ino == sb->st_ino && visited[h].dev == sb->st_dev) {
+			pthread_mutex_unlock(&visited_lock);
+			return FALSE;
+		}
+		h = (h + 1) % visited_size;
+	}
+	visited[h].dev = sb->st_dev;
+	visited[h].ino = sb->st_ino;
+	nr_visited++;
+
+	pthread_mutex_unlock(&visited_lock);
+	return TRUE;
+}
+
+static void queue_dir(struct walker *w, char *path)
 {
+	__sync_fetch_and_add(&walk_pending, 1);
+
+	pthread_mutex_lock(&w->lock);
+	if (w->tail == w->size) {
+		if (w->head != 0) {
+			memmove(w->dirs, w->dirs + w->head, (w->tail - w->head) * sizeof(char *));
+			w->tail -= w->head;
+			w->head = 0;
+		} else {
+			w->size = w->size ? w->size * 2 : 256;
+			w->dirs = realloc(w->dirs, w->size * sizeof(char *));
+			if (w->dirs == NULL)
+				exit(EXIT_FAILURE);
+		}
+	}
+	w->dirs[w->tail++] = path;
+	pthread_mutex_unlock(&w->lock);
+}
 
-	if (ignore_files(fpath)) {
-		return FTW_SKIP_SUBTREE;
+static char * take_dir(struct walker *w, bool steal)
+{
+	char *path = NULL;
+
+	pthread_mutex_lock(&w->lock);
+	if (w->head != w->tail) {
+		if (steal == TRUE)
+			path = w->dirs[w->head++];
+		else
+			path = w->dirs[--w->tail];
 	}
+	pthread_mutex_unlock(&w->lock);
+	return path;
+}
 
-	// Check we can read it.
-	if (check_stat_file(sb) == -1)
-		return FTW_CONTINUE;
+#define NAME_CHUNK_SIZE	(1024 * 1024)
 
-	if (shm->exit_reason != STILL_RUNNING)
-		return FTW_STOP;
+static char * save_name(struct walker *w, const char *path)
+{
+	size_t len = strlen(path) + 1;
+	char *p;
+
+	if (w->chunk == NULL || w->chunk_used + len > NAME_CHUNK_SIZE) {
+		p = malloc(NAME_CHUNK_SIZE);
+		if (p == NULL)
+			exit(EXIT_FAILURE);
+		/* chain them together, so they can be freed later. */
+		*(char **) p = w->chunk;
+		w->chunk = p;
+		w->chunk_used = sizeof(char *);
+	}
 
-	list_add(names, fpath);
-	//printf("Adding %s\n", fpath);
-	files_added++;
+	p = w->chunk + w->chunk_used;
+	memcpy(p, path, len);
+	w->chunk_used += len;
+	return p;
+}
 
-	return FTW_CONTINUE;
+static void free_names(struct walker *w)
+{
+	char *next;
+
+	while (w->chunk != NULL) {
+		next = *(char **) w->chunk;
+		free(w->chunk);
+		w->chunk = next;
+	}
 }
 
+static void add_found(struct walker *w, const char *path, mode_t mode)
+{
+	if (w->nr_found == w->found_size) {
+		w->found_size = w->found_size ? w->found_size * 2 : 4096;
+		w->found = realloc(w->found, w->found_size * sizeof(struct found_file));
+		if (w->found == NULL)
+			exit(EXIT_FAILURE);
+	}
+	w->found[w->nr_found].name = save_name(w, path);
+	w->found[w->nr_found].mode = mode;
+	w->nr_found++;
+}
 
-static void open_fds(const char *dirpath)
+/* Anything we should add or descend into, whether it's the root or found by read_dir. */
+static void walk_entry(struct walker *w, const char *path, const struct stat *sb)
 {
+	unsigned int filtered;
+
+	if (sb->st_dev != walk_dev)
+		return;
+
+	filtered = match_file_filters(path);
+
+	if (!(filtered & FILTER_IGNORE) && check_stat_file(sb) != -1)
+		add_found(w, path, sb->st_mode);
+
+	if (!S_ISDIR(sb->st_mode) || (filtered & FILTER_PRUNE))
+		return;
+
+	if (walk_follow == TRUE && first_visit(sb) == FALSE)
+		return;
+
+	queue_dir(w, strdup(path));
+}
+
+static void read_dir(struct walker *w, const char *dirpath)
+{
+	char buf[32768];
+	char path[PATH_MAX];
+	struct linux_dirent64 *d;
+	struct stat sb;
+	unsigned int len;
+	long n, off;
+	int fd;
+
+	fd = open(dirpath, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (fd == -1)
+		return;
+
+	len = strlen(dirpath);
+	if (len != 0 && dirpath[len - 1] == '/')
+		len--;
+	if (len + 2 >= sizeof(path))
+		goto out;
+	memcpy(path, dirpath, len);
+	path[len++] = '/';
+
+	while ((n = syscall(SYS_getdents64, fd, buf, sizeof(buf))) > 0) {
+		for (off = 0; off < n; off += d->d_reclen) {
+			d = (struct linux_dirent64 *) (buf + off);
+
+			if (!strcmp(d->d_name, ".") || !strcmp(d->d_name, ".."))
+				continue;
+
+			if (len + strlen(d->d_name) >= sizeof(path))
+				continue;
+			strcpy(path + len, d->d_name);
+
+			if (fstatat(fd, d->d_name, &sb, walk_follow ? 0 : AT_SYMLINK_NOFOLLOW) == -1)
+				continue;
+
+			walk_entry(w, path, &sb);
+		}
+
+		if (shm->exit_reason != STILL_RUNNING)
+			break;
+	}
+out:
+	close(fd);
+}
+
+static void * walk_thread(void *arg)
+{
+	struct walker *w = arg;
+	unsigned int i;
+	char *path;
+
+	while (walk_pending != 0) {
+		path = take_dir(w, FALSE);
+
+		for (i = 1; path == NULL && i < nr_walkers; i++)
+			path = take_dir(&walkers[(w->id + i) % nr_walkers], TRUE);
+
+		if (path == NULL) {
+			sched_yield();
+			continue;
+		}
+
+		if (shm->exit_reason == STILL_RUNNING)
+			read_dir(w, path);
+		free(path);
+		__sync_fetch_and_sub(&walk_pending, 1);
+	}
+	return NULL;
+}
+
+static void walk_root(const char *dirpath)
+{
+	struct timespec start, end;
+	struct stat sb;
+	unsigned int i;
 	int before = files_added;
-	int flags = FTW_DEPTH | FTW_ACTIONRETVAL | FTW_MOUNT;
-	int ret;
+	long ms;
+
+	nr_walkers = max_walkers;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
 
 	/* By default, don't follow symlinks so we only get each file once.
 	 * But, if we do something like -V /lib, then follow it
 	 *
 	 * I'm not sure about this, might remove later.
 	 */
-	if (victim_path == NULL)
-		flags |= FTW_PHYS;
+	walk_follow = (victim_path != NULL);
 
-	ret = nftw(dirpath, file_tree_callback, 32, flags);
-	if (ret != 0) {
-		if (shm->exit_reason != EXIT_SIGINT)
-			output(0, "Something went wrong during nftw(%s). Returned %d\n", dirpath, ret);
+	if (stat(dirpath, &sb) == -1) {
+		output(0, "Couldn't walk %s: %s\n", dirpath, strerror(errno));
 		return;
 	}
+	walk_dev = sb.st_dev;
+
+	walk_entry(&walkers[0], dirpath, &sb);
 
-	output(0, "Added %d filenames from %s\n", files_added - before, dirpath);
+	for (i = 1; i < nr_walkers; i++) {
+		if (pthread_create(&walkers[i].thread, NULL, walk_thread, &walkers[i]) != 0)
+			break;
+	}
+	nr_walkers = i;
+	walk_thread(&walkers[0]);
+	for (i = 1; i < nr_walkers; i++)
+		pthread_join(walkers[i].thread, NULL);
+
+	files_added = 0;
+	for (i = 0; i < max_walkers; i++)
+		files_added += walkers[i].nr_found;
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	ms = ((end.tv_sec - start.tv_sec) * 1000) + ((end.tv_nsec - start.tv_nsec) / 1000000);
+
+	output(0, "Added %d filenames from %s in %ld.%03lds (%u threads)\n",
+		files_added - before, dirpath, ms / 1000, ms % 1000, nr_walkers);
+}
+
+/* Copy the sorted names into the arena, and seal it. */
+static void build_filename_arena(struct found_file *all, unsigned int n)
+{
+	unsigned long size = 0, off = 0;
+	unsigned int i, len;
+
+	for (i = 0; i < n; i++)
+		size += strlen(all[i].name) + 1;
+
+	filenames = alloc_shared(size);
+	fileindex = alloc_shared(n * sizeof(unsigned int));
+	filemodes = alloc_shared(n * sizeof(unsigned int));
+	if (filenames == NULL || fileindex == NULL || filemodes == NULL) {
+		printf("Couldn't allocate filename arena.\n");
+		exit(EXIT_FAILURE);
+	}
+
+	for (i = 0; i < n; i++) {
+		len = strlen(all[i].name) + 1;
+		memcpy(filenames + off, all[i].name, len);
+		fileindex[i] = off;
+		filemodes[i] = all[i].mode;
+		off += len;
+	}
+	filenames_size = size;
+	files_in_index = n;
+
+	mprotect(filenames, size, PROT_READ);
+	mprotect(fileindex, n * sizeof(unsigned int), PROT_READ);
+	mprotect(filemodes, n * sizeof(unsigned int), PROT_READ);
+}
+
+static bool under(const char *name, const char *dir)
+{
+	size_t len = strlen(dir);
+
+	return (strncmp(name, dir, len) == 0) && (name[len] == '/' || name[len] == '\0');
+}
+
+static unsigned int file_bucket(unsigned int i)
+{
+	const char *name = indexed_filename(i);
+	mode_t mode = filemodes[i];
+	unsigned int root, type;
+
+	if (under(name, "/dev"))
+		root = ROOT_DEV;
+	else if (under(name, "/proc"))
+		root = ROOT_PROC;
+	else if (under(name, "/sys"))
+		root = ROOT_SYS;
+	else
+		root = ROOT_OTHER;
+
+	if (S_ISCHR(mode))
+		type = TYPE_CHR;
+	else if (S_ISBLK(mode))
+		type = TYPE_BLK;
+	else if (S_ISREG(mode))
+		type = TYPE_REG;
+	else if (S_ISDIR(mode))
+		type = TYPE_DIR;
+	else
+		type = TYPE_SPECIAL;
+
+	return (root * NR_TYPES) + type;
+}
+
+static unsigned long bucket_weight(unsigned int bucket)
+{
+	if (buckets[bucket].count == 0)
+		return 0;
+	return root_weights[bucket / NR_TYPES] * type_weights[bucket % NR_TYPES];
+}
+
+static void build_buckets(void)
+{
+	unsigned long total = 0, sofar = 0;
+	unsigned int i, b, slot = 0, end;
+	unsigned int *fill;
+
+	if (files_in_index == 0)
+		return;
+
+	bucket_files = alloc_shared(files_in_index * sizeof(unsigned int));
+	fill = malloc(files_in_index * sizeof(unsigned int));
+	if (bucket_files == NULL || fill == NULL) {
+		free(fill);
+		return;
+	}
+
+	/* Count them, work out where each bucket starts, then drop them in. */
+	for (i = 0; i < files_in_index; i++) {
+		fill[i] = file_bucket(i);
+		buckets[fill[i]].count++;
+	}
+	for (b = 1; b < NR_BUCKETS; b++)
+		buckets[b].start = buckets[b - 1].start + buckets[b - 1].count;
+	for (b = 0; b < NR_BUCKETS; b++)
+		buckets[b].count = 0;
+	for (i = 0; i < files_in_index; i++) {
+		b = fill[i];
+		bucket_files[buckets[b].start + buckets[b].count++] = i;
+	}
+	free(fill);
+	mprotect(bucket_files, files_in_index * sizeof(unsigned int), PROT_READ);
+
+	for (b = 0; b < NR_BUCKETS; b++)
+		total += bucket_weight(b);
+	if (total == 0) {
+		output(0, "All the --file-weights for the files we found are zero, picking from all of them.\n");
+		return;
+	}
+
+	for (b = 0; b < NR_BUCKETS; b++) {
+		if (bucket_weight(b) == 0)
+			continue;
+
+		sofar += bucket_weight(b);
+		end = (sofar * BUCKET_TABLE_SIZE) / total;
+		if (end <= slot)
+			end = slot + 1;	/* everything with a weight gets picked sometimes. */
+		if (end > BUCKET_TABLE_SIZE)
+			end = BUCKET_TABLE_SIZE;
+
+		output(1, "Filename bucket %s/%s: %u files, %u%% of picks.\n",
+			root_names[b / NR_TYPES], type_names[b % NR_TYPES],
+			buckets[b].count, ((end - slot) * 100) / BUCKET_TABLE_SIZE);
+
+		for (; slot < end; slot++)
+			bucket_table[slot] = b;
+	}
+	/* Rounding may have left the last slot or so unset. */
+	for (; slot < BUCKET_TABLE_SIZE; slot++)
+		bucket_table[slot] = bucket_table[slot - 1];
+
+	buckets_ready = TRUE;
+}
+
+/* --file-weights=dev=4,chr=2,... */
+void parse_file_weights(char *arg)
+{
+	char *tok, *saveptr = NULL, *eq;
+	unsigned int i, weight;
+	bool found;
+
+	for (tok = strtok_r(arg, ",", &saveptr); tok != NULL; tok = strtok_r(NULL, ",", &saveptr)) {
+		eq = strchr(tok, '=');
+		if (eq == NULL)
+			goto bad;
+		*eq = '\0';
+		weight = strtoul(eq + 1, NULL, 10);
+
+		found = FALSE;
+		for (i = 0; i < NR_ROOTS; i++) {
+			if (strcmp(tok, root_names[i]) == 0) {
+				root_weights[i] = weight;
+				found = TRUE;
+			}
+		}
+		for (i = 0; i < NR_TYPES; i++) {
+			if (strcmp(tok, type_names[i]) == 0) {
+				type_weights[i] = weight;
+				found = TRUE;
+			}
+		}
+		if (found == FALSE)
+			goto bad;
+	}
+	return;
+
+bad:
+	printf("Bad --file-weights entry '%s'.\n", tok);
+	printf("Use name=weight, where name is one of dev, proc, sys, other (where the file is)\n");
+	printf("or chr, blk, reg, dir, special (what the file is).\n");
+	exit(EXIT_FAILURE);
+}
+
+static int compare_names(const void *a, const void *b)
+{
+	return strcmp(((const struct found_file *) a)->name, ((const struct found_file *) b)->name);
 }
 
 void generate_filelist(void)
 {
-	unsigned int i = 0;
-	struct namelist *node;
+	struct found_file *all;
+	unsigned int i, j, n = 0;
+	long cpus;
 
 	my_uid = getuid();
 	my_gid = getgid();
 
 	output(1, "Generating file descriptors\n");
 
+	compile_file_filters();
+
+	if (load_filecache() == TRUE)
+		goto done;
+
+	cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if (cpus < 1)
+		cpus = 1;
+	if (cpus > MAX_WALKERS)
+		cpus = MAX_WALKERS;
+
+	max_walkers = cpus;
+	for (i = 0; i < max_walkers; i++) {
+		walkers[i].id = i;
+		pthread_mutex_init(&walkers[i].lock, NULL);
+	}
+
 	if (victim_path != NULL) {
-		open_fds(victim_path);
+		walk_root(victim_path);
 	} else {
-		open_fds("/dev");
-		open_fds("/proc");
-		open_fds("/sys");
+		walk_root("/dev");
+		walk_root("/proc");
+		walk_root("/sys");
 	}
 
 	if (files_added == 0) {
@@ -249,20 +677,63 @@ void generate_filelist(void)
 		return;
 
 	/*
-	 * Generate an index of pointers to the filenames
+	 * Generate an index of pointers to the filenames.
+	 * The walkers find things in whatever order they get to them,
+	 * so sort it, or the same seed wouldn't pick the same files.
 	 */
-	fileindex = malloc(sizeof(char *) * files_added);
-
-	node = names;
-	do {
-		fileindex[i++] = node->name;
-		node = node->next;
-	} while (node->next != names);
-	files_in_index = i;
+	all = malloc(sizeof(struct found_file) * files_added);
+	if (all == NULL)
+		exit(EXIT_FAILURE);
+
+	for (i = 0; i < max_walkers; i++) {
+		for (j = 0; j < walkers[i].nr_found; j++)
+			all[n++] = walkers[i].found[j];
+	}
+
+	qsort(all, n, sizeof(struct found_file), compare_names);
+	build_filename_arena(all, n);
+
+	free(all);
+	for (i = 0; i < max_walkers; i++) {
+		free_names(&walkers[i]);
+		free(walkers[i].found);
+		free(walkers[i].dirs);
+		pthread_mutex_destroy(&walkers[i].lock);
+	}
+	free(visited);
+
+	save_filecache();
+done:
+	output(1, "Filename arena: %u names in %luKB, plus %luKB of index.\n",
+		files_in_index, filenames_size / 1024,
+		(files_in_index * 2 * sizeof(unsigned int)) / 1024);
+
+	dead_files = alloc_shared((files_in_index / 8) + 1);
+
+	build_buckets();
+}
+
+static unsigned int pick_filename(void)
+{
+	struct bucket *b;
+	unsigned int i, tries;
+
+	for (tries = 0; tries < 10; tries++) {
+		if (buckets_ready == TRUE) {
+			b = &buckets[bucket_table[rnd_below(BUCKET_TABLE_SIZE)]];
+			i = bucket_files[b->start + rnd_below(b->count)];
+		} else
+			i = rnd_below(files_in_index);
+
+		if (dead_files == NULL || !(dead_files[i / 8] & (1 << (i % 8))))
+			break;
+	}
+	return i;
 }
 
 static int open_file(void)
 {
+	unsigned int i;
 	int fd;
 	int ret;
 	char *filename;
@@ -271,10 +742,14 @@ static int open_file(void)
 	struct stat sb;
 
 retry:
-	filename = get_filename();
+	i = pick_filename();
+	filename = indexed_filename(i);
 	ret = lstat(filename, &sb);
-	if (ret == -1)
+	if (ret == -1) {
+		if (errno == ENOENT || errno == ESRCH)
+			__sync_fetch_and_or(&dead_files[i / 8], 1 << (i % 8));
 		goto retry;
+	}
 
 	flags = check_stat_file(&sb);
 	if (flags == -1)
@@ -313,28 +788,24 @@ void open_files(void)
 	for (i = 0; i < nr_to_open; i++) {
 		fd = open_file();
 
-		shm->file_fds[i] = fd;
+		set_file_fd(i, fd);
 		nr_file_fds++;
 	}
 }
 
-void close_files(void)
+/* Open something new for this pool slot before letting go of what was there. */
+bool replace_file_fd(unsigned int slot)
 {
-	unsigned int i;
-	int fd;
-
-	shm->current_fd = 0;
-	shm->fd_lifetime = 0;
+	int fd, old = file_fds[slot];
 
-	// FIXME: Does this need locking? At the least, check for NULL fd's
-	for (i = 0; i < nr_file_fds; i++) {
-		fd = shm->file_fds[i];
-		shm->file_fds[i] = 0;
-		if (fd != 0)
-			close(fd);
-	}
+	fd = open_file();
+	if (fd < 0)
+		return FALSE;
 
-	nr_file_fds = 0;
+	set_file_fd(slot, fd);
+	if (old > 0)
+		close(old);
+	return TRUE;
 }
 
 char * get_filename(void)
@@ -342,7 +813,7 @@ char * get_filename(void)
 	if (files_in_index == 0)	/* This can happen if we run with -n. Should we do something else ? */
 		return NULL;
 
-	return fileindex[rand() % files_in_index];
+	return indexed_filename(pick_filename());
 }
 
 char * generate_pathname(void)
@@ -357,12 +828,12 @@ char * generate_pathname(void)
 
 	len = strlen(pathname);
 
-	chance = rand() % 100;
+	chance = rnd_below(100);
 	switch (chance) {
 
 	case 0 ... 90:
 		/* 90% chance of returning an unmangled filename */
-		if ((rand() % 100) > 10)
+		if (rnd_below(100) > 10)
 			return get_filename();
 
 	case 91 ... 99:
@@ -374,11 +845,11 @@ char * generate_pathname(void)
 		generate_random_page(newpath);
 
 		/* sometimes, just complete junk. */
-		if (rand() % 2)
+		if (rnd_below(2))
 			goto out;
 
 		/* Sometimes, pathname + junk */
-		if (rand() % 2)
+		if (rnd_below(2))
 			(void) strncpy(newpath, pathname, len);
 		else {
 			/* make it look relative to cwd */
@@ -387,15 +858,15 @@ char * generate_pathname(void)
 		}
 
 		/* Sometimes, remove all /'s */
-		if ((rand() % 2) == 0) {
+		if (rnd_below(2) == 0) {
 			for (i = 0; i < len; i++) {
 				if (newpath[i] == '/')
-					newpath[i] = rand();
+					newpath[i] = rnd();
 			}
 		}
 out:
 		/* 50/50 chance of making it look like a dir */
-		if ((rand() % 2) == 0) {
+		if (rnd_below(2) == 0) {
 			newpath[len] = '/';
 			newpath[len + 1] = 0;
 		}
@@ -0,0 +1,311 @@
+/*
+ * Which paths the file walk leaves out.
+ *
+ * The rules are globs (*, ?, [a-z], [!a-z], \x). A rule with a '/' in it
+ * has to match the whole path, one without has to match the last component,
+ * so "tty*" skips every tty wherever it is. A rule ending in '/' matches a
+ * directory, and we don't walk into it at all.
+ *
+ * All the rules get compiled into one NFA, with one state per glob token,
+ * which we run over the path with a bitmap of live states. So each path is
+ * looked at once, however many rules there are.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "trinity.h"
+#include "files.h"
+#include "log.h"
+
+/* dangerous/noisy/annoying stuff in /proc and /dev, and per-process stuff. */
+static const char *builtin_filters[] = {
+	"/proc/sysrq-trigger", "/proc/kmem", "/proc/kcore",
+	"/dev/log", "/dev/mem", "/dev/kmsg",
+	"coredump_filter", "make-it-fail", "oom_adj", "oom_score_adj",
+	"tty*",
+	NULL
+};
+
+#define MAX_USER_FILTERS 64
+static char *user_filters[MAX_USER_FILTERS];
+static unsigned int nr_user_filters = 0;
+
+#define MAX_FILTER_STATES 1024
+#define STATE_WORDS (MAX_FILTER_STATES / 64)
+
+struct stateset {
+	uint64_t w[STATE_WORDS];
+};
+
+/* Which states can move on when they see each character. */
+static struct stateset step_on[256];
+/* '*' states, which stay where they are when they match. */
+static struct stateset star_states;
+/* Where whole-path rules start, and where last-component rules start. */
+static struct stateset path_starts;
+static struct stateset name_starts;
+/* The state after the last token of each rule, and what that rule does. */
+static struct stateset accept_ignore;
+static struct stateset accept_prune;
+
+static unsigned int nr_states = 0;
+static unsigned int nr_words = 0;
+static unsigned int filters_hash = 0;
+
+static void set_state(struct stateset *s, unsigned int state)
+{
+	s->w[state / 64] |= 1ULL << (state % 64);
+}
+
+static void shift_up(struct stateset *dst, const struct stateset *src)
+{
+	unsigned int i;
+	uint64_t carry = 0, w;
+
+	for (i = 0; i < nr_words; i++) {
+		w = src->w[i];
+		dst->w[i] = (w << 1) | carry;
+		carry = w >> 63;
+	}
+}
+
+/* A '*' can match nothing, so being at one means also being past it. */
+static void skip_stars(struct stateset *s)
+{
+	struct stateset t;
+	unsigned int i;
+	bool changed = TRUE;
+
+	while (changed == TRUE) {
+		changed = FALSE;
+		for (i = 0; i < nr_words; i++)
+			t.w[i] = s->w[i] & star_states.w[i];
+		shift_up(&t, &t);
+		for (i = 0; i < nr_words; i++) {
+			if ((t.w[i] & ~s->w[i]) != 0)
+				changed = TRUE;
+			s->w[i] |= t.w[i];
+		}
+	}
+}
+
+static void too_complex(void)
+{
+	printf("The file filters are too complicated, simplify them.\n");
+	exit(EXIT_FAILURE);
+}
+
+/* Parse a [...] class starting at *p, mark the characters it matches as moving on from state. */
+static const char * compile_class(const char *p, unsigned int state)
+{
+	bool negate = FALSE;
+	unsigned char matches[256];
+	unsigned int c, lo, hi;
+	const char *start;
+
+	memset(matches, 0, sizeof(matches));
+
+	p++;
+	if (*p == '!' || *p == '^') {
+		negate = TRUE;
+		p++;
+	}
+	start = p;
+
+	while (*p != '\0' && (*p != ']' || p == start)) {
+		lo = hi = (unsigned char) *p++;
+		if (*p == '-' && p[1] != ']' && p[1] != '\0') {
+			hi = (unsigned char) p[1];
+			p += 2;
+		}
+		for (c = lo; c <= hi; c++)
+			matches[c] = 1;
+	}
+	if (*p == ']')
+		p++;
+
+	for (c = 1; c < 256; c++) {
+		if (c == '/')
+			continue;
+		if (matches[c] != negate)
+			set_state(&step_on[c], state);
+	}
+	return p;
+}
+
+static void compile_filter(const char *glob)
+{
+	const char *p = glob;
+	unsigned int first = nr_states;
+	unsigned int c;
+	bool prune = FALSE;
+	size_t len = strlen(glob);
+
+	if (len == 0)
+		return;
+
+	if (len > 1 && glob[len - 1] == '/')
+		prune = TRUE;
+
+	if (strchr(glob, '/') != NULL && (prune == FALSE || strchr(glob, '/') != glob + len - 1))
+		set_state(&path_starts, first);
+	else
+		set_state(&name_starts, first);
+
+	while (*p != '\0') {
+		if (prune == TRUE && p == glob + len - 1)
+			break;
+
+		if (nr_states + 1 >= MAX_FILTER_STATES)
+			too_complex();
+
+		switch (*p) {
+		case '*':
+			set_state(&star_states, nr_states);
+			for (c = 1; c < 256; c++) {
+				if (c != '/')
+					set_state(&step_on[c], nr_states);
+			}
+			p++;
+			break;
+		case '?':
+			for (c = 1; c < 256; c++) {
+				if (c != '/')
+					set_state(&step_on[c], nr_states);
+			}
+			p++;
+			break;
+		case '[':
+			p = compile_class(p, nr_states);
+			break;
+		case '\\':
+			if (p[1] != '\0')
+				p++;
+			/* fallthrough */
+		default:
+			set_state(&step_on[(unsigned char) *p], nr_states);
+			p++;
+			break;
+		}
+		nr_states++;
+	}
+
+	if (prune == TRUE)
+		set_state(&accept_prune, nr_states);
+	else
+		set_state(&accept_ignore, nr_states);
+	nr_states++;
+
+	/* Enough to tell a cache made with different filters from ours. */
+	for (p = glob; *p != '\0'; p++)
+		filters_hash = (filters_hash * 31) + (unsigned char) *p;
+	filters_hash = (filters_hash * 31) + (prune ? 2 : 1);
+}
+
+/* --filter-files=glob, or --filter-files=@file with one glob per line. */
+void add_file_filter(const char *arg)
+{
+	char line[4096];
+	FILE *fp;
+	size_t len;
+
+	if (arg[0] != '@') {
+		if (nr_user_filters == MAX_USER_FILTERS) {
+			printf("Too many --filter-files, the most is %d.\n", MAX_USER_FILTERS);
+			exit(EXIT_FAILURE);
+		}
+		user_filters[nr_user_filters++] = strdup(arg);
+		return;
+	}
+
+	fp = fopen(arg + 1, "r");
+	if (fp == NULL) {
+		printf("Couldn't open filter list %s.\n", arg + 1);
+		exit(EXIT_FAILURE);
+	}
+
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		len = strlen(line);
+		while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == ' '))
+			line[--len] = '\0';
+		if (len == 0 || line[0] == '#')
+			continue;
+		add_file_filter(line);
+	}
+	fclose(fp);
+}
+
+void compile_file_filters(void)
+{
+	unsigned int i;
+
+	if (nr_states != 0)
+		return;
+
+	for (i = 0; builtin_filters[i]; i++)
+		compile_filter(builtin_filters[i]);
+	for (i = 0; i < nr_user_filters; i++) {
+		compile_filter(user_filters[i]);
+		output(1, "Leaving out files matching %s\n", user_filters[i]);
+	}
+
+	nr_words = (nr_states + 63) / 64;
+}
+
+unsigned int file_filters_hash(void)
+{
+	return filters_hash;
+}
+
+/* Returns FILTER_IGNORE and/or FILTER_PRUNE, or 0 if nothing matched. */
+unsigned int match_file_filters(const char *path)
+{
+	struct stateset live, next;
+	const unsigned char *p;
+	unsigned int i, ret = 0;
+
+	live = path_starts;
+	for (i = 0; i < nr_words; i++)
+		live.w[i] |= name_starts.w[i];
+	skip_stars(&live);
+
+	for (p = (const unsigned char *) path; *p != '\0'; p++) {
+		const struct stateset *step = &step_on[*p];
+		uint64_t any = 0;
+
+		for (i = 0; i < nr_words; i++) {
+			next.w[i] = live.w[i] & step->w[i] & ~star_states.w[i];
+			live.w[i] &= step->w[i] & star_states.w[i];
+		}
+		shift_up(&next, &next);
+		for (i = 0; i < nr_words; i++)
+			live.w[i] |= next.w[i];
+
+		/* A new path component, last-component rules get another go. */
+		if (*p == '/') {
+			for (i = 0; i < nr_words; i++)
+				live.w[i] |= name_starts.w[i];
+		}
+		skip_stars(&live);
+
+		/* Nothing left alive, so nothing can match before the next '/'. */
+		for (i = 0; i < nr_words; i++)
+			any |= live.w[i];
+		if (any == 0) {
+			p = (const unsigned char *) strchr((const char *) p + 1, '/');
+			if (p == NULL)
+				return 0;
+			p--;
+		}
+	}
+
+	for (i = 0; i < nr_words; i++) {
+		if (live.w[i] & accept_ignore.w[i])
+			ret |= FILTER_IGNORE;
+		if (live.w[i] & accept_prune.w[i])
+			ret |= FILTER_PRUNE | FILTER_IGNORE;
+	}
+	return ret;
+}
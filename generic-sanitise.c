@@ -13,16 +13,20 @@
 #include "log.h"
 #include "maps.h"
 #include "shm.h"
+#include "params.h"	// sockaddr_mismatch
+#include "harvest.h"
+#include "fdinfo.h"
+#include "blocking.h"
 
 static unsigned int get_cpu(void)
 {
 	int i;
-	i = rand() % 3;
+	i = rnd_below(3);
 
 	switch (i) {
 	case 0: return -1;
-	case 1: return rand() & 4095;
-	case 2: return rand() & 15;
+	case 1: return rnd() & 4095;
+	case 2: return rnd() & 15;
 	default:
 		BUG("unreachable!\n");
 		break;
@@ -31,8 +35,48 @@ static unsigned int get_cpu(void)
 }
 
 
-static unsigned long fill_arg(int childno, int call, int argnum)
+static bool takes_sockaddr(struct syscall *entry)
 {
+	return (entry->arg2type == ARG_SOCKADDR || entry->arg3type == ARG_SOCKADDR ||
+		entry->arg4type == ARG_SOCKADDR || entry->arg5type == ARG_SOCKADDR ||
+		entry->arg6type == ARG_SOCKADDR);
+}
+
+static int get_fd_arg(int call, enum argtype argtype, bool mismatch)
+{
+	struct socketinfo *si;
+	unsigned long i;
+	int fd;
+
+	if (argtype == ARG_FD)
+		goto any_fd;
+
+	/* Anything that takes a sockaddr wants a socket to go with it, from any family equally. */
+	if (argtype == ARG_FD_SOCKET && takes_sockaddr(syscalls[call].entry)) {
+		if (mismatch == TRUE)
+			goto any_fd;
+		si = get_random_socket();
+		if (si != NULL)
+			return si->fd;
+	}
+
+	fd = get_typed_fd(argtype);
+	if (fd != -1)
+		return fd;
+
+any_fd:
+	if (get_harvested(HARVEST_FD, &i) == TRUE)
+		return i;
+	return get_random_fd();
+}
+
+/*
+ * mismatch is for syscalls that take a sockaddr: if set, the socket and the
+ * address both get picked without regard for each other (see --sockaddr-mismatch).
+ */
+static unsigned long fill_arg(int childno, int call, int argnum, bool mismatch)
+{
+	struct childdata *child = &shm->children[childno];
 	unsigned long i;
 	unsigned long mask = 0;
 	unsigned long low = 0, high = 0;
@@ -44,6 +88,7 @@ static unsigned long fill_arg(int childno, int call, int argnum)
 	unsigned long sockaddr = 0, sockaddrlen = 0;
 	unsigned int bit, j, count;
 	mode_t mode = 0;
+	int fd;
 
 	switch (argnum) {
 	case 1:	argtype = syscalls[call].entry->arg1type;
@@ -69,13 +114,27 @@ static unsigned long fill_arg(int childno, int call, int argnum)
 		return (unsigned long) rand64();
 
 	case ARG_FD:
-		return get_random_fd();
+	case ARG_FD_SOCKET:
+	case ARG_FD_DIR:
+	case ARG_FD_EPOLL:
+	case ARG_FD_TIMERFD:
+	case ARG_FD_INOTIFY:
+	case ARG_FD_FANOTIFY:
+	case ARG_FD_IOCTL:
+		/* Try not to hand out fds that keep blocking this syscall. */
+		for (j = 0; j < 3; j++) {
+			fd = get_fd_arg(call, argtype, mismatch);
+			if (fd_blocks(fd, call, child->do32bit) == FALSE)
+				break;
+			drop_sticky_fd();
+		}
+		return fd;
 
 	case ARG_LEN:
 		return (unsigned long) get_len();
 
 	case ARG_ADDRESS:
-		if ((rand() % 2) == 0)
+		if (rnd_below(2) == 0)
 			return (unsigned long) get_address();
 
 		/* Half the time, we look to see if earlier args were also ARG_ADDRESS,
@@ -83,7 +142,7 @@ static unsigned long fill_arg(int childno, int call, int argnum)
 
 		addr = find_previous_arg_address(argnum, call, childno);
 
-		switch (rand() % 4) {
+		switch (rnd_below(4)) {
 		case 0:	break;	/* return unmodified */
 		case 1:	addr++;
 			break;
@@ -101,6 +160,8 @@ static unsigned long fill_arg(int childno, int call, int argnum)
 		return (unsigned long) get_non_null_address();
 
 	case ARG_PID:
+		if (get_harvested(HARVEST_PID, &i) == TRUE)
+			return i;
 		return (unsigned long) get_pid();
 
 	case ARG_RANGE:
@@ -163,7 +224,7 @@ static unsigned long fill_arg(int childno, int call, int argnum)
 			break;
 		default: break;
 		}
-		mask |= values[rand() % num];
+		mask |= values[rnd_below(num)];
 		return mask;
 
 	case ARG_LIST:
@@ -188,13 +249,13 @@ static unsigned long fill_arg(int childno, int call, int argnum)
 			break;
 		default: break;
 		}
-		bits = rand() % num;	/* num of bits to OR */
+		bits = rnd_below(num);	/* num of bits to OR */
 		for (i=0; i<bits; i++)
-			mask |= values[rand() % num];
+			mask |= values[rnd_below(num)];
 		return mask;
 
 	case ARG_RANDPAGE:
-		if ((rand() % 2) == 0)
+		if (rnd_below(2) == 0)
 			return (unsigned long) page_allocs;
 		else
 			return (unsigned long) page_rand;
@@ -206,23 +267,23 @@ static unsigned long fill_arg(int childno, int call, int argnum)
 		return (unsigned long) generate_pathname();
 
 	case ARG_IOVEC:
-		i = (rand() % 5) + 1;
+		i = rnd_below(5) + 1;
 
 		switch (argnum) {
 		case 1:	if (syscalls[call].entry->arg2type == ARG_IOVECLEN)
-				shm->a2[childno] = i;
+				child->a2 = i;
 			break;
 		case 2:	if (syscalls[call].entry->arg3type == ARG_IOVECLEN)
-				shm->a3[childno] = i;
+				child->a3 = i;
 			break;
 		case 3:	if (syscalls[call].entry->arg4type == ARG_IOVECLEN)
-				shm->a4[childno] = i;
+				child->a4 = i;
 			break;
 		case 4:	if (syscalls[call].entry->arg5type == ARG_IOVECLEN)
-				shm->a5[childno] = i;
+				child->a5 = i;
 			break;
 		case 5:	if (syscalls[call].entry->arg6type == ARG_IOVECLEN)
-				shm->a6[childno] = i;
+				child->a6 = i;
 			break;
 		default: BUG("impossible\n");
 		}
@@ -231,34 +292,38 @@ static unsigned long fill_arg(int childno, int call, int argnum)
 	case ARG_IOVECLEN:
 	case ARG_SOCKADDRLEN:
 		switch (argnum) {
-		case 1:	return(shm->a1[childno]);
-		case 2:	return(shm->a2[childno]);
-		case 3:	return(shm->a3[childno]);
-		case 4:	return(shm->a4[childno]);
-		case 5:	return(shm->a5[childno]);
-		case 6:	return(shm->a6[childno]);
+		case 1:	return(child->a1);
+		case 2:	return(child->a2);
+		case 3:	return(child->a3);
+		case 4:	return(child->a4);
+		case 5:	return(child->a5);
+		case 6:	return(child->a6);
 		default: break;
 		}
 		;; // fallthrough
 
 	case ARG_SOCKADDR:
-		generate_sockaddr(&sockaddr, &sockaddrlen, PF_NOHINT);
+		/* The socket is always the first arg of the syscalls that take a sockaddr. */
+		if (mismatch == FALSE && is_fd_argtype(syscalls[call].entry->arg1type) == TRUE)
+			generate_sockaddr(&sockaddr, &sockaddrlen, sockaddr_hint(child->a1));
+		else
+			generate_sockaddr(&sockaddr, &sockaddrlen, PF_NOHINT);
 
 		switch (argnum) {
 		case 1:	if (syscalls[call].entry->arg2type == ARG_SOCKADDRLEN)
-				shm->a2[childno] = sockaddrlen;
+				child->a2 = sockaddrlen;
 			break;
 		case 2:	if (syscalls[call].entry->arg3type == ARG_SOCKADDRLEN)
-				shm->a3[childno] = sockaddrlen;
+				child->a3 = sockaddrlen;
 			break;
 		case 3:	if (syscalls[call].entry->arg4type == ARG_SOCKADDRLEN)
-				shm->a4[childno] = sockaddrlen;
+				child->a4 = sockaddrlen;
 			break;
 		case 4:	if (syscalls[call].entry->arg5type == ARG_SOCKADDRLEN)
-				shm->a5[childno] = sockaddrlen;
+				child->a5 = sockaddrlen;
 			break;
 		case 5:	if (syscalls[call].entry->arg6type == ARG_SOCKADDRLEN)
-				shm->a6[childno] = sockaddrlen;
+				child->a6 = sockaddrlen;
 			break;
 		case 6:
 		default: BUG("impossible\n");
@@ -266,12 +331,12 @@ static unsigned long fill_arg(int childno, int call, int argnum)
 		return (unsigned long) sockaddr;
 
 	case ARG_MODE_T:
-		count = rand() % 9;
+		count = rnd_below(9);
 
 		for (i = 0; i < count; i++) {
-			bit = rand() % 3;
+			bit = rnd_below(3);
 			mode |= 1 << bit;
-			j = rand() % 12;
+			j = rnd_below(12);
 			switch (j) {
 			case 0: mode |= S_IRUSR; break;
 			case 1: mode |= S_IWUSR; break;
@@ -301,18 +366,24 @@ static unsigned long fill_arg(int childno, int call, int argnum)
 
 void generic_sanitise(int childno)
 {
-	unsigned int call = shm->syscallno[childno];
+	struct childdata *child = &shm->children[childno];
+	unsigned int call = child->syscallno;
+	bool mismatch = FALSE;
+
+	/* Once per call, so the fd and the address don't get a roll each. */
+	if (takes_sockaddr(syscalls[call].entry) && rnd_below(100) < sockaddr_mismatch)
+		mismatch = TRUE;
 
 	if (syscalls[call].entry->arg1type != 0)
-		shm->a1[childno] = fill_arg(childno, call, 1);
+		child->a1 = fill_arg(childno, call, 1, mismatch);
 	if (syscalls[call].entry->arg2type != 0)
-		shm->a2[childno] = fill_arg(childno, call, 2);
+		child->a2 = fill_arg(childno, call, 2, mismatch);
 	if (syscalls[call].entry->arg3type != 0)
-		shm->a3[childno] = fill_arg(childno, call, 3);
+		child->a3 = fill_arg(childno, call, 3, mismatch);
 	if (syscalls[call].entry->arg4type != 0)
-		shm->a4[childno] = fill_arg(childno, call, 4);
+		child->a4 = fill_arg(childno, call, 4, mismatch);
 	if (syscalls[call].entry->arg5type != 0)
-		shm->a5[childno] = fill_arg(childno, call, 5);
+		child->a5 = fill_arg(childno, call, 5, mismatch);
 	if (syscalls[call].entry->arg6type != 0)
-		shm->a6[childno] = fill_arg(childno, call, 6);
+		child->a6 = fill_arg(childno, call, 6, mismatch);
 }
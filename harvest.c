@@ -0,0 +1,163 @@
+/*
+ * Things syscalls hand back (fds, pids, key serials) that later syscalls
+ * can be given, so they get to work on objects the child just made and
+ * not only on the fds everyone got at startup.
+ *
+ * Each child has its own pools, as an fd only means something in the
+ * process that opened it. mkcall() fills them, and they go away when the
+ * child exits. When a pool is full, the oldest entry makes room (and gets
+ * closed, if it's an fd).
+ */
+#include <errno.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "trinity.h"
+#include "constants.h"
+#include "harvest.h"
+#include "fdinfo.h"
+#include "files.h"
+#include "params.h"	// harvest_rate
+#include "random.h"
+
+struct harvested {
+	unsigned long value;
+	struct syscall *from;	/* what made it */
+	unsigned long seq;	/* when, so the oldest can make room */
+};
+
+/* Entries get removed from the middle, so they aren't kept in any order. */
+struct harvest_pool {
+	struct harvested entries[HARVEST_POOL_SIZE];
+	unsigned int nr;
+	unsigned long next_seq;
+};
+
+static struct harvest_pool pools[NR_HARVEST_TYPES];
+
+static struct harvested * oldest_harvested(struct harvest_pool *pool)
+{
+	struct harvested *oldest = &pool->entries[0];
+	unsigned int i;
+
+	for (i = 1; i < pool->nr; i++) {
+		if (pool->entries[i].seq < oldest->seq)
+			oldest = &pool->entries[i];
+	}
+	return oldest;
+}
+
+static void add_harvested(enum harvest_type type, unsigned long value, struct syscall *from)
+{
+	struct harvest_pool *pool = &pools[type];
+	struct harvested *h;
+	unsigned int i;
+
+	/* The kernel hands out the same numbers again once they're closed. */
+	for (i = 0; i < pool->nr; i++) {
+		if (pool->entries[i].value == value) {
+			h = &pool->entries[i];
+			goto found;
+		}
+	}
+
+	if (pool->nr < HARVEST_POOL_SIZE) {
+		h = &pool->entries[pool->nr++];
+	} else {
+		h = oldest_harvested(pool);
+		if (type == HARVEST_FD) {
+			unregister_fd(h->value);
+			forget_closed_fd(h->value);
+			close(h->value);
+		}
+	}
+
+	h->value = value;
+found:
+	h->from = from;
+	h->seq = pool->next_seq++;
+
+	if (type == HARVEST_FD)
+		register_fd(value);
+}
+
+static void remove_harvested(enum harvest_type type, unsigned int i)
+{
+	struct harvest_pool *pool = &pools[type];
+
+	pool->nr--;
+	pool->entries[i] = pool->entries[pool->nr];
+}
+
+/*
+ * getppid, getpgrp and getpgid hand back main, the group trinity was started
+ * in, or whatever else getpgid was pointed at, and harvested pids end up as
+ * the target of kill, prlimit64, process_vm_writev and so on. So only keep
+ * our own pid, and children we forked ourselves (waitid fails with ECHILD
+ * for anything else, and WNOWAIT leaves it for whoever reaps it).
+ */
+static bool is_our_pid(pid_t pid)
+{
+	siginfo_t info;
+
+	if (pid == getpid())
+		return TRUE;
+
+	if (waitid(P_PID, pid, &info, WEXITED | WSTOPPED | WNOHANG | WNOWAIT) == 0)
+		return TRUE;
+	return FALSE;
+}
+
+/* Called by mkcall() after every successful syscall. */
+void harvest_result(struct syscall *entry, unsigned long ret)
+{
+	switch (entry->rettype) {
+	case RET_FD:
+		/* dup2(fd, fd) and friends can hand back one of the shared fds. */
+		if ((int) ret < 0 || is_shared_fd(ret) == TRUE)
+			return;
+		add_harvested(HARVEST_FD, ret, entry);
+		break;
+
+	case RET_PID_T:
+		if ((pid_t) ret <= 0 || is_our_pid(ret) == FALSE)
+			return;
+		add_harvested(HARVEST_PID, ret, entry);
+		break;
+
+	case RET_KEY_SERIAL_T:
+		add_harvested(HARVEST_KEY, ret, entry);
+		break;
+
+	default:
+		break;
+	}
+}
+
+/* Some of the time (see --harvest-rate), something we made earlier. */
+bool get_harvested(enum harvest_type type, unsigned long *value)
+{
+	struct harvest_pool *pool = &pools[type];
+	struct harvested *h;
+
+	if (pool->nr == 0 || rnd_below(100) >= harvest_rate)
+		return FALSE;
+
+	h = &pool->entries[rnd_below(pool->nr)];
+	*value = h->value;
+	return TRUE;
+}
+
+/* Something (probably a fuzzed close) already got rid of this one. */
+void forget_harvested_fd(int fd)
+{
+	struct harvest_pool *pool = &pools[HARVEST_FD];
+	unsigned int i;
+
+	for (i = 0; i < pool->nr; i++) {
+		if (pool->entries[i].value == (unsigned long) fd) {
+			remove_harvested(HARVEST_FD, i);
+			return;
+		}
+	}
+}
@@ -9,6 +9,8 @@
 #define PTE_RPN_SHIFT		(PAGE_SHIFT)
 #define PTE_FILE_MAX_BITS	(BITS_PER_LONG - PTE_RPN_SHIFT)
 
+#define CACHELINE_SIZE		128
+
 #else /* __powerpc64__ */
 
 #define KERNEL_ADDR		0xc0000000
@@ -41,6 +41,10 @@
 #define SYSCALL_OFFSET 0
 #endif
 
+#ifndef CACHELINE_SIZE
+#define CACHELINE_SIZE 64
+#endif
+
 #define PAGE_MASK (~(page_size - 1))
 extern unsigned int page_size;
 
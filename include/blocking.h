@@ -0,0 +1,23 @@
+#ifndef _BLOCKING_H
+#define _BLOCKING_H 1
+
+#include <sys/types.h>
+#include "types.h"
+
+/* One (file, syscall) that hit the alarm. Lives in shm, see blocking.c */
+struct blocking_fd {
+	dev_t dev;
+	ino_t ino;
+	unsigned int call;		/* syscallno, | BLOCKING_32BIT */
+	unsigned int timeouts;		/* 0 means the slot is free */
+	unsigned int avoided;		/* times we picked another fd instead */
+	char name[48];
+};
+
+#define BLOCKING_32BIT	(1U << 31)
+
+void note_syscall_timeout(int childno);
+bool fd_blocks(int fd, unsigned int call, bool do32bit);
+void dump_blocking_fds(void);
+
+#endif	/* _BLOCKING_H */
@@ -2,6 +2,66 @@
 #define _CHILD_H 1
 
 #include <sys/types.h>
+#include <sys/time.h>
+
+#include "arch.h"
+#include "types.h"
+
+/*
+ * Everything a child writes on each syscall lives in its own record,
+ * aligned so that neighbouring children never share a cacheline.
+ */
+struct childdata {
+	/* state for the syscall currently in progress. */
+	unsigned long a1;
+	unsigned long a2;
+	unsigned long a3;
+	unsigned long a4;
+	unsigned long a5;
+	unsigned long a6;
+	unsigned int syscallno;
+	bool do32bit;
+
+	/* state for the previous syscall, for debugging. */
+	unsigned int previous_syscallno;
+	unsigned long previous_a1;
+	unsigned long previous_a2;
+	unsigned long previous_a3;
+	unsigned long previous_a4;
+	unsigned long previous_a5;
+	unsigned long previous_a6;
+
+	unsigned long syscall_count;
+	struct timeval tv;
+
+	/* when the last child in this slot was reaped, for respawn latency. */
+	struct timeval reaped_at;
+
+	/* set by main when it asks the zygote for a child for this slot. */
+	time_t spawn_requested;
+
+	/*
+	 * Running totals for this slot. Unlike syscall_count these survive
+	 * the child being replaced, so summing them across all slots gives
+	 * the totals for the whole run. Only the owning child writes them.
+	 */
+	unsigned long total_syscalls;
+	unsigned long successes;
+	unsigned long failures;
+
+	/* took an -N ticket for a syscall that hasn't been counted yet. */
+	bool holds_ticket;
+
+	/*
+	 * The seed this slot is using, and how many syscalls into its random
+	 * stream it is. Together with the pidslot, that's all it takes to
+	 * regenerate the randomness for any given syscall (see seed_syscall()).
+	 */
+	unsigned int seed;
+	unsigned long stream_pos;
+} __attribute__((aligned(CACHELINE_SIZE)));
+
+extern int this_child;
 
 int child_process(int childno);
 long mkcall(int child);
@@ -15,4 +75,7 @@ void check_parent_pid(void);
 
 int do_random_syscalls(int childno);
 
+unsigned long total_syscalls_done(void);
+void total_syscall_results(unsigned long *successes, unsigned long *failures);
+
 #endif	/* _CHILD_H */
@@ -3,10 +3,28 @@
 
 #define MAX_NR_CHILDREN 64
 
-#define MAX_PIPE_FDS 4
+/* both ends of 16 pipes, see pipes.c */
+#define MAX_PIPE_FDS 32
 #define NR_SOCKET_FDS 375
 #define NR_FILE_FDS 250
 
 #define REGENERATION_POINT 100000
 
+/* replace one file fd every this many syscalls, at most FD_ROLL_MAX a second. */
+#define FD_ROLL_SYSCALLS (REGENERATION_POINT / NR_FILE_FDS)
+#define FD_ROLL_MAX 64
+/* an fd that fails this many times in a row gets replaced first. */
+#define FD_ERROR_STREAK 32
+
+/* a child keeps giving the same fd to syscalls for up to this many syscalls (plus 5). */
+#define FD_STICKY_SYSCALLS 20
+/* how many recently successful fds each child remembers, see --fd-success-bias */
+#define FD_GOOD_MAX 16
+
+/* how many fds/pids/keys each child keeps from what syscalls returned. */
+#define HARVEST_POOL_SIZE 32
+
+/* how many (file, syscall) pairs that blocked we remember, see blocking.c */
+#define NR_BLOCKING_FDS 256
+
 #endif	/* _CONSTANTS_H */
@@ -0,0 +1,42 @@
+#ifndef _FDINFO_H
+#define _FDINFO_H 1
+
+#include <sys/types.h>
+#include "syscall.h"
+#include "types.h"
+
+/* fds above this aren't tracked. */
+#define FD_SLOT_MAX 1024
+
+enum fd_kind {
+	FD_KIND_OTHER,
+	FD_KIND_REG,
+	FD_KIND_DIR,
+	FD_KIND_CHR,
+	FD_KIND_BLK,
+	FD_KIND_SOCKET,
+	FD_KIND_PIPE,
+	FD_KIND_EPOLL,
+	FD_KIND_EVENTFD,
+	FD_KIND_TIMERFD,
+	FD_KIND_SIGNALFD,
+	FD_KIND_INOTIFY,
+	FD_KIND_FANOTIFY,
+	FD_KIND_PERF,
+	NR_FD_KINDS,
+};
+
+struct ioctl_group;
+
+void register_fd(int fd);
+void unregister_fd(int fd);
+enum fd_kind get_fd_kind(int fd);
+int get_fd_flags(int fd);
+bool get_fd_identity(int fd, dev_t *dev, ino_t *ino);
+bool is_anon_inode_fd(int fd);
+const struct ioctl_group * get_fd_ioctl_group(int fd);
+bool is_fd_argtype(enum argtype type);
+int get_typed_fd(enum argtype type);
+void dump_fd_kinds(void);
+
+#endif	/* _FDINFO_H */
@@ -1,17 +1,45 @@
 #include "constants.h"
 #include <sys/stat.h>
+#include "types.h"
 
 void setup_fds(void);
+void open_pipes(void);
+void stop_pipes(void);
+int get_pipe_reader(void);
+int get_pipe_writer(void);
 
 void generate_filelist(void);
+void parse_file_weights(char *arg);
+
+#define FILTER_IGNORE	1	/* leave this one out */
+#define FILTER_PRUNE	2	/* and don't walk into it */
+void add_file_filter(const char *arg);
+void compile_file_filters(void);
+unsigned int match_file_filters(const char *path);
+unsigned int file_filters_hash(void);
+bool load_filecache(void);
+void save_filecache(void);
 void open_files(void);
-void close_files(void);
-void regenerate_fds(void);
+bool replace_file_fd(unsigned int slot);
+
+void set_file_fd(unsigned int slot, int fd);
+void adopt_file_fd(unsigned int slot, int fd);
+bool is_shared_fd(int fd);
+void note_fd_result(int fd, unsigned long ret, int err);
+void forget_closed_fd(int fd);
+void drop_sticky_fd(void);
+void sticky_fd_tick(void);
+unsigned int roll_fds(void);
 
 void parse_devices(void);
 const char *map_dev(dev_t, mode_t);
 
 extern unsigned int nr_file_fds;
+extern int file_fds[NR_FILE_FDS];
+extern unsigned int fd_generation;
 extern char *victim_path;
-extern char **fileindex;
+extern char *filenames;
+extern unsigned long filenames_size;
+extern unsigned int *fileindex;
+extern unsigned int *filemodes;
 extern unsigned int files_in_index;
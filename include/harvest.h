@@ -0,0 +1,18 @@
+#ifndef _HARVEST_H
+#define _HARVEST_H 1
+
+#include "syscall.h"
+#include "types.h"
+
+enum harvest_type {
+	HARVEST_FD,
+	HARVEST_PID,
+	HARVEST_KEY,
+	NR_HARVEST_TYPES,
+};
+
+void harvest_result(struct syscall *entry, unsigned long ret);
+bool get_harvested(enum harvest_type type, unsigned long *value);
+void forget_harvested_fd(int fd);
+
+#endif	/* _HARVEST_H */
@@ -0,0 +1,31 @@
+#ifndef _LOCKS_H
+#define _LOCKS_H 1
+
+#include <time.h>
+#include <sys/types.h>
+
+/*
+ * Locks and flags that live in shm and get used across processes.
+ * Waiters sleep on a futex rather than spinning.
+ */
+
+#define CONTENDED 2	/* LOCKED, and someone is waiting. */
+
+typedef struct {
+	volatile int state;	/* UNLOCKED, LOCKED or CONTENDED */
+	volatile pid_t owner;
+} lock_t;
+
+void lock(lock_t *_lock);
+void unlock(lock_t *_lock);
+
+/* For flags other processes wait on, like shm->regenerating. */
+void wait_while_set(volatile int *flag);
+void set_flag(volatile int *flag);
+void clear_flag(volatile int *flag);
+
+/* For a process that sleeps until others have work for it, like the log writer. */
+void wait_for_flag(volatile int *flag, const struct timespec *timeout);
+void wake_flag(volatile int *flag);
+
+#endif	/* _LOCKS_H */
@@ -1,6 +1,8 @@
 #ifndef _LOG_H
 #define _LOG_H 1
 
+#include "arch.h"	// CACHELINE_SIZE
+
 #define ANSI_RED	"[1;31m"
 #define ANSI_GREEN	"[1;32m"
 #define ANSI_YELLOW	"[1;33m"
@@ -21,10 +23,33 @@
 
 #define MAX_LOGLEVEL 3
 void synclogs(void);
-void output(unsigned char level, const char *fmt, ...);
+void output(unsigned char level, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
 void open_logfiles(void);
 void close_logfiles(void);
 
+/*
+ * Children never write their logfiles themselves. They append to a ring in
+ * shared memory, which the log writer process drains to disk (logwriter.c).
+ * One producer and one consumer per ring, so no locking is needed.
+ */
+#define LOGRING_SIZE	(256 * 1024)	/* must be a power of two */
+
+struct logring {
+	/* written by the child */
+	volatile unsigned long head;
+	unsigned long dropped;
+
+	/* written by the log writer */
+	volatile unsigned long tail __attribute__((aligned(CACHELINE_SIZE)));
+
+	char buf[LOGRING_SIZE] __attribute__((aligned(CACHELINE_SIZE)));
+};
+
+extern struct logring *logrings;
+
+void init_logwriter(void);
+void stop_logwriter(void);
+
 #define __stringify_1(x...)     #x
 #define __stringify(x...)       __stringify_1(x)
 
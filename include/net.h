@@ -2,11 +2,17 @@
 #define _NET_H 1
 
 #include <netinet/in.h>
+#include "socketinfo.h"
 
 extern unsigned int nr_sockets;
 void open_sockets(void);
 void generate_sockaddr(unsigned long *addr, unsigned long *addrlen, int pf);
 
+struct socketinfo * get_random_socket(void);
+struct socketinfo * find_socket(int fd);
+struct socketinfo * get_socket_and_sockaddr(unsigned long *addr, unsigned long *addrlen);
+int sockaddr_hint(int fd);
+
 /* protocol decoding */
 extern unsigned int specific_proto;
 const char * get_proto_name(unsigned int proto);
@@ -21,9 +21,18 @@ extern bool monochrome;
 extern bool dangerous;
 extern bool do_syslog;
 extern bool logging;
+extern bool binary_logging;
+extern char *decode_log_file;
 extern unsigned char desired_group;
 extern bool user_set_seed;
+extern unsigned long replay_from;
 extern char *victim_path;
+extern unsigned int sockaddr_mismatch;
+extern unsigned int harvest_rate;
+extern unsigned int fd_mismatch;
+extern unsigned int fd_success_bias;
+extern unsigned int timeout_ms;
+extern unsigned int pipe_size;
 extern bool no_files;
 extern bool random_selection;
 extern unsigned int random_selection_num;
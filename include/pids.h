@@ -13,6 +13,7 @@ extern pid_t parentpid;
 int find_pid_slot(pid_t mypid);
 bool pidmap_empty(void);
 void dump_pid_slots(void);
+bool check_pidmap(void);
 int pid_is_valid(pid_t);
 void pids_init(void);
 
@@ -1,12 +1,69 @@
 #ifndef _RANDOM_H
 #define _RANDOM_H 1
 
+#include <stdint.h>
+
 extern unsigned int seed;
 unsigned int init_seed(unsigned int seed);
 void set_seed(unsigned int pidslot);
+void seed_syscall(unsigned int pidslot);
+
+/* How often children log their position in the random stream. */
+#define CHECKPOINT_INTERVAL 1000
 void reseed(void);
 unsigned int new_seed(void);
 
+/*
+ * xoshiro256** (Blackman & Vigna). Every process has its own copy of the
+ * state, so each child gets its own stream without any locking, and a given
+ * seed always produces the same sequence.
+ */
+extern uint64_t prng_state[4];
+
+void prng_seed(uint64_t s);
+
+static inline uint64_t prng_rotl(const uint64_t x, int k)
+{
+	return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t prng_next(void)
+{
+	const uint64_t result = prng_rotl(prng_state[1] * 5, 7) * 9;
+	const uint64_t t = prng_state[1] << 17;
+
+	prng_state[2] ^= prng_state[0];
+	prng_state[3] ^= prng_state[1];
+	prng_state[1] ^= prng_state[2];
+	prng_state[0] ^= prng_state[3];
+
+	prng_state[2] ^= t;
+	prng_state[3] = prng_rotl(prng_state[3], 45);
+
+	return result;
+}
+
+/* 0 .. RAND_MAX, same range as rand(). */
+static inline int rnd(void)
+{
+	return (int) (prng_next() >> 33);
+}
+
+/*
+ * 0 .. n-1 without a division in the common case (Lemire's multiply-shift).
+ * The bias this leaves is far too small to matter for fuzzing.
+ */
+static inline unsigned long rnd_below(unsigned long n)
+{
+	uint64_t r = prng_next();
+
+#if __WORDSIZE == 64
+	if (n > 0xffffffffUL)
+		return r % n;
+#endif
+	return ((r >> 32) * (uint64_t) n) >> 32;
+}
+
 unsigned int rand_bool(void);
 unsigned int rand_single_32bit(void);
 unsigned long rand_single_64bit(void);
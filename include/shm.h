@@ -9,64 +9,67 @@
 #include "types.h"
 #include "exit.h"
 #include "constants.h"
+#include "child.h"
+#include "locks.h"
+#include "socketinfo.h"
+#include "blocking.h"
 
 struct shm_s {
-	unsigned long total_syscalls_done;
-	unsigned long successes;
-	unsigned long failures;
+	/* Only touched when -N was passed, see do_random_syscalls() */
+	unsigned long syscalls_claimed;
+
 	unsigned long previous_count;
-	unsigned long child_syscall_count[MAX_NR_CHILDREN];
 
-	unsigned long regenerate;
+	/* how quickly dead children got replaced, see zygote.c */
+	unsigned long respawns;
+	unsigned long respawn_usecs;
+	unsigned long respawn_max_usecs;
+
+	/* total_syscalls_done() when we last regenerated. */
+	unsigned long regenerated_at;
 	unsigned int seed;
-	unsigned int seeds[MAX_NR_CHILDREN];
 	unsigned int reseed_counter;
 
 	pid_t parentpid;
 	pid_t watchdog_pid;
+	pid_t logwriter_pid;
 	pid_t pids[MAX_NR_CHILDREN];
 
 	pid_t last_reaped;
 
 	unsigned int max_children;
 	unsigned int running_childs;
-	struct timeval tv[MAX_NR_CHILDREN];
 
 	FILE *logfiles[MAX_NR_CHILDREN];
 
-	int pipe_fds[MAX_PIPE_FDS*2];
-	int file_fds[NR_FILE_FDS];		/* All children inherit these */
-	int socket_fds[NR_SOCKET_FDS];
-
-	/* state for the syscall currently in progress. */
-	unsigned int previous_syscallno[MAX_NR_CHILDREN];
-	unsigned long previous_a1[MAX_NR_CHILDREN];
-	unsigned long previous_a2[MAX_NR_CHILDREN];
-	unsigned long previous_a3[MAX_NR_CHILDREN];
-	unsigned long previous_a4[MAX_NR_CHILDREN];
-	unsigned long previous_a5[MAX_NR_CHILDREN];
-	unsigned long previous_a6[MAX_NR_CHILDREN];
-
-	unsigned int syscallno[MAX_NR_CHILDREN];
-	unsigned long a1[MAX_NR_CHILDREN];
-	unsigned long a2[MAX_NR_CHILDREN];
-	unsigned long a3[MAX_NR_CHILDREN];
-	unsigned long a4[MAX_NR_CHILDREN];
-	unsigned long a5[MAX_NR_CHILDREN];
-	unsigned long a6[MAX_NR_CHILDREN];
-
-	int current_fd;
-	unsigned int fd_lifetime;
+	int pipe_fds[MAX_PIPE_FDS];
+	struct socketinfo sockets[NR_SOCKET_FDS];	/* grouped by domain, see sockets.c */
+
+	/* see roll_fds() */
+	unsigned int file_fd_gen[NR_FILE_FDS];
+	unsigned int file_fd_errors[NR_FILE_FDS];
+	unsigned long fds_rolled_at;
+
+	/* bumped whenever syscall flags change, see tables.c */
+	unsigned int syscalls_generation;
+
+	/* fds that made syscalls hit the alarm, see blocking.c */
+	struct blocking_fd blocking_fds[NR_BLOCKING_FDS];
+	lock_t blocking_lock;
 
 	/* various flags. */
-	bool do32bit[MAX_NR_CHILDREN];
 	bool do_make_it_fail;
 	bool need_reseed;
 	enum exit_reasons exit_reason;
 
 	/* locks */
-	volatile unsigned char regenerating;
-	volatile unsigned char reaper_lock;
+	volatile int regenerating;	/* see wait_while_set() */
+	lock_t reaper_lock;		/* protects pids[], running_childs and spawn_requested */
+	volatile unsigned char logwriter_stop;
+	volatile int logwriter_awake;	/* see wait_for_flag() */
+
+	/* per-child state, one cacheline-aligned record each. */
+	struct childdata children[MAX_NR_CHILDREN];
 };
 extern struct shm_s *shm;
 
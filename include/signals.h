@@ -3,7 +3,10 @@
 
 #include <setjmp.h>
 
+#include <signal.h>
+
 extern jmp_buf ret_jump;
+extern volatile sig_atomic_t in_timed_syscall;
 void mask_signals_child(void);
 void setup_main_signals(void);
 
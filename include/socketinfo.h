@@ -0,0 +1,12 @@
+#ifndef _SOCKETINFO_H
+#define _SOCKETINFO_H 1
+
+/* What each socket in the pool was created as. */
+struct socketinfo {
+	int fd;
+	unsigned int domain;
+	unsigned int type;
+	unsigned int protocol;
+};
+
+#endif	/* _SOCKETINFO_H */
@@ -22,6 +22,13 @@ enum argtype {
 	ARG_IOVECLEN = 15,
 	ARG_SOCKADDR = 16,
 	ARG_SOCKADDRLEN = 17,
+	ARG_FD_SOCKET = 18,
+	ARG_FD_DIR = 19,
+	ARG_FD_EPOLL = 20,
+	ARG_FD_TIMERFD = 21,
+	ARG_FD_INOTIFY = 22,
+	ARG_FD_FANOTIFY = 23,
+	ARG_FD_IOCTL = 24,
 };
 
 struct arglist {
@@ -29,6 +36,16 @@ struct arglist {
 	unsigned int values[32];
 };
 
+/* buckets for struct syscall's timings[] */
+enum {
+	TIMING_1MS,
+	TIMING_10MS,
+	TIMING_50MS,
+	TIMING_SLOWER,
+	TIMING_TIMED_OUT,	/* the timer went off */
+	NR_TIMINGS,
+};
+
 struct syscall {
 	void (*sanitise)(int childno);
 	void (*post)(int);
@@ -75,8 +92,16 @@ struct syscall {
 
 	const unsigned int group;
 	const int rettype;
+
+	/* relative selection weight, 0 means SYSCALL_WEIGHT_DEFAULT */
+	unsigned int weight;
+
+	/* how long NEED_ALARM calls took, see do_syscall(). */
+	unsigned long timings[NR_TIMINGS];
 };
 
+#define SYSCALL_WEIGHT_DEFAULT	100
+
 #define RET_BORING		-1
 #define RET_NONE		0
 #define RET_ZERO_SUCCESS	1
@@ -134,6 +159,13 @@ void count_syscalls_enabled(void);
 void display_enabled_syscalls(void);
 void disable_non_net_syscalls(void);
 void init_syscalls(void);
+void syscall_tables_changed(void);
+unsigned int nr_active_syscalls(bool do32bit);
+void init_syscall_timer(void);
+void syscall_timed_out(int childno);
+void dump_syscall_timings(void);
+int pick_random_syscall(bool do32bit);
+void deactivate_syscall(unsigned int call);
 
 #define for_each_32bit_syscall(i) \
 	for (i = 0; i < max_nr_32bit_syscalls; i++)
@@ -0,0 +1,59 @@
+#ifndef _TRACE_H
+#define _TRACE_H 1
+
+#include <stdint.h>
+
+/*
+ * Binary syscall log (-l binary).
+ *
+ * Rather than format every syscall into text, children append fixed-size
+ * records to a ring of their own inside trinity.trace, which is mmap'd
+ * shared. The file outlives the run and gets turned back into the usual
+ * text with --decode-log.
+ */
+
+#define TRACE_FILENAME		"trinity.trace"
+#define TRACE_MAGIC		0x314352544e495254ULL	/* "TRINTRC1" */
+#define TRACE_VERSION		1
+#define TRACE_RING_ENTRIES	16384
+
+/* trace_record.flags */
+#define TRACE_32BIT		(1 << 0)
+#define TRACE_DONE		(1 << 1)	/* if clear, we never got back from the syscall. */
+
+struct trace_record {
+	uint64_t seq;
+	uint64_t timestamp;	/* usecs since the epoch, taken before the call */
+	uint64_t args[6];
+	uint64_t retval;
+	int32_t pid;
+	uint32_t nr;
+	int32_t err;
+	uint32_t flags;
+};
+
+struct trace_ring {
+	uint64_t head;		/* number of records ever written to this ring */
+	char pad[56];
+	struct trace_record recs[TRACE_RING_ENTRIES];
+};
+
+struct trace_header {
+	uint64_t magic;
+	uint32_t version;
+	uint32_t nr_rings;
+	uint32_t ring_entries;
+	uint32_t record_size;
+	uint32_t seed;
+	char pad[36];
+};
+
+void open_trace(void);
+void close_trace(void);
+void sync_trace(void);
+void trace_syscall_start(int childno);
+void trace_syscall_end(int childno, unsigned long ret, int err);
+
+int decode_trace(const char *filename);
+
+#endif	/* _TRACE_H */
@@ -1,6 +1,7 @@
 #ifndef _TRINITY_H
 #define _TRINITY_H 1
 
+#include <sys/types.h>
 #include "types.h"
 
 #define UNLOCKED 0
@@ -13,6 +14,15 @@ extern char *progname;
 void * alloc_shared(unsigned int size);
 
 void do_main_loop(void);
+void init_main_eventfd(void);
+void wake_main(void);
+void close_main_fds(void);
+
+void start_zygote(void);
+void stop_zygote(void);
+bool zygote_exited(pid_t pid);
+int zygote_spawn(int pidslot);
+void zygote_send_fd(unsigned int slot, int fd);
 
 extern bool biarch;
 
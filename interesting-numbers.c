@@ -7,17 +7,17 @@
 
 unsigned int get_interesting_32bit_value(void)
 {
-	switch (rand() % 11) {
+	switch (rnd_below(11)) {
 
 	/* rare case, single bit. */
 	case 0:	return rand_single_32bit();
 
 	/* common case, return small values*/
 	case 1 ... 7:
-		switch (rand() % 8) {
+		switch (rnd_below(8)) {
 		case 0:	return 0x00000000;
 		case 1:	return 0x00000001;
-		case 2:	return rand() % 256;
+		case 2:	return rnd_below(256);
 		case 3:	return 0x00000fff;	// 4095
 		case 4:	return 0x00001000;	// 4096
 		case 5:	return 0x00001001;	// 4097
@@ -31,7 +31,7 @@ unsigned int get_interesting_32bit_value(void)
 
 	/* less common case, go crazy */
 	case 8 ... 10:
-		switch (rand() % 14) {
+		switch (rnd_below(14)) {
 		case 0:	return 0x00010000;
 		case 1:	return 0x40000000;
 		case 2:	return 0x7fffffff;
@@ -43,7 +43,7 @@ unsigned int get_interesting_32bit_value(void)
 		case 8:	return 0xff000000;
 		case 9:	return 0xffff0000;
 		case 10: return 0xffffe000;
-		case 11: return 0xffffff00 | (rand() % 256);
+		case 11: return 0xffffff00 | rnd_below(256);
 		case 12: return 0xffffffff;
 		case 13: return 0xffffffff - page_size;
 		default:
@@ -67,7 +67,7 @@ static unsigned long per_arch_interesting_addr(unsigned long low)
 	int i = 0;
 
 #if defined(__x86_64__)
-	i = rand() % 4;
+	i = rnd_below(4);
 
 	switch (i) {
 	case 0: return 0x00007fffffffffffUL;			// x86-64 canonical addr end.
@@ -95,7 +95,7 @@ unsigned long get_interesting_value(void)
 
 	low = get_interesting_32bit_value();
 
-	switch (rand() % 18) {
+	switch (rnd_below(18)) {
 	case 0: return 0;
 	case 1: return low;
 	case 2: return 0x0000000100000000UL;
@@ -106,7 +106,7 @@ unsigned long get_interesting_value(void)
 	case 7: return 0x7fffffff00000000UL | low;
 	case 8: return 0x8000000000000000UL | low;
 	case 9: return 0xffffffff00000000UL | low;
-	case 10: return 0xffffffffffffff00UL | (rand() % 256);
+	case 10: return 0xffffffffffffff00UL | rnd_below(256);
 	case 11: return 0xffffffffffffffffUL - page_size;
 	case 12: return PAGE_OFFSET | (low << 4);
 	case 13: return KERNEL_ADDR | (low & 0xffffff);
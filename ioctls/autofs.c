@@ -6,6 +6,7 @@
 #include "shm.h"
 #include "trinity.h"
 #include "ioctls.h"
+#include "random.h"
 
 /* include/linux/auto_dev-ioctl.h */
 /*
@@ -263,14 +264,15 @@ static const char *const autofs_devs[] = {
 
 static void autofs_sanitise(const struct ioctl_group *grp, int childno)
 {
+	struct childdata *child = &shm->children[childno];
 	int i;
 	struct autofs_dev_ioctl *arg;
 
 	pick_random_ioctl(grp, childno);
 
-	shm->a3[childno] = (unsigned long) page_rand;
+	child->a3 = (unsigned long) page_rand;
 
-	switch (shm->a2[childno]) {
+	switch (child->a2) {
 	case AUTOFS_DEV_IOCTL_VERSION:
 	case AUTOFS_DEV_IOCTL_PROTOVER:
 	case AUTOFS_DEV_IOCTL_PROTOSUBVER:
@@ -285,22 +287,22 @@ static void autofs_sanitise(const struct ioctl_group *grp, int childno)
 	case AUTOFS_DEV_IOCTL_EXPIRE:
 	case AUTOFS_DEV_IOCTL_ASKUMOUNT:
 	case AUTOFS_DEV_IOCTL_ISMOUNTPOINT:
-		arg = (struct autofs_dev_ioctl *)shm->a3[childno];
+		arg = (struct autofs_dev_ioctl *)child->a3;
 		init_autofs_dev_ioctl(arg);
 		arg->ioctlfd = get_random_fd();
-		arg->fail.token = rand();
-		arg->fail.status = rand();
-		if (rand() % 2) {
+		arg->fail.token = rnd();
+		arg->fail.status = rnd();
+		if (rnd_below(2)) {
 			arg->size += 5;
 			arg->path[0] = '/';
-			arg->path[1] = rand();
-			arg->path[2] = rand();
-			arg->path[3] = rand();
+			arg->path[1] = rnd();
+			arg->path[2] = rnd();
+			arg->path[3] = rnd();
 			arg->path[4] = 0;
 		} else {
-			arg->size += rand();
+			arg->size += rnd();
 			for (i=0; i < 10; ++i)
-				arg->path[i] = rand();
+				arg->path[i] = rnd();
 		}
 		break;
 	default:
@@ -5,6 +5,7 @@
 #include "maps.h"
 #include "trinity.h"
 #include "ioctls.h"
+#include "random.h"
 
 static const struct ioctl dm_ioctls[] = {
 	IOCTL(DM_VERSION),
@@ -31,12 +32,13 @@ static const char *const dm_devs[] = {
 
 static void dm_sanitise(const struct ioctl_group *grp, int childno)
 {
+	struct childdata *child = &shm->children[childno];
 	struct dm_ioctl *dm;
 
 	pick_random_ioctl(grp, childno);
 
-	shm->a3[childno] = (unsigned long) page_rand;
-	dm = (struct dm_ioctl *)shm->a3[childno];
+	child->a3 = (unsigned long) page_rand;
+	dm = (struct dm_ioctl *)child->a3;
 
 	/* set a sensible version to get past the initial checks */
 	dm->version[0] = DM_VERSION_MAJOR;
@@ -44,7 +46,7 @@ static void dm_sanitise(const struct ioctl_group *grp, int childno)
 	dm->version[2] = DM_VERSION_PATCHLEVEL;
 
 	/* clear one of these strings to pass some kernel validation */
-	if (rand() % 2 == 0)
+	if (rnd_below(2) == 0)
 		dm->name[0] = 0;
 	else
 		dm->uuid[0] = 0;
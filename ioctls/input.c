@@ -4,6 +4,7 @@
 #include "shm.h"
 #include "trinity.h"
 #include "ioctls.h"
+#include "random.h"
 
 static const struct ioctl input_ioctls[] = {
 	IOCTL(EVIOCGVERSION),
@@ -49,67 +50,68 @@ static const char *const input_devs[] = {
 
 static void input_sanitise(const struct ioctl_group *grp, int childno)
 {
+	struct childdata *child = &shm->children[childno];
 	unsigned int u, r;
 
 	pick_random_ioctl(grp, childno);
 
-	switch (shm->a2[childno]) {
+	switch (child->a2) {
 	case EVIOCGNAME(0):
-		u = rand();
-		shm->a2[childno] = EVIOCGNAME(u);
+		u = rnd();
+		child->a2 = EVIOCGNAME(u);
 		break;
 	case EVIOCGPHYS(0):
-		u = rand();
-		shm->a2[childno] = EVIOCGPHYS(u);
+		u = rnd();
+		child->a2 = EVIOCGPHYS(u);
 		break;
 	case EVIOCGUNIQ(0):
-		u = rand();
-		shm->a2[childno] = EVIOCGUNIQ(u);
+		u = rnd();
+		child->a2 = EVIOCGUNIQ(u);
 		break;
 #ifdef EVIOCGPROP
 	case EVIOCGPROP(0):
-		u = rand();
-		shm->a2[childno] = EVIOCGPROP(u);
+		u = rnd();
+		child->a2 = EVIOCGPROP(u);
 		break;
 #endif
 #ifdef EVIOCGMTSLOTS
 	case EVIOCGMTSLOTS(0):
-		u = rand();
-		shm->a2[childno] = EVIOCGMTSLOTS(u);
+		u = rnd();
+		child->a2 = EVIOCGMTSLOTS(u);
 		break;
 #endif
 	case EVIOCGKEY(0):
-		u = rand();
-		shm->a2[childno] = EVIOCGKEY(u);
+		u = rnd();
+		child->a2 = EVIOCGKEY(u);
 		break;
 	case EVIOCGLED(0):
-		u = rand();
-		shm->a2[childno] = EVIOCGLED(u);
+		u = rnd();
+		child->a2 = EVIOCGLED(u);
 		break;
 	case EVIOCGSND(0):
-		u = rand();
-		shm->a2[childno] = EVIOCGSND(u);
+		u = rnd();
+		child->a2 = EVIOCGSND(u);
 		break;
 	case EVIOCGSW(0):
-		u = rand();
-		shm->a2[childno] = EVIOCGSW(u);
+		u = rnd();
+		child->a2 = EVIOCGSW(u);
 		break;
 	case EVIOCGBIT(0,0):
-		u = rand();
-		r = rand();
+		u = rnd();
+		r = rnd();
 		if (u % 10) u %= EV_CNT;
 		if (r % 10) r /= 4;
-		shm->a2[childno] = EVIOCGBIT(u, r);
+		child->a2 = EVIOCGBIT(u, r);
 		break;
 	case EVIOCGABS(0):
-		u = rand();
+		u = rnd();
 		if (u % 10) u %= ABS_CNT;
-		shm->a2[childno] = EVIOCGABS(u);
+		child->a2 = EVIOCGABS(u);
 		break;
 	case EVIOCSABS(0):
-		u = rand();
+		u = rnd();
 		if (u % 10) u %= ABS_CNT;
-		shm->a2[childno] = EVIOCSABS(u);
+		child->a2 = EVIOCSABS(u);
 		break;
 	default:
 		break;
@@ -7,6 +7,7 @@
 #include "files.h"
 #include "shm.h"
 #include "ioctls.h"
+#include "random.h"
 
 #define IOCTL_GROUPS_MAX 48
 
@@ -81,16 +82,17 @@ const struct ioctl_group *get_random_ioctl_group(void)
 	if (grps_cnt == 0)
 		return NULL;
 
-	return grps[rand() % grps_cnt];
+	return grps[rnd_below(grps_cnt)];
 }
 
 void pick_random_ioctl(const struct ioctl_group *grp, int childno)
 {
+	struct childdata *child = &shm->children[childno];
 	int ioctlnr;
 
-	ioctlnr = rand() % grp->ioctls_cnt;
+	ioctlnr = rnd_below(grp->ioctls_cnt);
 
-	shm->a2[childno] = grp->ioctls[ioctlnr].request;
+	child->a2 = grp->ioctls[ioctlnr].request;
 }
 
 void dump_ioctls(void)
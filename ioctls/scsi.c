@@ -11,6 +11,7 @@
 #include "arch.h"	// page_size
 #include "sanitise.h"
 #include "ioctls.h"
+#include "random.h"
 
 #ifndef SCSI_IOCTL_GET_PCI
 #define SCSI_IOCTL_GET_PCI 0x5387
@@ -77,6 +78,7 @@ struct sgio {
 
 static void scsi_sg_io_sanitise(int childno)
 {
+	struct childdata *child = &shm->children[childno];
 	struct sgio *sgio;
 
 	sgio = (struct sgio *) page_rand;
@@ -86,7 +88,7 @@ static void scsi_sg_io_sanitise(int childno)
 
 	sgio->ioh.interface_id = 'S';
 
-	switch (rand() % 4) {
+	switch (rnd_below(4)) {
 	case 0:	sgio->ioh.dxfer_direction = SG_DXFER_NONE;	break;
 	case 1:	sgio->ioh.dxfer_direction = SG_DXFER_TO_DEV;	break;
 	case 2:	sgio->ioh.dxfer_direction = SG_DXFER_FROM_DEV;	break;
@@ -96,10 +98,10 @@ static void scsi_sg_io_sanitise(int childno)
 
 	sgio->ioh.dxferp = sgio->data;
 
-	switch (rand() % 3) {
-	case 0: sgio->ioh.dxfer_len = rand() % page_size;	break;
+	switch (rnd_below(3)) {
+	case 0: sgio->ioh.dxfer_len = rnd_below(page_size);	break;
 	case 1: sgio->ioh.dxfer_len = get_interesting_value();	break;
-	case 2: sgio->ioh.dxfer_len = rand() % 512;		break;
+	case 2: sgio->ioh.dxfer_len = rnd_below(512);		break;
 	default: break;
 	}
 
@@ -111,14 +113,16 @@ static void scsi_sg_io_sanitise(int childno)
 	sgio->ioh.usr_ptr = NULL;
 	sgio->ioh.flags |= SG_FLAG_DIRECT_IO;
 
-	shm->a3[childno] = (unsigned long) page_rand;
+	child->a3 = (unsigned long) page_rand;
 }
 
 static void scsi_sanitise(const struct ioctl_group *grp, int childno)
 {
+	struct childdata *child = &shm->children[childno];
+
 	pick_random_ioctl(grp, childno);
 
-	switch (shm->a2[childno]) {
+	switch (child->a2) {
 	case SG_IO:
 		scsi_sg_io_sanitise(childno);
 		break;
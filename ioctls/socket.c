@@ -5,11 +5,8 @@
 
 static int socket_fd_test(int fd, const struct stat *st __attribute__((unused)))
 {
-	unsigned i;
-
-	for (i=0; i < nr_sockets; ++i)
-		if (shm->socket_fds[i] == fd)
-			return 0;
+	if (find_socket(fd) != NULL)
+		return 0;
 
 	return -1;
 }
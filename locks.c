@@ -0,0 +1,128 @@
+/*
+ * Cross-process locking, built on shared futexes.
+ *
+ * The lock is the usual three state futex mutex: the unlocker only makes
+ * a syscall if someone went to sleep waiting for it. We also remember who
+ * holds it, because children take it too, and a child can get killed at
+ * any point. If the holder is gone, the lock gets broken.
+ */
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+#include "trinity.h"
+#include "locks.h"
+#include "pids.h"
+
+static int futex(volatile int *uaddr, int op, int val, const struct timespec *timeout)
+{
+	return syscall(SYS_futex, uaddr, op, val, timeout, NULL, 0);
+}
+
+static void break_lock(lock_t *_lock)
+{
+	_lock->state = UNLOCKED;
+	futex(&_lock->state, FUTEX_WAKE, 1, NULL);
+}
+
+/*
+ * Only called after we've waited a while, so the kill() doesn't matter.
+ * The owner gets set after the holder's cmpxchg, so a holder that died in
+ * between leaves it at zero. Nobody legitimately holds it like that for
+ * long, so if it's still that way after two timeouts in a row, break it.
+ */
+static void check_lock_owner(lock_t *_lock, unsigned int *ownerless)
+{
+	pid_t owner = _lock->owner;
+
+	if (owner == 0) {
+		if (++(*ownerless) >= 2) {
+			*ownerless = 0;
+			break_lock(_lock);
+		}
+		return;
+	}
+	*ownerless = 0;
+
+	if (owner == getpid())
+		return;
+
+	if (pid_alive(owner) == -1 && errno == ESRCH) {
+		if (__sync_bool_compare_and_swap(&_lock->owner, owner, 0))
+			break_lock(_lock);
+	}
+}
+
+void lock(lock_t *_lock)
+{
+	const struct timespec ts = { .tv_sec = 1, .tv_nsec = 0 };
+	unsigned int ownerless = 0;
+	int c;
+
+	c = __sync_val_compare_and_swap(&_lock->state, UNLOCKED, LOCKED);
+	if (c != UNLOCKED) {
+		if (c != CONTENDED)
+			c = __sync_lock_test_and_set(&_lock->state, CONTENDED);
+
+		while (c != UNLOCKED) {
+			if (futex(&_lock->state, FUTEX_WAIT, CONTENDED, &ts) == -1 && errno == ETIMEDOUT)
+				check_lock_owner(_lock, &ownerless);
+			c = __sync_lock_test_and_set(&_lock->state, CONTENDED);
+		}
+	}
+
+	_lock->owner = getpid();
+}
+
+void unlock(lock_t *_lock)
+{
+	_lock->owner = 0;
+
+	if (__sync_fetch_and_sub(&_lock->state, 1) != LOCKED) {
+		_lock->state = UNLOCKED;
+		futex(&_lock->state, FUTEX_WAKE, 1, NULL);
+	}
+}
+
+void wait_while_set(volatile int *flag)
+{
+	while (*flag == TRUE)
+		futex(flag, FUTEX_WAIT, TRUE, NULL);
+}
+
+void set_flag(volatile int *flag)
+{
+	*flag = TRUE;
+	__sync_synchronize();
+}
+
+void clear_flag(volatile int *flag)
+{
+	*flag = FALSE;
+	__sync_synchronize();
+	futex(flag, FUTEX_WAKE, INT_MAX, NULL);
+}
+
+/*
+ * The sleeper clears the flag, looks for work once more, then calls this.
+ * Whoever hands it work calls wake_flag(), which only makes the syscall
+ * if it's the one that set the flag.
+ */
+void wait_for_flag(volatile int *flag, const struct timespec *timeout)
+{
+	if (*flag == FALSE)
+		futex(flag, FUTEX_WAIT, FALSE, timeout);
+}
+
+void wake_flag(volatile int *flag)
+{
+	if (*flag == TRUE)
+		return;
+
+	if (__sync_bool_compare_and_swap(flag, FALSE, TRUE))
+		futex(flag, FUTEX_WAKE, 1, NULL);
+}
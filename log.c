@@ -8,9 +8,14 @@
 #include "params.h"	// logging, monochrome, quiet_level
 #include "shm.h"
 #include "pids.h"
+#include "trace.h"
+#include "log.h"
+#include "trinity.h"	// alloc_shared
 
 FILE *parentlogfile;
 
+struct logring *logrings;
+
 void open_logfiles(void)
 {
 	unsigned int i;
@@ -35,6 +40,12 @@ void open_logfiles(void)
 		}
 	}
 	free(logfilename);
+
+	logrings = alloc_shared(shm->max_children * sizeof(struct logring));
+	if (!logrings) {
+		printf("## couldn't allocate log rings\n");
+		exit(EXIT_FAILURE);
+	}
 }
 
 void close_logfiles(void)
@@ -46,62 +57,49 @@ void close_logfiles(void)
 			fclose(shm->logfiles[i]);
 }
 
-static FILE * find_logfile_handle(void)
+/*
+ * Append to this child's ring. If the log writer has fallen behind we drop
+ * the message rather than wait for it, and count it so it can tell us later.
+ */
+static void logring_write(struct logring *ring, const char *buf, unsigned int len)
 {
-	pid_t pid;
-	int i;
-	unsigned int j;
-
-	pid = getpid();
-	if (pid == shm->parentpid)
-		return parentlogfile;
-
-	if (pid == shm->watchdog_pid)
-		return parentlogfile;
-
-	i = find_pid_slot(pid);
-	if (i != PIDSLOT_NOT_FOUND)
-		return shm->logfiles[i];
-	else {
-		/* try one more time. FIXME: This is awful. */
-		sleep(1);
-		i = find_pid_slot(pid);
-		if (i != PIDSLOT_NOT_FOUND)
-			return shm->logfiles[i];
-
-		printf("[%d] ## Couldn't find logfile for pid %d\n", getpid(), pid);
-		dump_pid_slots();
-		printf("## Logfiles for pids: ");
-		for_each_pidslot(j)
-			printf("%p ", shm->logfiles[j]);
-		printf("\n");
+	unsigned long head = ring->head;
+	unsigned int off, first;
+
+	if (len > LOGRING_SIZE - (head - ring->tail)) {
+		ring->dropped++;
+		return;
 	}
-	return NULL;
+
+	off = head & (LOGRING_SIZE - 1);
+	first = LOGRING_SIZE - off;
+	if (first > len)
+		first = len;
+
+	memcpy(&ring->buf[off], buf, first);
+	memcpy(ring->buf, buf + first, len - first);
+
+	/* make sure the data is visible before the writer sees the new head. */
+	__sync_synchronize();
+	ring->head = head + len;
+
+	/* and that it sees the new head before we look at whether it's asleep. */
+	__sync_synchronize();
+	wake_flag(&shm->logwriter_awake);
 }
 
+/*
+ * The children's logfiles are the log writer's business (it fsyncs them on
+ * its own schedule), so this only has to deal with the main logfile.
+ */
 void synclogs(void)
 {
-	unsigned int i;
-	int fd, ret;
+	if (binary_logging == TRUE)
+		sync_trace();
 
 	if (logging == FALSE)
 		return;
 
-	for_each_pidslot(i) {
-		ret = fflush(shm->logfiles[i]);
-		if (ret == EOF) {
-			printf("## logfile flushing failed! %s\n", strerror(errno));
-			continue;
-		}
-
-		fd = fileno(shm->logfiles[i]);
-		if (fd != -1) {
-			ret = fsync(fd);
-			if (ret != 0)
-				printf("## fsyncing logfile %d failed. %s\n", i, strerror(errno));
-		}
-	}
-
 	(void)fflush(parentlogfile);
 	fsync(fileno(parentlogfile));
 }
@@ -118,10 +116,10 @@ void output(unsigned char level, const char *fmt, ...)
 {
 	va_list args;
 	int n;
-	FILE *handle;
 	unsigned int len, i, j;
 	char outputbuf[1024];
 	char monobuf[1024];
+	char *buf = outputbuf;
 
 	if (logging == FALSE && level >= quiet_level)
 		return;
@@ -143,41 +141,34 @@ void output(unsigned char level, const char *fmt, ...)
 	if (logging == FALSE)
 		return;
 
-	handle = find_logfile_handle();
-	if (!handle) {
-		printf("## child logfile handle was null logging to main!\n");
-		(void)fflush(stdout);
-		for_each_pidslot(j)
-			shm->logfiles[j] = parentlogfile;
-		sleep(5);
-		return;
-	}
-
 	/* If we've specified monochrome, we can just dump the buffer
 	 * into the logfile as is. Otherwise, we need to strip out
 	 * any ANSI codes that may be present.
 	 */
-	if (monochrome == TRUE) {
-		fprintf(handle, "%s", outputbuf);
-		(void)fflush(handle);
-		return;
+	if (monochrome == FALSE) {
+		/* copy buffer, sans ANSI codes */
+		len = strlen(outputbuf);
+		for (i = 0, j = 0; i < len; i++) {
+			if (outputbuf[i] == '')
+				if (outputbuf[i + 2] == '1')
+					i += 6;	// ANSI_COLOUR
+				else
+					i += 3;	// ANSI_RESET
+			else {
+				monobuf[j] = outputbuf[i];
+				j++;
+			}
+		}
+		monobuf[j] = '\0';
+		buf = monobuf;
 	}
 
-	/* copy buffer, sans ANSI codes */
-	len = strlen(outputbuf);
-	for (i = 0, j = 0; i < len; i++) {
-		if (outputbuf[i] == '')
-			if (outputbuf[i + 2] == '1')
-				i += 6;	// ANSI_COLOUR
-			else
-				i += 3;	// ANSI_RESET
-		else {
-			monobuf[j] = outputbuf[i];
-			j++;
-		}
+	if (this_child != -1) {
+		logring_write(&logrings[this_child], buf, strlen(buf));
+		return;
 	}
-	monobuf[j] = '\0';
 
-	fprintf(handle, "%s", monobuf);
-	(void)fflush(handle);
+	/* Everyone else (main, watchdog, log writer) shares the main logfile. */
+	fprintf(parentlogfile, "%s", buf);
+	(void)fflush(parentlogfile);
 }
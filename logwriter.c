@@ -0,0 +1,195 @@
+/*
+ * The log writer drains the children's log rings to their logfiles,
+ * so that the children never have to wait on the disk themselves.
+ */
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/prctl.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+
+#include "trinity.h"
+#include "shm.h"
+#include "pids.h"
+#include "params.h"
+#include "log.h"
+#include "locks.h"
+
+/* fsync the logfiles once we've written this much, or this long has passed. */
+#define SYNC_BYTES	(1024 * 1024)
+#define SYNC_SECONDS	1
+
+static unsigned long reported_drops[MAX_NR_CHILDREN];
+static unsigned long unsynced_bytes;
+static time_t last_sync;
+
+/*
+ * Write out whatever is sitting in a ring. The data may wrap around the
+ * end of the buffer, so it can take two iovecs to get it in one writev.
+ */
+static unsigned long drain_ring(unsigned int i)
+{
+	struct logring *ring = &logrings[i];
+	struct iovec iov[2];
+	unsigned long head, tail, len;
+	unsigned int off, first;
+	int fd = fileno(shm->logfiles[i]);
+	int iovcnt = 1;
+	ssize_t ret;
+
+	head = ring->head;
+	__sync_synchronize();
+	tail = ring->tail;
+
+	len = head - tail;
+	if (len == 0)
+		return 0;
+
+	off = tail & (LOGRING_SIZE - 1);
+	first = LOGRING_SIZE - off;
+	if (first > len)
+		first = len;
+
+	iov[0].iov_base = &ring->buf[off];
+	iov[0].iov_len = first;
+	if (len > first) {
+		iov[1].iov_base = ring->buf;
+		iov[1].iov_len = len - first;
+		iovcnt = 2;
+	}
+
+	ret = writev(fd, iov, iovcnt);
+	if (ret <= 0) {
+		if (ret == -1 && errno != EINTR)
+			printf("## log writer couldn't write logfile %u. %s\n", i, strerror(errno));
+		return 0;
+	}
+
+	/* don't let the child reuse the space until we're done reading it. */
+	__sync_synchronize();
+	ring->tail = tail + ret;
+
+	return ret;
+}
+
+static void report_drops(unsigned int i)
+{
+	unsigned long dropped = logrings[i].dropped;
+
+	if (dropped == reported_drops[i])
+		return;
+
+	dprintf(fileno(shm->logfiles[i]), "## log writer fell behind, dropped %lu messages.\n",
+		dropped - reported_drops[i]);
+	reported_drops[i] = dropped;
+}
+
+static void sync_logfiles(void)
+{
+	unsigned int i;
+
+	for_each_pidslot(i)
+		(void)fdatasync(fileno(shm->logfiles[i]));
+
+	unsynced_bytes = 0;
+	last_sync = time(NULL);
+}
+
+static unsigned long drain_all(void)
+{
+	unsigned long written = 0;
+	unsigned int i;
+
+	for_each_pidslot(i) {
+		written += drain_ring(i);
+		report_drops(i);
+	}
+
+	unsynced_bytes += written;
+	if (unsynced_bytes >= SYNC_BYTES ||
+	    (unsynced_bytes != 0 && time(NULL) - last_sync >= SYNC_SECONDS))
+		sync_logfiles();
+
+	return written;
+}
+
+static void logwriter(pid_t parent)
+{
+	static const char name[17] = "trinity-logwrite";
+	static const struct timespec idle = { .tv_sec = SYNC_SECONDS };
+	unsigned long dropped = 0;
+	unsigned int i;
+
+	shm->logwriter_awake = TRUE;
+	shm->logwriter_pid = getpid();
+	prctl(PR_SET_NAME, (unsigned long) &name);
+	(void)signal(SIGINT, SIG_IGN);
+
+	last_sync = time(NULL);
+
+	/* Keep going until told to stop, or until whoever was going to tell us has died. */
+	while (shm->logwriter_stop == FALSE && getppid() == parent) {
+		if (drain_all() != 0)
+			continue;
+
+		/*
+		 * Nothing queued. Say we're going to sleep, then check again, so
+		 * a child that wrote just before that doesn't go unnoticed. The
+		 * timeout is so pending syncs and a dead parent still get seen.
+		 */
+		shm->logwriter_awake = FALSE;
+		__sync_synchronize();
+		if (drain_all() == 0 && shm->logwriter_stop == FALSE)
+			wait_for_flag(&shm->logwriter_awake, &idle);
+		shm->logwriter_awake = TRUE;
+	}
+
+	/* Get the stragglers, and make sure it all hits the disk. */
+	while (drain_all() != 0)
+		;
+	sync_logfiles();
+
+	for_each_pidslot(i)
+		dropped += logrings[i].dropped;
+	if (dropped != 0)
+		output(0, "[%d] Log writer dropped %lu messages.\n", getpid(), dropped);
+
+	_exit(EXIT_SUCCESS);
+}
+
+void init_logwriter(void)
+{
+	static const struct timespec ts = { .tv_nsec = 10000000 }; /* 10ms */
+	pid_t parent = getpid();
+	pid_t pid;
+
+	fflush(stdout);
+	pid = fork();
+
+	if (pid == 0)
+		logwriter(parent);	// Never returns.
+
+	while (shm->logwriter_pid == 0)
+		nanosleep(&ts, NULL);
+
+	output(0, "[%d] Started log writer process, PID is %d\n", getpid(), shm->logwriter_pid);
+}
+
+/* Called once everything that might log has gone away. */
+void stop_logwriter(void)
+{
+	int childstatus;
+
+	if (shm->logwriter_pid == 0)
+		return;
+
+	shm->logwriter_stop = TRUE;
+	wake_flag(&shm->logwriter_awake);
+	waitpid(shm->logwriter_pid, &childstatus, 0);
+	shm->logwriter_pid = 0;
+}
@@ -3,10 +3,15 @@
 #include <unistd.h>
 #include <string.h>
 #include <stdlib.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/prctl.h>
+#include <sys/signalfd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/wait.h>
+#include <time.h>
 #include <sys/ptrace.h>
 
 #include "trinity.h"
@@ -20,28 +25,99 @@
 #include "log.h"
 #include "params.h"
 #include "maps.h"
+#include "constants.h"
+
+/*
+ * The main process sleeps in epoll_wait() on:
+ *  - a signalfd for SIGCHLD and SIGINT, so a child dying wakes us straight away.
+ *  - an eventfd that other processes (the watchdog) poke when they want
+ *    us to look at need_reseed, the regeneration point or exit_reason.
+ */
+static int main_eventfd = -1;
+static int main_signalfd = -1;
+static int main_epollfd = -1;
+
+/* Has to be done before the watchdog is forked, so it can wake us too. */
+void init_main_eventfd(void)
+{
+	main_eventfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (main_eventfd == -1) {
+		printf("## couldn't create eventfd: %s\n", strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+}
+
+void wake_main(void)
+{
+	uint64_t one = 1;
+
+	if (write(main_eventfd, &one, sizeof(one)) != sizeof(one)) {
+		/* Only fails if the counter is saturated, in which case main is awake anyway. */
+	}
+}
+
+/* For anything main forks. They're CLOEXEC, but nothing we fork execs. */
+void close_main_fds(void)
+{
+	if (main_epollfd != -1)
+		close(main_epollfd);
+	if (main_signalfd != -1)
+		close(main_signalfd);
+	if (main_eventfd != -1)
+		close(main_eventfd);
+	main_epollfd = main_signalfd = main_eventfd = -1;
+}
+
+static void setup_main_events(void)
+{
+	struct epoll_event ev;
+	sigset_t mask;
+
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGCHLD);
+	sigaddset(&mask, SIGINT);
+	if (sigprocmask(SIG_BLOCK, &mask, NULL) == -1) {
+		printf("## couldn't block signals: %s\n", strerror(errno));
+		_exit(EXIT_FAILURE);
+	}
+
+	main_signalfd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+	main_epollfd = epoll_create1(EPOLL_CLOEXEC);
+	if (main_signalfd == -1 || main_epollfd == -1) {
+		printf("## couldn't set up main event loop: %s\n", strerror(errno));
+		_exit(EXIT_FAILURE);
+	}
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.fd = main_signalfd;
+	epoll_ctl(main_epollfd, EPOLL_CTL_ADD, main_signalfd, &ev);
+
+	ev.data.fd = main_eventfd;
+	epoll_ctl(main_epollfd, EPOLL_CTL_ADD, main_eventfd, &ev);
+}
 
 static void regenerate(void)
 {
 	if (no_files == TRUE)	/* We don't regenerate sockets */
 		return;
 
-	shm->regenerating = TRUE;
-
-	sleep(1);	/* give children time to finish with fds. */
-
-	shm->regenerate = 0;
+	/* Children don't wait for this, they keep their own fds and maps. */
+	set_flag(&shm->regenerating);
 
-	output(0, "[%d] Regenerating random pages, fd's etc.\n", getpid());
+	shm->regenerated_at = total_syscalls_done();
 
-	regenerate_fds();
+	output(0, "[%d] Regenerating random pages and maps.\n", getpid());
 
 	destroy_maps();
 	setup_maps();
 
 	generate_random_page(page_rand);
 
-	shm->regenerating = FALSE;
+	/* Start a new zygote, so new children get the new generation. */
+	stop_zygote();
+
+	clear_flag(&shm->regenerating);
 }
 
 bool ignore_tainted;
@@ -68,77 +144,70 @@ int check_tainted(void)
 	return ret;
 }
 
-static void oom_score_adj(int adj)
+#define debugf if (debug == TRUE) printf
+
+/*
+ * A slot is only free if it's empty and we're not still waiting for a child
+ * from the zygote to show up in it. If one never does, give up on it.
+ * Must hold the reaper_lock.
+ */
+static int find_free_pidslot(void)
 {
-	FILE *fp;
+	struct childdata *child;
+	unsigned int i;
 
-	fp = fopen("/proc/self/oom_score_adj", "w");
-	if (!fp)
-		return;
+	for_each_pidslot(i) {
+		if (shm->pids[i] != EMPTY_PIDSLOT)
+			continue;
 
-	fprintf(fp, "%d", adj);
-	fclose(fp);
-}
+		child = &shm->children[i];
+		if (child->spawn_requested == 0)
+			return i;
 
-#define debugf if (debug == TRUE) printf
+		if (time(NULL) - child->spawn_requested > 5) {
+			output(0, "[%d] child for pidslot %d never showed up.\n", getpid(), i);
+			child->spawn_requested = 0;
+			shm->running_childs--;
+			return i;
+		}
+	}
+	return PIDSLOT_NOT_FOUND;
+}
 
 static void fork_children(void)
 {
 	int pidslot;
-	static char childname[17];
 
 	/* Generate children*/
 
 	while (shm->running_childs < shm->max_children) {
-		int pid = 0;
 
 		/* Find a space for it in the pid map */
-		pidslot = find_pid_slot(EMPTY_PIDSLOT);
+		lock(&shm->reaper_lock);
+		pidslot = find_free_pidslot();
 		if (pidslot == PIDSLOT_NOT_FOUND) {
+			unlock(&shm->reaper_lock);
 			printf("[%d] ## Pid map was full!\n", getpid());
 			dump_pid_slots();
 			exit(EXIT_FAILURE);
 		}
-
-		(void)alarm(0);
-		fflush(stdout);
-		pid = fork();
-		if (pid != 0)
-			shm->pids[pidslot] = pid;
-		else {
-			/* Child process. */
-			int ret = 0;
-
-			mask_signals_child();
-
-			memset(childname, 0, sizeof(childname));
-			sprintf(childname, "trinity-child%d", pidslot);
-			prctl(PR_SET_NAME, (unsigned long) &childname);
-
-			oom_score_adj(500);
-
-			/* Wait for parent to set our pidslot */
-			while (shm->pids[pidslot] != getpid()) {
-				/* Make sure parent is actually alive to wait for us. */
-				ret = pid_alive(shm->parentpid);
-				if (ret != 0) {
-					shm->exit_reason = EXIT_SHM_CORRUPTION;
-					printf("[%d] " BUGTXT "parent (%d) went away!\n", getpid(), shm->parentpid);
-					sleep(20000);
-				}
-			}
-
-			init_child(pidslot);
-
-			ret = child_process(pidslot);
-
-			output(1, "child %d exiting\n", getpid());
-
-			_exit(ret);
-		}
+		shm->children[pidslot].spawn_requested = time(NULL);
 		shm->running_childs++;
-		debugf("[%d] Created child %d in pidslot %d [total:%d/%d]\n",
-			getpid(), shm->pids[pidslot], pidslot,
+		unlock(&shm->reaper_lock);
+
+		/* One of the zygote's waiting children picks this up and puts itself in the pidmap. */
+		if (zygote_spawn(pidslot) == FALSE) {
+			output(0, "[%d] ## Couldn't get a child from the zygote!\n", getpid());
+			lock(&shm->reaper_lock);
+			shm->children[pidslot].spawn_requested = 0;
+			shm->running_childs--;
+			unlock(&shm->reaper_lock);
+			shm->exit_reason = EXIT_FORK_FAILURE;
+			return;
+		}
+
+		debugf("[%d] Requested child for pidslot %d [total:%d/%d]\n",
+			getpid(), pidslot,
 			shm->running_childs, shm->max_children);
 
 		if (shm->exit_reason != STILL_RUNNING)
@@ -152,9 +221,7 @@ void reap_child(pid_t childpid)
 {
 	int i;
 
-	while (shm->reaper_lock == LOCKED);
-
-	shm->reaper_lock = LOCKED;
+	lock(&shm->reaper_lock);
 
 	if (childpid == shm->last_reaped) {
 		debugf("[%d] already reaped %d!\n", getpid(), childpid);
@@ -168,11 +235,18 @@ void reap_child(pid_t childpid)
 	debugf("[%d] Removing pid %d from pidmap.\n", getpid(), childpid);
 	shm->pids[i] = EMPTY_PIDSLOT;
 	shm->running_childs--;
-	shm->tv[i].tv_sec = 0;
+	shm->children[i].tv.tv_sec = 0;
+
+	/* It died during a syscall that it won't get to count. */
+	if (shm->children[i].holds_ticket == TRUE) {
+		__sync_fetch_and_sub(&shm->syscalls_claimed, 1);
+		shm->children[i].holds_ticket = FALSE;
+	}
+	gettimeofday(&shm->children[i].reaped_at, NULL);
 	shm->last_reaped = childpid;
 
 out:
-	shm->reaper_lock = UNLOCKED;
+	unlock(&shm->reaper_lock);
 }
 
 static void handle_child(pid_t childpid, int childstatus)
@@ -191,6 +265,7 @@ static void handle_child(pid_t childpid, int childstatus)
 
 		if (errno == ECHILD) {
 			debugf("[%d] All children exited!\n", getpid());
+			lock(&shm->reaper_lock);
 			for_each_pidslot(i) {
 				if (shm->pids[i] != EMPTY_PIDSLOT) {
 					if (pid_alive(shm->pids[i]) == -1) {
@@ -202,6 +277,7 @@ static void handle_child(pid_t childpid, int childstatus)
 					}
 				}
 			}
+			unlock(&shm->reaper_lock);
 			break;
 		}
 		output(0, "error! (%s)\n", strerror(errno));
@@ -214,17 +290,28 @@ static void handle_child(pid_t childpid, int childstatus)
 
 			slot = find_pid_slot(childpid);
 			if (slot == PIDSLOT_NOT_FOUND) {
-				printf("[%d] ## Couldn't find pid slot for %d\n", getpid(), childpid);
-				shm->exit_reason = EXIT_LOST_PID_SLOT;
-				dump_pid_slots();
+				/*
+				 * As a subreaper we also get the zygote, its spare children,
+				 * and anything the children forked and then abandoned.
+				 */
+				if (zygote_exited(childpid) == TRUE)
+					output(0, "[%d] zygote %d exited, will restart it.\n", getpid(), childpid);
+				else
+					debugf("[%d] pid %d exited, but wasn't one of ours.\n", getpid(), childpid);
 			} else {
-				debugf("[%d] Child %d exited after %ld syscalls.\n", getpid(), childpid, shm->child_syscall_count[slot]);
+				debugf("[%d] Child %d exited after %ld syscalls.\n", getpid(), childpid, shm->children[slot].syscall_count);
 				reap_child(childpid);
 			}
 			break;
 
 		} else if (WIFSIGNALED(childstatus)) {
 
+			if (zygote_exited(childpid) == TRUE) {
+				output(0, "[%d] zygote %d was killed by %s, will restart it.\n",
+					getpid(), childpid, strsignal(WTERMSIG(childstatus)));
+				break;
+			}
+
 			switch (WTERMSIG(childstatus)) {
 			case SIGALRM:
 				debugf("[%d] got a alarm signal from pid %d\n", getpid(), childpid);
@@ -277,39 +364,49 @@ static void handle_child(pid_t childpid, int childstatus)
 	}
 }
 
-static void handle_children(void)
+/*
+ * SIGCHLD got delivered to the signalfd. Several children may have changed
+ * state by the time we read it, so collect everything that's waiting.
+ */
+static void collect_children(void)
 {
-	unsigned int i;
+	struct signalfd_siginfo si;
 	int childstatus;
 	pid_t pid;
 
-	if (shm->running_childs == 0)
-		return;
-
-	/* First, we wait for *any* child to wake us up. */
-	pid = waitpid(-1, &childstatus, WUNTRACED | WCONTINUED);
-
-	/* We were awoken, handle it. */
-	handle_child(pid, childstatus);
+	while (read(main_signalfd, &si, sizeof(si)) == sizeof(si)) {
+		if (si.ssi_signo == SIGINT)
+			shm->exit_reason = EXIT_SIGINT;
+	}
 
-	/* While we're awake, let's see if the other children need attention.
-	 * We do this instead of just waitpid(-1) again so that there's no way
-	 * for any one child to starve the others of attention.
-	 */
-	for_each_pidslot(i) {
+	while (shm->running_childs != 0) {
+		pid = waitpid(-1, &childstatus, WUNTRACED | WCONTINUED | WNOHANG);
+		if (pid == 0)
+			break;
 
-		pid = shm->pids[i];
+		handle_child(pid, childstatus);
+		if (pid == -1)
+			break;
+	}
+}
 
-		if (pid == EMPTY_PIDSLOT)
-			continue;
+static void handle_children(void)
+{
+	struct epoll_event events[2];
+	uint64_t count;
+	int i, n;
 
-		if (pid_is_valid(pid) == FALSE)
-			return;
+	n = epoll_wait(main_epollfd, events, 2, 1000);
 
-		pid = waitpid(pid, &childstatus, WUNTRACED | WCONTINUED | WNOHANG);
-		if (pid != 0)
-			handle_child(pid, childstatus);
+	for (i = 0; i < n; i++) {
+		if (events[i].data.fd == main_eventfd) {
+			/* Just clear it, main_loop() rechecks everything on every wakeup. */
+			if (read(main_eventfd, &count, sizeof(count)) != sizeof(count))
+				continue;
+		}
 	}
+
+	collect_children();
 }
 
 static const char *reasons[] = {
@@ -325,6 +422,7 @@ static const char *reasons[] = {
 	"Child reparenting problem",
 	"No files in file list.",
 	"Main process disappeared.",
+	"Couldn't fork children.",
 };
 
 static const char * decode_exit(unsigned int reason)
@@ -340,13 +438,16 @@ static void main_loop(void)
 			fork_children();
 		}
 
-		if (shm->regenerate >= REGENERATION_POINT)
+		if (total_syscalls_done() - shm->regenerated_at >= REGENERATION_POINT)
 			regenerate();
 
+		roll_fds();
+
 		if (shm->need_reseed == TRUE)
 			reseed();
 
 		handle_children();
+		check_pidmap();
 	}
 }
 
@@ -363,6 +464,10 @@ void do_main_loop(void)
 	pid = fork();
 	if (pid == 0) {
 		setup_main_signals();
+		setup_main_events();
+
+		/* The zygote's children get orphaned on their way to us. */
+		prctl(PR_SET_CHILD_SUBREAPER, 1);
 
 		shm->parentpid = getpid();
 		output(0, "[%d] Main thread is alive.\n", getpid());
@@ -379,9 +484,13 @@ void do_main_loop(void)
 
 		main_loop();
 
+		stop_zygote();
+		stop_pipes();
+
 		/* Wait until all children have exited. */
 		while (pidmap_empty() == FALSE)
 			handle_children();
+		check_pidmap();
 
 		printf("[%d] Bailing main loop. Exit reason: %s\n", getpid(), decode_exit(shm->exit_reason));
 		_exit(EXIT_SUCCESS);
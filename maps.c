@@ -12,6 +12,7 @@
 #include "maps.h"
 #include "log.h"
 #include "shm.h"
+#include "random.h"
 
 static unsigned int num_mappings = 0;
 static struct map *maps_list;
@@ -74,7 +75,7 @@ static void * alloc_zero_map(struct map *map, int prot, const char *name)
 	}
 
 	/* Pick a random sized mmap. */
-	switch (rand() % 4) {
+	switch (rnd_below(4)) {
 	case 0:	size = page_size;
 		break;
 	case 1:	size = 1024*1024;
@@ -142,7 +143,7 @@ void * get_map(void)
 	struct map *tmpmap = maps_list;
 	unsigned int i, j;
 
-	i = rand() % num_mappings;
+	i = rnd_below(num_mappings);
 	for (j = 0; j < i; j++)
 		tmpmap = tmpmap->next;
 
@@ -4,6 +4,7 @@
 #include <netinet/in.h>
 #include <stdlib.h>
 #include "config.h"
+#include "random.h"
 
 #ifdef USE_IF_ALG
 #include <linux/if_alg.h>
@@ -19,11 +20,11 @@ void gen_alg(unsigned long *addr, unsigned long *addrlen)
 
 	alg->salg_family = PF_ALG;
 	for (i = 0; i < 14; i++)
-		alg->salg_type[i] = rand();
-	alg->salg_feat = rand();
-	alg->salg_mask = rand();
+		alg->salg_type[i] = rnd();
+	alg->salg_feat = rnd();
+	alg->salg_mask = rnd();
 	for (i = 0; i < 64; i++)
-		alg->salg_name[i] = rand();
+		alg->salg_name[i] = rnd();
 	*addr = (unsigned long) alg;
 	*addrlen = sizeof(struct sockaddr_alg);
 }
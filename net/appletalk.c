@@ -4,6 +4,7 @@
 #include <sys/un.h>
 #include <netinet/in.h>
 #include <linux/atalk.h>
+#include "random.h"
 
 void gen_appletalk(unsigned long *addr, unsigned long *addrlen)
 {
@@ -14,9 +15,9 @@ void gen_appletalk(unsigned long *addr, unsigned long *addrlen)
 		return;
 
 	atalk->sat_family = PF_APPLETALK;
-	atalk->sat_port = rand();
-	atalk->sat_addr.s_net = rand();
-	atalk->sat_addr.s_node = rand();
+	atalk->sat_port = rnd();
+	atalk->sat_addr.s_net = rnd();
+	atalk->sat_addr.s_node = rnd();
 	*addr = (unsigned long) atalk;
 	*addrlen = sizeof(struct sockaddr_at);
 }
@@ -4,6 +4,7 @@
 #include <netinet/in.h>
 #include <linux/atm.h>
 #include <stdlib.h>
+#include "random.h"
 
 void gen_atmpvc(unsigned long *addr, unsigned long *addrlen)
 {
@@ -14,9 +15,9 @@ void gen_atmpvc(unsigned long *addr, unsigned long *addrlen)
 		return;
 
 	atmpvc->sap_family = PF_ATMPVC;
-	atmpvc->sap_addr.itf = rand();
-	atmpvc->sap_addr.vpi = rand();
-	atmpvc->sap_addr.vci = rand();
+	atmpvc->sap_addr.itf = rnd();
+	atmpvc->sap_addr.vpi = rnd();
+	atmpvc->sap_addr.vci = rnd();
 	*addr = (unsigned long) atmpvc;
 	*addrlen = sizeof(struct sockaddr_atmpvc);
 }
@@ -32,11 +33,11 @@ void gen_atmsvc(unsigned long *addr, unsigned long *addrlen)
 
 	atmsvc->sas_family = PF_ATMSVC;
 	for (i = 0; i < ATM_ESA_LEN; i++)
-		atmsvc->sas_addr.prv[i] = rand();
+		atmsvc->sas_addr.prv[i] = rnd();
 	for (i = 0; i < ATM_E164_LEN; i++)
-		atmsvc->sas_addr.pub[i] = rand();
-	atmsvc->sas_addr.lij_type = rand();
-	atmsvc->sas_addr.lij_id = rand();
+		atmsvc->sas_addr.pub[i] = rnd();
+	atmsvc->sas_addr.lij_type = rnd();
+	atmsvc->sas_addr.lij_id = rnd();
 	*addr = (unsigned long) atmsvc;
 	*addrlen = sizeof(struct sockaddr_atmsvc);
 }
@@ -5,6 +5,7 @@
 #include <linux/ax25.h>
 #include <stdlib.h>
 #include "maps.h"	// page_rand
+#include "random.h"
 
 void gen_ax25(unsigned long *addr, unsigned long *addrlen)
 {
@@ -16,7 +17,7 @@ void gen_ax25(unsigned long *addr, unsigned long *addrlen)
 
 	ax25->sax25_family = PF_AX25;
 	strncpy(ax25->sax25_call.ax25_call, page_rand, 7);
-	ax25->sax25_ndigis = rand();
+	ax25->sax25_ndigis = rnd();
 	*addr = (unsigned long) ax25;
 	*addrlen = sizeof(struct sockaddr_ax25);
 }
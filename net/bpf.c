@@ -145,8 +145,8 @@ static const uint32_t bpf_seccomp_jmp_arch_vars[] = {
 # define TRUE_REG_SYSCALL	REG_RAX
 # define TRUE_ARCH		AUDIT_ARCH_X86_64
 #else
-# define TRUE_REG_SYSCALL	((uint32_t) rand()) /* TODO later */
-# define TRUE_ARCH		((uint32_t) rand()) /* TODO later */
+# define TRUE_REG_SYSCALL	((uint32_t) rnd()) /* TODO later */
+# define TRUE_ARCH		((uint32_t) rnd()) /* TODO later */
 #endif
 
 struct seccomp_data {
@@ -157,7 +157,7 @@ struct seccomp_data {
 };
 
 #define bpf_rand(type) \
-	(bpf_##type##_vars[rand() % ARRAY_SIZE(bpf_##type##_vars)])
+	(bpf_##type##_vars[rnd_below(ARRAY_SIZE(bpf_##type##_vars))])
 
 static uint16_t gen_bpf_code(bool last_instr)
 {
@@ -169,7 +169,7 @@ static uint16_t gen_bpf_code(bool last_instr)
 		 * increase the chance to be accepted and that we
 		 * actually run the generated fuzz filter code.
 		 */
-		if (rand() % 2 == 0)
+		if (rnd_below(2) == 0)
 			ret = BPF_RET;
 	}
 
@@ -193,13 +193,13 @@ static uint16_t gen_bpf_code(bool last_instr)
 		ret |= bpf_rand(misc);
 		break;
 	default:
-		ret = (uint16_t) rand();
+		ret = (uint16_t) rnd();
 		break;
 	}
 
 	/* Also give it a chance to fuzz some crap into it */
-	if (rand() % 10 == 0)
-		ret |= (uint16_t) rand();
+	if (rnd_below(10) == 0)
+		ret |= (uint16_t) rnd();
 
 	return ret;
 }
@@ -254,7 +254,7 @@ static int gen_seccomp_bpf_code(struct sock_filter *curr)
 		used = 3;
 		memcpy(curr, validate_arch, sizeof(validate_arch));
 		/* Randomize architecture */
-		if (rand() % 3 == 0)
+		if (rnd_below(3) == 0)
 			curr[0].k = bpf_rand(seccomp_jmp_arch);
 		else
 			curr[0].k = TRUE_ARCH;
@@ -267,32 +267,32 @@ static int gen_seccomp_bpf_code(struct sock_filter *curr)
 		used = 2;
 		memcpy(curr, allow_syscall, sizeof(allow_syscall));
 		/* We assume here that max_nr_syscalls was computed before */
-		curr[0].k = rand() % max_nr_syscalls;
+		curr[0].k = rnd_below(max_nr_syscalls);
 		break;
 	case STATE_GEN_KILL_PROCESS:
 		used = 1;
 		memcpy(curr, kill_process, sizeof(kill_process));
-		if (rand() % 3 == 0)
+		if (rnd_below(3) == 0)
 			/* Variate between seccomp ret values */
 			curr[0].k = bpf_rand(seccomp_ret_k);
 		break;
 	default:
 	case STATE_GEN_RANDOM_CRAP:
 		used = 1;
-		curr->code = (uint16_t) rand();
-		curr->jt = (uint8_t) rand();
-		curr->jf = (uint8_t) rand();
+		curr->code = (uint16_t) rnd();
+		curr->jt = (uint8_t) rnd();
+		curr->jf = (uint8_t) rnd();
 		curr->k = rand32();
 		break;
 	}
 
 	/* Also give it a chance to fuzz some crap into it */
-	if (rand() % 10 == 0)
-		curr[0].code |= (uint16_t) rand();
-	if (rand() % 10 == 0)
-		curr[1].code |= (uint16_t) rand();
-	if (rand() % 10 == 0)
-		curr[2].code |= (uint16_t) rand();
+	if (rnd_below(10) == 0)
+		curr[0].code |= (uint16_t) rnd();
+	if (rnd_below(10) == 0)
+		curr[1].code |= (uint16_t) rnd();
+	if (rnd_below(10) == 0)
+		curr[2].code |= (uint16_t) rnd();
 
 	return used;
 }
@@ -301,7 +301,7 @@ static int seccomp_choose(const float probs[__STATE_GEN_MAX])
 {
 	int i;
 	float sum = .0f;
-	float thr = (float) rand() / (float) RAND_MAX;
+	float thr = (float) rnd() / (float) RAND_MAX;
 
 	for (i = 0; i < STATE_GEN_MAX; ++i) {
 		sum += probs[i];
@@ -325,7 +325,7 @@ void gen_seccomp_bpf(unsigned long *addr, unsigned long *addrlen)
 			return;
 	}
 
-	bpf->len = avail = rand() % BPF_MAXINSNS;
+	bpf->len = avail = rnd_below(BPF_MAXINSNS);
 
 	bpf->filter = malloc(bpf->len * sizeof(struct sock_filter));
 	if (bpf->filter == NULL) {
@@ -363,7 +363,7 @@ void gen_bpf(unsigned long *addr, unsigned long *addrlen)
 			return;
 	}
 
-	bpf->len = rand() % BPF_MAXINSNS;
+	bpf->len = rnd_below(BPF_MAXINSNS);
 
 	bpf->filter = malloc(bpf->len * sizeof(struct sock_filter));
 	if (bpf->filter == NULL) {
@@ -379,27 +379,27 @@ void gen_bpf(unsigned long *addr, unsigned long *addrlen)
 
 		/* Fill out jump offsets if jmp instruction */
 		if (BPF_CLASS(bpf->filter[i].code) == BPF_JMP) {
-			bpf->filter[i].jt = (uint8_t) rand();
-			bpf->filter[i].jf = (uint8_t) rand();
+			bpf->filter[i].jt = (uint8_t) rnd();
+			bpf->filter[i].jf = (uint8_t) rnd();
 		}
 
 		/* Also give it a chance if not BPF_JMP */
-		if (rand() % 10 == 0)
-			bpf->filter[i].jt |= (uint8_t) rand();
-		if (rand() % 10 == 0)
-			bpf->filter[i].jf |= (uint8_t) rand();
+		if (rnd_below(10) == 0)
+			bpf->filter[i].jt |= (uint8_t) rnd();
+		if (rnd_below(10) == 0)
+			bpf->filter[i].jf |= (uint8_t) rnd();
 
 		/* Not always fill out k */
-		bpf->filter[i].k = rand() % 2 == 0 ? 0 : (uint32_t) rand();
+		bpf->filter[i].k = rnd_below(2) == 0 ? 0 : (uint32_t) rnd();
 
 		/* Also try to jump into BPF extensions by chance */
 		if (BPF_CLASS(bpf->filter[i].code) == BPF_LD ||
 		    BPF_CLASS(bpf->filter[i].code) == BPF_LDX) {
 			if (bpf->filter[i].k > 65000 &&
 			    bpf->filter[i].k < (uint32_t) SKF_AD_OFF) {
-				if (rand() % 2 == 0) {
+				if (rnd_below(2) == 0) {
 					bpf->filter[i].k = (uint32_t) (SKF_AD_OFF +
-							   rand() % SKF_AD_MAX);
+							   rnd_below(SKF_AD_MAX));
 				}
 			}
 		}
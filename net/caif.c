@@ -4,6 +4,7 @@
 #include <netinet/in.h>
 #include <stdlib.h>
 #include "config.h"
+#include "random.h"
 
 #ifdef USE_CAIF
 #include <linux/caif/caif_socket.h>
@@ -18,16 +19,16 @@ void gen_caif(unsigned long *addr, unsigned long *addrlen)
 		return;
 
 	caif->family = PF_CAIF;
-	caif->u.at.type = rand();
+	caif->u.at.type = rnd();
 	for (i = 0; i < 16; i++)
-		caif->u.util.service[i] = rand();
-	caif->u.dgm.connection_id = rand();
-	caif->u.dgm.nsapi = rand();
-	caif->u.rfm.connection_id = rand();
+		caif->u.util.service[i] = rnd();
+	caif->u.dgm.connection_id = rnd();
+	caif->u.dgm.nsapi = rnd();
+	caif->u.rfm.connection_id = rnd();
 	for (i = 0; i < 16; i++)
-		caif->u.rfm.volume[i] = rand();
-	caif->u.dbg.type = rand();
-	caif->u.dbg.service = rand();
+		caif->u.rfm.volume[i] = rnd();
+	caif->u.dbg.type = rnd();
+	caif->u.dbg.service = rnd();
 	*addr = (unsigned long) caif;
 	*addrlen = sizeof(struct sockaddr_caif);
 }
@@ -4,6 +4,7 @@
 #include <netinet/in.h>
 #include <linux/can.h>
 #include <stdlib.h>
+#include "random.h"
 
 void gen_can(unsigned long *addr, unsigned long *addrlen)
 {
@@ -13,9 +14,9 @@ void gen_can(unsigned long *addr, unsigned long *addrlen)
 	if (can == NULL)
 		return;
 	can->can_family = AF_CAN;
-	can->can_ifindex = rand();
-	can->can_addr.tp.rx_id = rand();
-	can->can_addr.tp.tx_id = rand();
+	can->can_ifindex = rnd();
+	can->can_addr.tp.rx_id = rnd();
+	can->can_addr.tp.tx_id = rnd();
 	*addr = (unsigned long) can;
 	*addrlen = sizeof(struct sockaddr_can);
 }
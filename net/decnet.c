@@ -4,6 +4,7 @@
 #include <netinet/in.h>
 #include <linux/dn.h>
 #include <stdlib.h>
+#include "random.h"
 
 void gen_decnet(unsigned long *addr, unsigned long *addrlen)
 {
@@ -15,14 +16,14 @@ void gen_decnet(unsigned long *addr, unsigned long *addrlen)
 		return;
 
 	dn->sdn_family = PF_DECnet;
-	dn->sdn_flags = rand();
-	dn->sdn_objnum = rand();
-	dn->sdn_objnamel = rand() % 16;
+	dn->sdn_flags = rnd();
+	dn->sdn_objnum = rnd();
+	dn->sdn_objnamel = rnd_below(16);
 	for (i = 0; i < dn->sdn_objnamel; i++)
-		dn->sdn_objname[i] = rand();
-	dn->sdn_add.a_len = rand() % 2;
-	dn->sdn_add.a_addr[0] = rand();
-	dn->sdn_add.a_addr[1] = rand();
+		dn->sdn_objname[i] = rnd();
+	dn->sdn_add.a_len = rnd_below(2);
+	dn->sdn_add.a_addr[0] = rnd();
+	dn->sdn_add.a_addr[1] = rnd();
 	*addr = (unsigned long) dn;
 	*addrlen = sizeof(struct sockaddr_dn);
 }
@@ -4,6 +4,7 @@
 #include <netinet/in.h>
 #include <neteconet/ec.h>
 #include <stdlib.h>
+#include "random.h"
 
 void gen_econet(unsigned long *addr, unsigned long *addrlen)
 {
@@ -14,12 +15,12 @@ void gen_econet(unsigned long *addr, unsigned long *addrlen)
 		return;
 
 	ec->sec_family = PF_ECONET;
-	ec->port = rand();
-	ec->cb = rand();
-	ec->type = rand();
-	ec->addr.station = rand();
-	ec->addr.net = rand();
-	ec->cookie = rand();
+	ec->port = rnd();
+	ec->cb = rnd();
+	ec->type = rnd();
+	ec->addr.station = rnd();
+	ec->addr.net = rnd();
+	ec->cookie = rnd();
 	*addr = (unsigned long) ec;
 	*addrlen = sizeof(struct sockaddr_ec);
 }
@@ -3,13 +3,14 @@
 #include <sys/un.h>
 #include <netinet/in.h>
 #include <stdlib.h>
+#include "random.h"
 
 in_addr_t random_ipv4_address(void)
 {
 	int addr = 0;
 	int class = 0;
 
-	switch (rand() % 9) {
+	switch (rnd_below(9)) {
 	case 0:	addr = 0;		/* 0.0.0.0 */
 		break;
 	case 1:	addr = 0x0a000000;	/* 10.0.0.0/8 */
@@ -39,17 +40,17 @@ in_addr_t random_ipv4_address(void)
 		break;
 	}
 
-	if (rand() % 100 < 50) {
+	if (rnd_below(100) < 50) {
 		switch (class) {
-		case 4:	addr |= rand() % 0xfffffff;
+		case 4:	addr |= rnd_below(0xfffffff);
 			break;
-		case 8:	addr |= rand() % 0xffffff;
+		case 8:	addr |= rnd_below(0xffffff);
 			break;
-		case 12: addr |= rand() % 0xfffff;
+		case 12: addr |= rnd_below(0xfffff);
 			break;
-		case 16: addr |= rand() % 0xffff;
+		case 16: addr |= rnd_below(0xffff);
 			break;
-		case 24: addr |= rand() % 0xff;
+		case 24: addr |= rnd_below(0xff);
 			break;
 		default: break;
 		}
@@ -67,7 +68,7 @@ void gen_ipv4(unsigned long *addr, unsigned long *addrlen)
 
 	ipv4->sin_family = PF_INET;
 	ipv4->sin_addr.s_addr = random_ipv4_address();
-	ipv4->sin_port = rand() % 65535;
+	ipv4->sin_port = rnd_below(65535);
 	*addr = (unsigned long) ipv4;
 	*addrlen = sizeof(struct sockaddr_in);
 }
@@ -6,6 +6,7 @@
 #include <linux/if_arp.h>
 #include <linux/if_packet.h>
 #include <stdlib.h>
+#include "random.h"
 
 void gen_ipv6(unsigned long *addr, unsigned long *addrlen)
 {
@@ -20,7 +21,7 @@ void gen_ipv6(unsigned long *addr, unsigned long *addrlen)
 	ipv6->sin6_addr.s6_addr32[1] = 0;
 	ipv6->sin6_addr.s6_addr32[2] = 0;
 	ipv6->sin6_addr.s6_addr32[3] = htonl(1);
-	ipv6->sin6_port = rand() % 65535;
+	ipv6->sin6_port = rnd_below(65535);
 	*addr = (unsigned long) ipv6;
 	*addrlen = sizeof(struct sockaddr_in6);
 }
@@ -4,6 +4,7 @@
 #include <netinet/in.h>
 #include <linux/ipx.h>
 #include <stdlib.h>
+#include "random.h"
 
 void gen_ipx(unsigned long *addr, unsigned long *addrlen)
 {
@@ -15,12 +16,12 @@ void gen_ipx(unsigned long *addr, unsigned long *addrlen)
 		return;
 
 	ipx->sipx_family = PF_IPX;
-	ipx->sipx_port = rand();
-	ipx->sipx_network = rand();
+	ipx->sipx_port = rnd();
+	ipx->sipx_network = rnd();
 	for (i = 0; i < 6; i++)
-		ipx->sipx_node[i] = rand();
-	ipx->sipx_type = rand();
-	ipx->sipx_zero = rand() % 2;
+		ipx->sipx_node[i] = rnd();
+	ipx->sipx_type = rnd();
+	ipx->sipx_zero = rnd_below(2);
 	*addr = (unsigned long) ipx;
 	*addrlen = sizeof(struct sockaddr_ipx);
 }
@@ -4,6 +4,7 @@
 #include <netinet/in.h>
 #include <linux/irda.h>
 #include <stdlib.h>
+#include "random.h"
 
 void gen_irda(unsigned long *addr, unsigned long *addrlen)
 {
@@ -15,10 +16,10 @@ void gen_irda(unsigned long *addr, unsigned long *addrlen)
 		return;
 
 	irda->sir_family = PF_IRDA;
-	irda->sir_lsap_sel = rand();
-	irda->sir_addr = rand();
+	irda->sir_lsap_sel = rnd();
+	irda->sir_addr = rnd();
 	for (i = 0; i < 25; i++)
-		irda->sir_name[i] = rand();
+		irda->sir_name[i] = rnd();
 	*addr = (unsigned long) irda;
 	*addrlen = sizeof(struct sockaddr_irda);
 }
@@ -6,6 +6,7 @@
 #include <linux/if_arp.h>
 #include <linux/llc.h>
 #include <stdlib.h>
+#include "random.h"
 
 void gen_llc(unsigned long *addr, unsigned long *addrlen)
 {
@@ -17,12 +18,12 @@ void gen_llc(unsigned long *addr, unsigned long *addrlen)
 		return;
 	llc->sllc_family = AF_LLC;
 	llc->sllc_arphrd = ARPHRD_ETHER;
-	llc->sllc_test = rand();
-	llc->sllc_xid = rand();
-	llc->sllc_ua = rand();
-	llc->sllc_sap = rand();
+	llc->sllc_test = rnd();
+	llc->sllc_xid = rnd();
+	llc->sllc_ua = rnd();
+	llc->sllc_sap = rnd();
 	for (i = 0; i < IFHWADDRLEN; i++)
-		llc->sllc_mac[i] = rand();
+		llc->sllc_mac[i] = rnd();
 	*addr = (unsigned long) llc;
 	*addrlen = sizeof(struct sockaddr_llc);
 }
@@ -4,6 +4,7 @@
 #include <netinet/in.h>
 #include <linux/netlink.h>
 #include <stdlib.h>
+#include "random.h"
 
 void gen_netlink(unsigned long *addr, unsigned long *addrlen)
 {
@@ -14,8 +15,8 @@ void gen_netlink(unsigned long *addr, unsigned long *addrlen)
 		return;
 
 	nl->nl_family = PF_NETLINK;
-	nl->nl_pid = rand();
-	nl->nl_groups = rand();
+	nl->nl_pid = rnd();
+	nl->nl_groups = rnd();
 	*addr = (unsigned long) nl;
 	*addrlen = sizeof(struct sockaddr_nl);
 }
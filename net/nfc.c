@@ -5,6 +5,7 @@
 #include <stdlib.h>
 #include "config.h"
 #include "compat.h"
+#include "random.h"
 
 void gen_nfc(unsigned long *addr, unsigned long *addrlen)
 {
@@ -16,9 +17,9 @@ void gen_nfc(unsigned long *addr, unsigned long *addrlen)
 		return;
 
 	nfc->sa_family = PF_NFC;
-	nfc->dev_idx = rand();
-	nfc->target_idx = rand();
-	nfc->nfc_protocol = rand() % 5;
+	nfc->dev_idx = rnd();
+	nfc->target_idx = rnd();
+	nfc->nfc_protocol = rnd_below(5);
 	*addr = (unsigned long) nfc;
 	*addrlen = sizeof(struct sockaddr_nfc);
 }
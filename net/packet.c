@@ -4,6 +4,7 @@
 #include <netinet/in.h>
 #include <linux/if_packet.h>
 #include <stdlib.h>
+#include "random.h"
 
 void gen_packet(unsigned long *addr, unsigned long *addrlen)
 {
@@ -17,7 +18,7 @@ void gen_packet(unsigned long *addr, unsigned long *addrlen)
 
 	pkt->spkt_family = PF_PACKET;
 	for (i = 0; i < 14; i++)
-		pkt->spkt_device[i] = rand();
+		pkt->spkt_device[i] = rnd();
 	*addr = (unsigned long) pkt;
 	*addrlen = sizeof(struct sockaddr_pkt);
 }
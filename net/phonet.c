@@ -4,6 +4,7 @@
 #include <netinet/in.h>
 #include <linux/phonet.h>
 #include <stdlib.h>
+#include "random.h"
 
 void gen_phonet(unsigned long *addr, unsigned long *addrlen)
 {
@@ -14,9 +15,9 @@ void gen_phonet(unsigned long *addr, unsigned long *addrlen)
 		return;
 
 	pn->spn_family = PF_PHONET;
-	pn->spn_obj = rand();
-	pn->spn_dev = rand();
-	pn->spn_resource = rand();
+	pn->spn_obj = rnd();
+	pn->spn_dev = rnd();
+	pn->spn_resource = rnd();
 	*addr = (unsigned long) pn;
 	*addrlen = sizeof(struct sockaddr_pn);
 }
@@ -9,6 +9,7 @@
 #include "config.h"
 #include "net.h"
 #include "sanitise.h"
+#include "random.h"
 
 //TODO: Split out each case into separate function.
 
@@ -19,7 +20,7 @@ void gen_pppox(unsigned long *addr, unsigned long *addrlen)
 	unsigned int proto;
 	unsigned int i;
 
-	proto = rand() % 3;
+	proto = rnd_below(3);
 
 	switch (proto) {
 
@@ -31,14 +32,14 @@ void gen_pppox(unsigned long *addr, unsigned long *addrlen)
 		pppox->sa_family = PF_PPPOX;
 		pppox->sa_protocol = proto;
 
-		pppox->sa_addr.pppoe.sid = rand();
+		pppox->sa_addr.pppoe.sid = rnd();
 		for (i = 0; i < ETH_ALEN; i++)
-			pppox->sa_addr.pppoe.remote[i] = rand();
+			pppox->sa_addr.pppoe.remote[i] = rnd();
 		for (i = 0; i < IFNAMSIZ; i++)
-			pppox->sa_addr.pppoe.dev[i] = rand();
+			pppox->sa_addr.pppoe.dev[i] = rnd();
 
 #ifdef USE_PPPOX_PPTP
-		pppox->sa_addr.pptp.call_id = rand();
+		pppox->sa_addr.pptp.call_id = rnd();
 		pppox->sa_addr.pptp.sin_addr.s_addr = random_ipv4_address();
 #endif
 
@@ -47,7 +48,7 @@ void gen_pppox(unsigned long *addr, unsigned long *addrlen)
 		break;
 
 	case PX_PROTO_OL2TP:
-		switch (rand() % 4) {
+		switch (rnd_below(4)) {
 
 		case 0:	/* PPPoL2TP */
 			pppol2tp = malloc(sizeof(struct sockaddr_pppol2tp));
@@ -59,10 +60,10 @@ void gen_pppox(unsigned long *addr, unsigned long *addrlen)
 			pppol2tp->pppol2tp.pid = get_pid();
 			pppol2tp->pppol2tp.fd = get_random_fd();
 			pppol2tp->pppol2tp.addr.sin_addr.s_addr = random_ipv4_address();
-			pppol2tp->pppol2tp.s_tunnel = rand();
-			pppol2tp->pppol2tp.s_session = rand();
-			pppol2tp->pppol2tp.d_tunnel = rand();
-			pppol2tp->pppol2tp.d_session = rand();
+			pppol2tp->pppol2tp.s_tunnel = rnd();
+			pppol2tp->pppol2tp.s_session = rnd();
+			pppol2tp->pppol2tp.d_tunnel = rnd();
+			pppol2tp->pppol2tp.d_session = rnd();
 			*addr = (unsigned long) pppol2tp;
 			*addrlen = sizeof(struct sockaddr_pppol2tp);
 			break;
@@ -80,18 +81,18 @@ void gen_pppox(unsigned long *addr, unsigned long *addrlen)
 			pppol2tpin6->sa_protocol = proto;
 			pppol2tpin6->pppol2tp.pid = get_pid();
 			pppol2tpin6->pppol2tp.fd = get_random_fd();
-			pppol2tpin6->pppol2tp.s_tunnel = rand();
-			pppol2tpin6->pppol2tp.s_session = rand();
-			pppol2tpin6->pppol2tp.d_tunnel = rand();
-			pppol2tpin6->pppol2tp.d_session = rand();
+			pppol2tpin6->pppol2tp.s_tunnel = rnd();
+			pppol2tpin6->pppol2tp.s_session = rnd();
+			pppol2tpin6->pppol2tp.d_tunnel = rnd();
+			pppol2tpin6->pppol2tp.d_session = rnd();
 			pppol2tpin6->pppol2tp.addr.sin6_family = AF_INET6;
-			pppol2tpin6->pppol2tp.addr.sin6_port = rand();
-			pppol2tpin6->pppol2tp.addr.sin6_flowinfo = rand();
+			pppol2tpin6->pppol2tp.addr.sin6_port = rnd();
+			pppol2tpin6->pppol2tp.addr.sin6_flowinfo = rnd();
 			pppol2tpin6->pppol2tp.addr.sin6_addr.s6_addr32[0] = 0;
 			pppol2tpin6->pppol2tp.addr.sin6_addr.s6_addr32[1] = 0;
 			pppol2tpin6->pppol2tp.addr.sin6_addr.s6_addr32[2] = 0;
 			pppol2tpin6->pppol2tp.addr.sin6_addr.s6_addr32[3] = htonl(1);
-			pppol2tpin6->pppol2tp.addr.sin6_scope_id = rand();
+			pppol2tpin6->pppol2tp.addr.sin6_scope_id = rnd();
 			*addr = (unsigned long) pppol2tpin6;
 			*addrlen = sizeof(struct sockaddr_pppol2tpin6);
 			}
@@ -112,10 +113,10 @@ void gen_pppox(unsigned long *addr, unsigned long *addrlen)
 			pppol2tpv3->pppol2tp.pid = get_pid();
 			pppol2tpv3->pppol2tp.fd = get_random_fd();
 			pppol2tpv3->pppol2tp.addr.sin_addr.s_addr = random_ipv4_address();
-			pppol2tpv3->pppol2tp.s_tunnel = rand();
-			pppol2tpv3->pppol2tp.s_session = rand();
-			pppol2tpv3->pppol2tp.d_tunnel = rand();
-			pppol2tpv3->pppol2tp.d_session = rand();
+			pppol2tpv3->pppol2tp.s_tunnel = rnd();
+			pppol2tpv3->pppol2tp.s_session = rnd();
+			pppol2tpv3->pppol2tp.d_tunnel = rnd();
+			pppol2tpv3->pppol2tp.d_session = rnd();
 			*addr = (unsigned long) pppol2tpv3;
 			*addrlen = sizeof(struct sockaddr_pppol2tpv3);
 			}
@@ -135,18 +136,18 @@ void gen_pppox(unsigned long *addr, unsigned long *addrlen)
 			pppol2tpv3in6->sa_protocol = proto;
 			pppol2tpv3in6->pppol2tp.pid = get_pid();
 			pppol2tpv3in6->pppol2tp.fd = get_random_fd();
-			pppol2tpv3in6->pppol2tp.s_tunnel = rand();
-			pppol2tpv3in6->pppol2tp.s_session = rand();
-			pppol2tpv3in6->pppol2tp.d_tunnel = rand();
-			pppol2tpv3in6->pppol2tp.d_session = rand();
+			pppol2tpv3in6->pppol2tp.s_tunnel = rnd();
+			pppol2tpv3in6->pppol2tp.s_session = rnd();
+			pppol2tpv3in6->pppol2tp.d_tunnel = rnd();
+			pppol2tpv3in6->pppol2tp.d_session = rnd();
 			pppol2tpv3in6->pppol2tp.addr.sin6_family = AF_INET6;
-			pppol2tpv3in6->pppol2tp.addr.sin6_port = rand();
-			pppol2tpv3in6->pppol2tp.addr.sin6_flowinfo = rand();
+			pppol2tpv3in6->pppol2tp.addr.sin6_port = rnd();
+			pppol2tpv3in6->pppol2tp.addr.sin6_flowinfo = rnd();
 			pppol2tpv3in6->pppol2tp.addr.sin6_addr.s6_addr32[0] = 0;
 			pppol2tpv3in6->pppol2tp.addr.sin6_addr.s6_addr32[1] = 0;
 			pppol2tpv3in6->pppol2tp.addr.sin6_addr.s6_addr32[2] = 0;
 			pppol2tpv3in6->pppol2tp.addr.sin6_addr.s6_addr32[3] = random_ipv4_address();
-			pppol2tpv3in6->pppol2tp.addr.sin6_scope_id = rand();
+			pppol2tpv3in6->pppol2tp.addr.sin6_scope_id = rnd();
 			*addr = (unsigned long) pppol2tpv3in6;
 			*addrlen = sizeof(struct sockaddr_pppol2tpv3in6);
 			}
@@ -6,6 +6,7 @@
 #include <linux/rose.h>
 #include <stdlib.h>
 #include "maps.h"	// page_rand
+#include "random.h"
 
 void gen_rose(unsigned long *addr, unsigned long *addrlen)
 {
@@ -16,15 +17,15 @@ void gen_rose(unsigned long *addr, unsigned long *addrlen)
 		return;
 
 	rose->srose_family = PF_ROSE;
-	rose->srose_addr.rose_addr[0] = rand();
-	rose->srose_addr.rose_addr[1] = rand();
-	rose->srose_addr.rose_addr[2] = rand();
-	rose->srose_addr.rose_addr[3] = rand();
-	rose->srose_addr.rose_addr[4] = rand();
+	rose->srose_addr.rose_addr[0] = rnd();
+	rose->srose_addr.rose_addr[1] = rnd();
+	rose->srose_addr.rose_addr[2] = rnd();
+	rose->srose_addr.rose_addr[3] = rnd();
+	rose->srose_addr.rose_addr[4] = rnd();
 
 	strncpy(rose->srose_call.ax25_call, page_rand, 7);
 
-	rose->srose_ndigis = rand();
+	rose->srose_ndigis = rnd();
 	strncpy(rose->srose_digi.ax25_call, page_rand+7, 7);
 
 	*addr = (unsigned long) rose;
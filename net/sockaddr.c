@@ -10,6 +10,7 @@
 #include "maps.h"
 #include "config.h"
 #include "params.h"	// do_specific_proto
+#include "random.h"
 
 void generate_sockaddr(unsigned long *addr, unsigned long *addrlen, int pf)
 {
@@ -19,7 +20,7 @@ void generate_sockaddr(unsigned long *addr, unsigned long *addrlen, int pf)
 
 	/* If we got no hint passed down, pick a random proto. */
 	if (pf == -1)
-		pf = rand() % TRINITY_PF_MAX;
+		pf = rnd_below(TRINITY_PF_MAX);
 
 	switch (pf) {
 
@@ -186,3 +187,34 @@ void generate_sockaddr(unsigned long *addr, unsigned long *addrlen, int pf)
 		break;
 	}
 }
+
+/*
+ * Which family of sockaddr to make for a syscall on fd: the same as it, if
+ * it's one of our sockets. Callers do the --sockaddr-mismatch roll themselves,
+ * once per call.
+ */
+int sockaddr_hint(int fd)
+{
+	struct socketinfo *si;
+
+	si = find_socket(fd);
+	if (si == NULL)
+		return PF_NOHINT;
+
+	return si->domain;
+}
+
+/* For sanitisers that want a socket and an address to go with it. */
+struct socketinfo * get_socket_and_sockaddr(unsigned long *addr, unsigned long *addrlen)
+{
+	struct socketinfo *si;
+
+	si = get_random_socket();
+	if (si == NULL) {
+		generate_sockaddr(addr, addrlen, PF_NOHINT);
+		return NULL;
+	}
+
+	generate_sockaddr(addr, addrlen, sockaddr_hint(si->fd));
+	return si;
+}
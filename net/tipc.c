@@ -4,6 +4,7 @@
 #include <netinet/in.h>
 #include <linux/tipc.h>
 #include <stdlib.h>
+#include "random.h"
 
 void gen_tipc(unsigned long *addr, unsigned long *addrlen)
 {
@@ -13,16 +14,16 @@ void gen_tipc(unsigned long *addr, unsigned long *addrlen)
 	if (tipc == NULL)
 		return;
 	tipc->family = AF_TIPC;
-	tipc->addrtype = rand();
-	tipc->scope = rand();
-	tipc->addr.id.ref = rand();
-	tipc->addr.id.node = rand();
-	tipc->addr.nameseq.type = rand();
-	tipc->addr.nameseq.lower = rand();
-	tipc->addr.nameseq.upper = rand();
-	tipc->addr.name.name.type = rand();
-	tipc->addr.name.name.instance = rand();
-	tipc->addr.name.domain = rand();
+	tipc->addrtype = rnd();
+	tipc->scope = rnd();
+	tipc->addr.id.ref = rnd();
+	tipc->addr.id.node = rnd();
+	tipc->addr.nameseq.type = rnd();
+	tipc->addr.nameseq.lower = rnd();
+	tipc->addr.nameseq.upper = rnd();
+	tipc->addr.name.name.type = rnd();
+	tipc->addr.name.name.instance = rnd();
+	tipc->addr.name.domain = rnd();
 	*addr = (unsigned long) tipc;
 	*addrlen = sizeof(struct sockaddr_tipc);
 }
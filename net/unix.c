@@ -5,6 +5,7 @@
 #include <linux/dn.h>
 #include <stdlib.h>
 #include "maps.h"
+#include "random.h"
 
 void gen_unixsock(unsigned long *addr, unsigned long *addrlen)
 {
@@ -16,7 +17,7 @@ void gen_unixsock(unsigned long *addr, unsigned long *addrlen)
 		return;
 
 	unixsock->sun_family = PF_UNIX;
-	len = rand() % 20;
+	len = rnd_below(20);
 	memset(&page_rand[len], 0, 1);
 	strncpy(unixsock->sun_path, page_rand, len);
 	*addr = (unsigned long) unixsock;
@@ -5,6 +5,7 @@
 #include <linux/x25.h>
 #include <stdlib.h>
 #include "maps.h"	// page_rand
+#include "random.h"
 
 void gen_x25(unsigned long *addr, unsigned long *addrlen)
 {
@@ -16,7 +17,7 @@ void gen_x25(unsigned long *addr, unsigned long *addrlen)
 		return;
 
 	x25->sx25_family = PF_X25;
-	len = rand() % 15;
+	len = rnd_below(15);
 	memset(&page_rand[len], 0, 1);
 	strncpy(x25->sx25_addr.x25_addr, page_rand, len);
 	*addr = (unsigned long) x25;
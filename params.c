@@ -10,6 +10,7 @@
 #include "random.h"
 #include "syscall.h"
 #include "log.h"
+#include "files.h"
 
 bool debug = FALSE;
 
@@ -29,12 +30,15 @@ bool verbose = FALSE;
 bool monochrome = FALSE;
 bool dangerous = FALSE;
 bool logging = TRUE;
+bool binary_logging = FALSE;
+char *decode_log_file = NULL;
 bool do_syslog = FALSE;
 bool random_selection = FALSE;
 unsigned int random_selection_num;
 bool no_files = FALSE;
 
 bool user_set_seed = FALSE;
+unsigned long replay_from = 0;
 
 unsigned char desired_group = GROUP_NONE;
 
@@ -42,21 +46,43 @@ char *specific_proto_optarg;
 
 char *victim_path;
 
+unsigned int sockaddr_mismatch = 10;
+
+unsigned int harvest_rate = 30;
+
+unsigned int fd_mismatch = 10;
+
+unsigned int fd_success_bias = 0;
+
+unsigned int timeout_ms = 100;
+
+unsigned int pipe_size = 0;
+
 static void usage(void)
 {
 	fprintf(stderr, "%s\n", progname);
 	fprintf(stderr, " --children,-C: specify number of child processes\n");
 	fprintf(stderr, " --exclude,-x: don't call a specific syscall\n");
+	fprintf(stderr, " --filter-files=<glob>: don't use files matching glob. (end it in / to skip a whole dir, or use @file for a list).\n");
+	fprintf(stderr, " --fd-mismatch=#: %% of fd args that get any fd, not the kind the syscall wants. (default 10)\n");
+	fprintf(stderr, " --fd-success-bias=#: %% of the time a child's next fd is one that syscalls recently worked on. (default 0)\n");
+	fprintf(stderr, " --file-weights=name=#,...: how often to pick files from dev,proc,sys,other and of type chr,blk,reg,dir,special.\n");
+	fprintf(stderr, " --harvest-rate=#: %% of fd/pid args that reuse something an earlier syscall returned. (default 30)\n");
 	fprintf(stderr, " --group,-g: only run syscalls from a certain group (So far just 'vm').\n");
 	fprintf(stderr, " --list,-L: list all syscalls known on this architecture.\n");
 	fprintf(stderr, " --ioctls,-I: list all ioctls.\n");
-	fprintf(stderr, " --logging,-l: (off=disable logging).\n");
+	fprintf(stderr, " --logging,-l: (off=disable logging, binary=log syscalls to trinity.trace instead of text logs).\n");
+	fprintf(stderr, " --decode-log=<file>: print a binary trace as text, then exit.\n");
 	fprintf(stderr, " --monochrome,-m: don't output ANSI codes\n");
 	fprintf(stderr, " --no_files,-n: Only pass sockets as fd's, not files\n");
+	fprintf(stderr, " --pipe-size=#: make the pipes this many bytes. (default: a mix of sizes)\n");
 	fprintf(stderr, " --proto,-P: specify specific network protocol for sockets.\n");
 	fprintf(stderr, " --quiet,-q: less output.\n");
+	fprintf(stderr, " --sockaddr-mismatch=#: %% of socket syscalls that get an address or fd of the wrong kind. (default 10)\n");
 	fprintf(stderr, " --random,-r#: pick N syscalls at random and just fuzz those\n");
+	fprintf(stderr, " --replay-from,-R#: start every child at syscall # of its random stream (use with -s).\n");
 	fprintf(stderr, " --syslog,-S: log important info to syslog. (useful if syslog is remote)\n");
+	fprintf(stderr, " --timeout-ms=#: how long syscalls that might block get before we interrupt them. (default 100)\n");
 	fprintf(stderr, " --verbose,-v: increase output verbosity.\n");
 	fprintf(stderr, " --victims,-V: path to victim files.\n");
 	fprintf(stderr, "\n");
@@ -67,22 +93,45 @@ static void usage(void)
 	exit(EXIT_SUCCESS);
 }
 
+/* long options without a short equivalent. */
+enum {
+	OPT_DECODE_LOG = 256,
+	OPT_FILE_WEIGHTS,
+	OPT_FILTER_FILES,
+	OPT_SOCKADDR_MISMATCH,
+	OPT_HARVEST_RATE,
+	OPT_FD_MISMATCH,
+	OPT_FD_SUCCESS_BIAS,
+	OPT_TIMEOUT_MS,
+	OPT_PIPE_SIZE,
+};
+
 static const struct option longopts[] = {
 	{ "children", required_argument, NULL, 'C' },
 	{ "dangerous", no_argument, NULL, 'd' },
 	{ "debug", no_argument, NULL, 'D' },
+	{ "decode-log", required_argument, NULL, OPT_DECODE_LOG },
 	{ "exclude", required_argument, NULL, 'x' },
+	{ "fd-mismatch", required_argument, NULL, OPT_FD_MISMATCH },
+	{ "fd-success-bias", required_argument, NULL, OPT_FD_SUCCESS_BIAS },
+	{ "file-weights", required_argument, NULL, OPT_FILE_WEIGHTS },
+	{ "filter-files", required_argument, NULL, OPT_FILTER_FILES },
 	{ "group", required_argument, NULL, 'g' },
+	{ "harvest-rate", required_argument, NULL, OPT_HARVEST_RATE },
 	{ "help", no_argument, NULL, 'h' },
 	{ "list", no_argument, NULL, 'L' },
 	{ "ioctls", no_argument, NULL, 'I' },
 	{ "logging", required_argument, NULL, 'l' },
 	{ "monochrome", no_argument, NULL, 'm' },
 	{ "no_files", no_argument, NULL, 'n' },
+	{ "pipe-size", required_argument, NULL, OPT_PIPE_SIZE },
 	{ "proto", required_argument, NULL, 'P' },
 	{ "random", required_argument, NULL, 'r' },
+	{ "replay-from", required_argument, NULL, 'R' },
 	{ "quiet", no_argument, NULL, 'q' },
+	{ "sockaddr-mismatch", required_argument, NULL, OPT_SOCKADDR_MISMATCH },
 	{ "syslog", no_argument, NULL, 'S' },
+	{ "timeout-ms", required_argument, NULL, OPT_TIMEOUT_MS },
 	{ "victims", required_argument, NULL, 'V' },
 	{ "verbose", no_argument, NULL, 'v' },
 	{ NULL, 0, NULL, 0 } };
@@ -92,7 +141,7 @@ void parse_args(int argc, char *argv[])
 {
 	int opt;
 
-	while ((opt = getopt_long(argc, argv, "c:C:dDg:hIl:LN:mnP:pqr:s:SV:vx:", longopts, NULL)) != -1) {
+	while ((opt = getopt_long(argc, argv, "c:C:dDg:hIl:LN:mnP:pqr:R:s:SV:vx:", longopts, NULL)) != -1) {
 		switch (opt) {
 		default:
 			if (opt == '?')
@@ -141,6 +190,11 @@ void parse_args(int argc, char *argv[])
 		case 'l':
 			if (!strcmp(optarg, "off"))
 				logging = 0;
+			/* the trace replaces the text logs, rather than adding to them. */
+			if (!strcmp(optarg, "binary")) {
+				logging = FALSE;
+				binary_logging = TRUE;
+			}
 			break;
 
 		case 'L':
@@ -157,7 +211,7 @@ void parse_args(int argc, char *argv[])
 
 		/* Set number of syscalls to do */
 		case 'N':
-			syscalls_todo = strtoll(optarg, NULL, 10) + 1;
+			syscalls_todo = strtoll(optarg, NULL, 10);
 			break;
 
 		/* Pause after each syscall */
@@ -184,6 +238,10 @@ void parse_args(int argc, char *argv[])
 			random_selection_num = strtol(optarg, NULL, 10);
 			break;
 
+		case 'R':
+			replay_from = strtoul(optarg, NULL, 10);
+			break;
+
 		/* Set seed */
 		case 's':
 			seed = strtol(optarg, NULL, 10);
@@ -208,6 +266,52 @@ void parse_args(int argc, char *argv[])
 			do_exclude_syscall = TRUE;
 			toggle_syscall(optarg, FALSE);
 			break;
+
+		case OPT_DECODE_LOG:
+			decode_log_file = optarg;
+			break;
+
+		case OPT_FILE_WEIGHTS:
+			parse_file_weights(optarg);
+			break;
+
+		case OPT_FILTER_FILES:
+			add_file_filter(optarg);
+			break;
+
+		case OPT_SOCKADDR_MISMATCH:
+			sockaddr_mismatch = strtoul(optarg, NULL, 10);
+			if (sockaddr_mismatch > 100)
+				sockaddr_mismatch = 100;
+			break;
+
+		case OPT_HARVEST_RATE:
+			harvest_rate = strtoul(optarg, NULL, 10);
+			if (harvest_rate > 100)
+				harvest_rate = 100;
+			break;
+
+		case OPT_FD_MISMATCH:
+			fd_mismatch = strtoul(optarg, NULL, 10);
+			if (fd_mismatch > 100)
+				fd_mismatch = 100;
+			break;
+
+		case OPT_FD_SUCCESS_BIAS:
+			fd_success_bias = strtoul(optarg, NULL, 10);
+			if (fd_success_bias > 100)
+				fd_success_bias = 100;
+			break;
+
+		case OPT_TIMEOUT_MS:
+			timeout_ms = strtoul(optarg, NULL, 10);
+			if (timeout_ms == 0)
+				timeout_ms = 1;
+			break;
+
+		case OPT_PIPE_SIZE:
+			pipe_size = strtoul(optarg, NULL, 10);
+			break;
 		}
 	}
 	if (quiet_level > MAX_LOGLEVEL)
@@ -2,7 +2,9 @@
 #include "shm.h"
 #include "params.h"	// for 'dangerous'
 #include "pids.h"
+#include "locks.h"
 #include "log.h"
+#include "random.h"
 
 int find_pid_slot(pid_t mypid)
 {
@@ -36,6 +38,41 @@ void dump_pid_slots(void)
 		printf("## slot%d: %d\n", i, shm->pids[i]);
 }
 
+/*
+ * running_childs counts the children in the pidmap, and the ones main has
+ * asked the zygote for that haven't taken their slot yet. If those ever
+ * disagree, we've leaked or lost a slot somewhere.
+ */
+bool check_pidmap(void)
+{
+	static bool complained = FALSE;
+	unsigned int i, running = 0, pending = 0, counted;
+
+	lock(&shm->reaper_lock);
+	for_each_pidslot(i) {
+		if (shm->pids[i] != EMPTY_PIDSLOT)
+			running++;
+		else if (shm->children[i].spawn_requested != 0)
+			pending++;
+	}
+	counted = shm->running_childs;
+	unlock(&shm->reaper_lock);
+
+	if (running + pending == counted) {
+		complained = FALSE;
+		return TRUE;
+	}
+
+	/* Once per time it goes wrong is enough, this gets called a lot. */
+	if (complained == TRUE)
+		return FALSE;
+	complained = TRUE;
+
+	output(0, "## pidmap has %u children and %u on the way, but running_childs is %u\n",
+		running, pending, counted);
+	return FALSE;
+}
+
 static pid_t pidmax;
 
 int read_pid_max(void)
@@ -100,9 +137,9 @@ unsigned int get_pid(void)
 	if (shm->running_childs == 0)
 		return 0;
 
-	switch (rand() % 3) {
+	switch (rnd_below(3)) {
 	case 0:
-retry:		i = rand() % shm->max_children;
+retry:		i = rnd_below(shm->max_children);
 		pid = shm->pids[i];
 		if (pid == EMPTY_PIDSLOT)
 			goto retry;
@@ -0,0 +1,199 @@
+/*
+ * The pipes every child shares.
+ *
+ * A pipe that's always empty or always full just makes reads or writes on
+ * it block until the timer goes off. So some ends are O_NONBLOCK, the pipes
+ * come in different sizes, and a thread in main keeps half of them about
+ * half full and drains the other half as soon as anything gets written, so
+ * there's usually data to read and room to write.
+ *
+ * The thread uses its own O_RDWR, O_NONBLOCK opens of each pipe (via
+ * /proc/self/fd), so it never blocks, and never changes the flags of the
+ * ends the children use.
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+#include "trinity.h"
+#include "shm.h"
+#include "files.h"
+#include "fdinfo.h"
+#include "log.h"
+#include "params.h"	// pipe_size
+#include "random.h"
+
+#define NR_PIPES (MAX_PIPE_FDS / 2)
+
+/* how often the full pipes get topped up, in milliseconds. */
+#define PIPE_FILL_INTERVAL 10
+
+/* Even pipes get kept about half full, odd ones get drained. */
+struct tended_pipe {
+	int fd;		/* our own O_RDWR open of it, or -1 */
+	int size;
+};
+
+static struct tended_pipe tended[NR_PIPES];
+
+static pthread_t pipe_thread;
+static volatile bool pipe_thread_stop = FALSE;
+static bool pipe_thread_running = FALSE;
+
+static const int pipe_sizes[] = { 4096, 16384, 65536, 262144, 1048576 };
+
+static void set_pipe_end(int fd)
+{
+	int flags;
+
+	if (rnd_below(2) == 0)
+		return;
+
+	flags = fcntl(fd, F_GETFL);
+	if (flags != -1)
+		(void)fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+static int set_pipe_size(int fd)
+{
+	int size = pipe_size;
+
+	if (size == 0)
+		size = pipe_sizes[rnd_below(ARRAY_SIZE(pipe_sizes))];
+
+	/* Bigger than /proc/sys/fs/pipe-max-size fails for users, so use what we got. */
+	(void)fcntl(fd, F_SETPIPE_SZ, size);
+	return fcntl(fd, F_GETPIPE_SZ);
+}
+
+static void fill_pipe(struct tended_pipe *p)
+{
+	static char buf[4096];
+	int queued;
+	ssize_t ret;
+
+	if (ioctl(p->fd, FIONREAD, &queued) == -1)
+		return;
+
+	while (queued < p->size / 2) {
+		ret = write(p->fd, buf, sizeof(buf));
+		if (ret <= 0)
+			return;
+		queued += ret;
+	}
+}
+
+static void drain_pipe(int fd)
+{
+	static char buf[4096];
+
+	while (read(fd, buf, sizeof(buf)) > 0)
+		;
+}
+
+/* Only syscalls in here, the zygote gets forked from main while this runs. */
+static void * tend_pipes(__unused__ void *arg)
+{
+	struct pollfd pfds[NR_PIPES / 2];
+	unsigned int i, nr_pfds = 0;
+
+	for (i = 1; i < NR_PIPES; i += 2) {
+		if (tended[i].fd == -1)
+			continue;
+		pfds[nr_pfds].fd = tended[i].fd;
+		pfds[nr_pfds].events = POLLIN;
+		nr_pfds++;
+	}
+
+	while (pipe_thread_stop == FALSE) {
+		for (i = 0; i < NR_PIPES; i += 2) {
+			if (tended[i].fd != -1)
+				fill_pipe(&tended[i]);
+		}
+
+		if (poll(pfds, nr_pfds, PIPE_FILL_INTERVAL) <= 0)
+			continue;
+
+		for (i = 0; i < nr_pfds; i++) {
+			if (pfds[i].revents & POLLIN)
+				drain_pipe(pfds[i].fd);
+		}
+	}
+	return NULL;
+}
+
+void open_pipes(void)
+{
+	struct tended_pipe *p;
+	char path[32];
+	int pipes[2];
+	unsigned int i, nr_tended = 0;
+
+	for (i = 0; i < NR_PIPES; i++) {
+		if (pipe(pipes) < 0) {
+			perror("pipe fail.\n");
+			exit(EXIT_FAILURE);
+		}
+		shm->pipe_fds[i * 2] = pipes[0];
+		shm->pipe_fds[(i * 2) + 1] = pipes[1];
+
+		p = &tended[i];
+		p->size = set_pipe_size(pipes[1]);
+
+		set_pipe_end(pipes[0]);
+		set_pipe_end(pipes[1]);
+		register_fd(pipes[0]);
+		register_fd(pipes[1]);
+
+		output(2, "fd[%d] = pipe\n", pipes[0]);
+		output(2, "fd[%d] = pipe\n", pipes[1]);
+
+		sprintf(path, "/proc/self/fd/%d", pipes[0]);
+		p->fd = open(path, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+		if (p->fd != -1)
+			nr_tended++;
+	}
+
+	if (nr_tended == 0)
+		return;
+
+	if (pthread_create(&pipe_thread, NULL, tend_pipes, NULL) != 0) {
+		output(0, "Couldn't start the pipe thread: %s\n", strerror(errno));
+		return;
+	}
+	pipe_thread_running = TRUE;
+
+	output(1, "%u pipes, keeping %u of them filled or drained.\n", NR_PIPES, nr_tended);
+}
+
+/* Mostly the read end of a pipe we keep data in, sometimes any pipe fd. */
+int get_pipe_reader(void)
+{
+	if (rnd_below(4) == 0)
+		return shm->pipe_fds[rnd_below(MAX_PIPE_FDS)];
+	return shm->pipe_fds[rnd_below(NR_PIPES / 2) * 4];
+}
+
+/* Mostly the write end of a pipe we keep drained, sometimes any pipe fd. */
+int get_pipe_writer(void)
+{
+	if (rnd_below(4) == 0)
+		return shm->pipe_fds[rnd_below(MAX_PIPE_FDS)];
+	return shm->pipe_fds[(rnd_below(NR_PIPES / 2) * 4) + 3];
+}
+
+void stop_pipes(void)
+{
+	if (pipe_thread_running == FALSE)
+		return;
+
+	pipe_thread_stop = TRUE;
+	pthread_join(pipe_thread, NULL);
+	pipe_thread_running = FALSE;
+}
@@ -10,6 +10,7 @@
 #include "log.h"
 #include "maps.h"
 #include "shm.h"
+#include "random.h"
 
 static bool within_page(void *addr, void *check)
 {
@@ -42,9 +43,9 @@ static void * _get_address(unsigned char null_allowed)
 	void *addr = NULL;
 
 	if (null_allowed == TRUE)
-		i = rand() % 9;
+		i = rnd_below(9);
 	else
-		i = (rand() % 8) + 1;
+		i = rnd_below(8) + 1;
 
 
 	switch (i) {
@@ -80,7 +81,7 @@ static void * _get_address(unsigned char null_allowed)
 	 * But sometimes, we return an address just before the end of the page.
 	 * The idea here is that we might see some bugs that are caused by page boundary failures.
 	 */
-	i = rand() % 100;
+	i = rnd_below(100);
 	switch (i) {
 	case 0:	addr += (page_size - sizeof(char));
 		break;
@@ -110,32 +111,33 @@ void * get_non_null_address(void)
 
 unsigned long find_previous_arg_address(unsigned int argnum, unsigned int call, int childno)
 {
+	struct childdata *child = &shm->children[childno];
 	unsigned long addr = 0;
 
 	if (argnum > 1)
 		if ((syscalls[call].entry->arg1type == ARG_ADDRESS) ||
 		    (syscalls[call].entry->arg1type == ARG_NON_NULL_ADDRESS))
-			addr = shm->a1[childno];
+			addr = child->a1;
 
 	if (argnum > 2)
 		if ((syscalls[call].entry->arg2type == ARG_ADDRESS) ||
 		    (syscalls[call].entry->arg2type == ARG_NON_NULL_ADDRESS))
-			addr = shm->a2[childno];
+			addr = child->a2;
 
 	if (argnum > 3)
 		if ((syscalls[call].entry->arg3type == ARG_ADDRESS) ||
 		    (syscalls[call].entry->arg3type == ARG_NON_NULL_ADDRESS))
-			addr = shm->a3[childno];
+			addr = child->a3;
 
 	if (argnum > 4)
 		if ((syscalls[call].entry->arg4type == ARG_ADDRESS) ||
 		    (syscalls[call].entry->arg4type == ARG_NON_NULL_ADDRESS))
-			addr = shm->a4[childno];
+			addr = child->a4;
 
 	if (argnum > 5)
 		if ((syscalls[call].entry->arg5type == ARG_ADDRESS) ||
 		    (syscalls[call].entry->arg5type == ARG_NON_NULL_ADDRESS))
-			addr = shm->a5[childno];
+			addr = child->a5;
 
 	return addr;
 }
@@ -17,7 +17,7 @@ unsigned long get_len(void)
 	if (i == 0)
 		return 0;
 
-	switch (rand() % 6) {
+	switch (rnd_below(6)) {
 
 	case 0:	i &= 0xff;
 		break;
@@ -39,8 +39,8 @@ unsigned long get_len(void)
 		return 0;
 
 	/* we might get lucky if something is counting ints/longs etc. */
-	if (rand() % 100 < 25) {
-		switch (rand() % 3) {
+	if (rnd_below(100) < 25) {
+		switch (rnd_below(3)) {
 		case 0:	i /= sizeof(int);
 			break;
 		case 1:	i /= sizeof(long);
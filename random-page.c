@@ -1,9 +1,11 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "arch.h"	// page_size
 #include "sanitise.h"	// interesting_*
 #include "log.h"	// For BUG
+#include "random.h"
 
 static void fabricate_onepage_struct(char *page)
 {
@@ -12,7 +14,7 @@ static void fabricate_onepage_struct(char *page)
 
 	for (i = 0; i < page_size; ) {
 		ptr = (void*)&page[i];
-		switch (rand() % 4) {
+		switch (rnd_below(4)) {
 		case 0:
 			i += sizeof(unsigned int);
 			if (i > page_size)
@@ -35,7 +37,7 @@ static void fabricate_onepage_struct(char *page)
 			i += sizeof(unsigned int);
 			if (i > page_size)
 				return;
-			*(unsigned int *)ptr = rand() % page_size;
+			*(unsigned int *)ptr = rnd_below(page_size);
 			break;
 		default:
 			BUG("unreachable!\n");
@@ -46,19 +48,22 @@ static void fabricate_onepage_struct(char *page)
 
 void generate_random_page(char *page)
 {
+	uint64_t r;
 	unsigned int i;
 
-	switch (rand() % 6) {
+	switch (rnd_below(6)) {
 	/* return a page of complete trash */
 	case 0:	/* bytes */
-		for (i = 0; i < page_size; )
-			page[i++] = (unsigned char)rand();
+		for (i = 0; i < page_size; i += sizeof(r)) {
+			r = prng_next();
+			memcpy(&page[i], &r, sizeof(r));
+		}
 		return;
 
 	case 1:	/* words */
 		for (i = 0; i < (page_size / 2); ) {
 			page[i++] = 0;
-			page[i++] = (unsigned char)rand();
+			page[i++] = (unsigned char)rnd();
 		}
 		return;
 
@@ -67,7 +72,7 @@ void generate_random_page(char *page)
 			page[i++] = 0;
 			page[i++] = 0;
 			page[i++] = 0;
-			page[i++] = (unsigned char)rand();
+			page[i++] = (unsigned char)rnd();
 		}
 		return;
 
@@ -82,7 +87,7 @@ void generate_random_page(char *page)
 	/* page of 0's and 1's. */
 	case 5:
 		for (i = 0; i < page_size; )
-			page[i++] = (unsigned char)rand() % 2;
+			page[i++] = (unsigned char)rnd_below(2);
 		return;
 
 	default:
@@ -22,13 +22,15 @@
 
 static void choose_syscall_table(int childno)
 {
+	struct childdata *child = &shm->children[childno];
+
 	if (biarch == TRUE) {
 
 		/* First, check that we have syscalls enabled in either table. */
 		if (validate_syscall_table_64() == FALSE) {
 			use_64bit = FALSE;
 			/* If no 64bit syscalls enabled, force 32bit. */
-			shm->do32bit[childno] = TRUE;
+			child->do32bit = TRUE;
 		}
 
 		if (validate_syscall_table_32() == FALSE)
@@ -39,15 +41,15 @@ static void choose_syscall_table(int childno)
 			/*
 			 * 10% possibility of a 32bit syscall
 			 */
-			shm->do32bit[childno] = FALSE;
+			child->do32bit = FALSE;
 
 // FIXME: I forgot why this got disabled. Revisit.
-//			if (rand() % 100 < 10)
-//				shm->do32bit[childno] = TRUE;
+//			if (rnd_below(100) < 10)
+//				child->do32bit = TRUE;
 		}
 
 
-		if (shm->do32bit[childno] == FALSE) {
+		if (child->do32bit == FALSE) {
 			syscalls = syscalls_64bit;
 			max_nr_syscalls = max_nr_64bit_syscalls;
 		} else {
@@ -64,11 +66,14 @@ static void choose_syscall_table(int childno)
 
 int do_random_syscalls(int childno)
 {
+	struct childdata *child = &shm->children[childno];
 	pid_t pid = getpid();
 	int ret;
-	unsigned int syscallnr;
+	int syscallnr;
 
-	sigsetjmp(ret_jump, 1);
+	/* We come back here when the alarm interrupts a syscall that blocked. */
+	if (sigsetjmp(ret_jump, 1) != 0)
+		syscall_timed_out(childno);
 
 	ret = 0;
 
@@ -76,50 +81,42 @@ int do_random_syscalls(int childno)
 
 		check_parent_pid();
 
-		while (shm->regenerating == TRUE)
-			sleep(1);
-
 		/* If the parent reseeded, we should reflect the latest seed too. */
-		if (shm->seed != shm->seeds[childno])
+		if (shm->seed != child->seed)
 			set_seed(childno);
 
-		choose_syscall_table(childno);
+		seed_syscall(childno);
 
-		//FIXME: This 'loop' here is pretty gross. If we're just fuzzing
-		// a few syscalls, we can spin here for quite a while.
-		// a better way would be to do something in tables.c where we construct
-		// our own syscall table just containing enabled syscalls.
-retry:
-		if (no_syscalls_enabled() == TRUE) {
-			shm->exit_reason = EXIT_NO_SYSCALLS_ENABLED;
-			goto out;
-		}
+		choose_syscall_table(childno);
 
 		if (shm->exit_reason != STILL_RUNNING)
 			goto out;
 
-		syscallnr = rand() % max_nr_syscalls;
-
-		if (!(syscalls[syscallnr].entry->flags & ACTIVE))
-			goto retry;
-
-		if (validate_specific_syscall_silent(syscalls, syscallnr) == FALSE)
-			goto retry;
-
-		/* if we get here, syscallnr is finally valid */
+		syscallnr = pick_random_syscall(child->do32bit);
+		if (syscallnr == -1) {
+			shm->exit_reason = EXIT_NO_SYSCALLS_ENABLED;
+			goto out;
+		}
 
-		shm->syscallno[childno] = syscallnr;
+		child->syscallno = syscallnr;
 
+		/*
+		 * The per-child counters aren't summed on every call, so to stop
+		 * at exactly -N each child takes a ticket before doing a syscall.
+		 * -N counts syscalls that came back or timed out. If the child
+		 * dies in between, main gives the ticket back (see reap_child).
+		 */
 		if (syscalls_todo) {
-			if (shm->total_syscalls_done >= syscalls_todo) {
-				output(0, "[%d] shm->total_syscalls_done (%d) >= syscalls_todo (%d)\n",
-					pid, shm->total_syscalls_done,syscalls_todo);
+			unsigned long ticket = __sync_fetch_and_add(&shm->syscalls_claimed, 1);
+
+			if (ticket >= syscalls_todo) {
+				if (ticket == syscalls_todo)
+					printf("[%d] Reached maximum syscall count %ld\n",
+						pid, syscalls_todo);
 				shm->exit_reason = EXIT_REACHED_COUNT;
+				goto out;
 			}
-
-			if (shm->total_syscalls_done == syscalls_todo)
-				printf("[%d] Reached maximum syscall count %ld\n",
-					pid, shm->total_syscalls_done);
+			child->holds_ticket = TRUE;
 		}
 
 		ret = mkcall(childno);
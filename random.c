@@ -12,11 +12,39 @@
 #include "params.h"	// 'user_set_seed'
 #include "log.h"
 #include "sanitise.h"
+#include "random.h"
 
 /* The actual seed lives in the shm. This variable is used
  * to store what gets passed in from the command line -s argument */
 unsigned int seed = 0;
 
+/*
+ * Until set_seed() gets called, run from a fixed state (xoshiro must never
+ * be all zeros), much like rand() behaves as if srand(1) had been called.
+ */
+uint64_t prng_state[4] = {
+	0x9e3779b97f4a7c15ULL, 0xbf58476d1ce4e5b9ULL,
+	0x94d049bb133111ebULL, 0x2545f4914f6cdd1dULL,
+};
+
+/*
+ * Expand a seed into the full generator state with splitmix64, so that
+ * nearby seeds (like the seed+pidslot of neighbouring children) still end up
+ * with unrelated streams.
+ */
+void prng_seed(uint64_t s)
+{
+	unsigned int i;
+
+	for (i = 0; i < 4; i++) {
+		uint64_t z = (s += 0x9e3779b97f4a7c15ULL);
+
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+		prng_state[i] = z ^ (z >> 31);
+	}
+}
+
 static void syslog_seed(int seedparam)
 {
 	fprintf(stderr, "Randomness reseeded to %u\n", seedparam);
@@ -33,8 +61,8 @@ unsigned int new_seed(void)
 
 	if ((fd = open("/dev/urandom", O_RDONLY)) < 0 ||
 	    read(fd, &r, sizeof(r)) != sizeof(r)) {
-		r = rand();
-		if (!(rand() % 2)) {
+		r = prng_next();
+		if (!rand_bool()) {
 			gettimeofday(&t, 0);
 			r |= t.tv_usec;
 		}
@@ -69,8 +97,32 @@ unsigned int init_seed(unsigned int seedparam)
  */
 void set_seed(unsigned int pidslot)
 {
-	srand(shm->seed + (pidslot + 1));
-	shm->seeds[pidslot] = shm->seed;
+	prng_seed(shm->seed + (pidslot + 1));
+	shm->children[pidslot].seed = shm->seed;
+}
+
+/*
+ * How many values a syscall consumes depends on which syscall got picked and
+ * what its sanitise routine did, so we can't skip ahead N syscalls by jumping
+ * a single long stream. Instead every syscall gets a fresh stream derived from
+ * (seed, pidslot, position), which means a replay can start a child at any
+ * position directly.
+ */
+void seed_syscall(unsigned int pidslot)
+{
+	struct childdata *child = &shm->children[pidslot];
+	uint64_t key;
+
+	key = ((uint64_t) child->seed << 32) | (pidslot + 1);
+	key ^= child->stream_pos * 0xd1342543de82ef95ULL;
+	prng_seed(key);
+
+	if ((child->stream_pos % CHECKPOINT_INTERVAL) == 0) {
+		output(1, "[%d] checkpoint: seed %u pidslot %u syscall %lu\n",
+			getpid(), child->seed, pidslot, child->stream_pos);
+	}
+
+	child->stream_pos++;
 }
 
 /*
@@ -105,32 +157,32 @@ void reseed(void)
 
 unsigned int rand_bool(void)
 {
-	return rand() % 2;
+	return prng_next() >> 63;
 }
 
 unsigned int rand_single_32bit(void)
 {
-	return (1L << (rand() % 32));
+	return (1L << rnd_below(32));
 }
 
 unsigned long rand_single_64bit(void)
 {
-	return (1L << (rand() % 64));
+	return (1L << rnd_below(64));
 }
 
 unsigned int rand32(void)
 {
 	unsigned long r = 0;
 	unsigned int i;
-	unsigned int rounds = rand() % 3;
+	unsigned int rounds = rnd_below(3);
 
-	switch (rand() % 3) {
+	switch (rnd_below(3)) {
 	/* Just set one bit */
 	case 0: r = rand_single_32bit();
 		break;
 
 	/* 0 .. RAND_MAX */
-	case 1: r = rand();
+	case 1: r = rnd();
 		break;
 
 	case 2:	return get_interesting_32bit_value();
@@ -141,18 +193,18 @@ unsigned int rand32(void)
 	/* now mangle it. */
 	for (i = 0; i < rounds; i++) {
 
-		switch (rand() % 4) {
+		switch (rnd_below(4)) {
 
-		case 0: r &= rand();
+		case 0: r &= rnd();
 			break;
 
-		case 1: r |= rand();
+		case 1: r |= rnd();
 			break;
 
-		case 2: r >>= (rand() % 31);
+		case 2: r >>= rnd_below(31);
 			break;
 
-		case 3: r ^= rand();
+		case 3: r ^= rnd();
 			break;
 
 		default:
@@ -167,7 +219,7 @@ unsigned int rand32(void)
 		r |= (1L << 31);
 
 	/* limit the size */
-	switch (rand() % 4) {
+	switch (rnd_below(4)) {
 	case 0: r &= 0xff;
 		break;
 	case 1: r &= 0xffff;
@@ -185,7 +237,7 @@ unsigned long rand64(void)
 {
 	unsigned long r = 0;
 
-	switch (rand() % 7) {
+	switch (rnd_below(7)) {
 
 	/* Just set one bit */
 	case 0:	return rand_single_32bit();
@@ -195,34 +247,22 @@ unsigned long rand64(void)
 	case 2:	return get_interesting_value();
 
 	/* limit to RAND_MAX (31 bits) */
-	case 3:	r = rand();
+	case 3:	r = rnd();
 		break;
 
-	 /* do some gymnastics here to get > RAND_MAX
+	 /* full width values, biased towards fewer/more bits being set.
 	  * Based on very similar routine stolen from iknowthis. Thanks Tavis.
 	  */
 	case 4:
-		r = rand() & rand();
-#if __WORDSIZE == 64
-		r <<= 32;
-		r |= rand() & rand();
-#endif
+		r = prng_next() & prng_next();
 		break;
 
 	case 5:
-		r = rand() | rand();
-#if __WORDSIZE == 64
-		r <<= 32;
-		r |= rand() | rand();
-#endif
+		r = prng_next() | prng_next();
 		break;
 
 	case 6:
-		r = rand();
-#if __WORDSIZE == 64
-		r <<= 32;
-		r |= rand();
-#endif
+		r = prng_next();
 		break;
 
 	default:
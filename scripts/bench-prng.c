@@ -0,0 +1,77 @@
+/*
+ * Compare the per-value cost of glibc rand() against our own generator.
+ *
+ * gcc -O2 -I include scripts/bench-prng.c -o bench-prng
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "random.h"
+
+#define LOOPS 100000000UL
+
+uint64_t prng_state[4] = {
+	0x9e3779b97f4a7c15ULL, 0xbf58476d1ce4e5b9ULL,
+	0x94d049bb133111ebULL, 0x2545f4914f6cdd1dULL,
+};
+
+static volatile unsigned long sink;
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void report(const char *name, double start)
+{
+	printf("%-20s %6.2f ns/value\n", name, (now() - start) * 1e9 / LOOPS);
+}
+
+int main(void)
+{
+	unsigned long i, acc;
+	double start;
+
+	srand(1);
+
+	acc = 0;
+	start = now();
+	for (i = 0; i < LOOPS; i++)
+		acc += rand();
+	sink = acc;
+	report("rand()", start);
+
+	acc = 0;
+	start = now();
+	for (i = 0; i < LOOPS; i++)
+		acc += rand() % 13;
+	sink = acc;
+	report("rand() % 13", start);
+
+	acc = 0;
+	start = now();
+	for (i = 0; i < LOOPS; i++)
+		acc += rnd();
+	sink = acc;
+	report("rnd()", start);
+
+	acc = 0;
+	start = now();
+	for (i = 0; i < LOOPS; i++)
+		acc += rnd_below(13);
+	sink = acc;
+	report("rnd_below(13)", start);
+
+	acc = 0;
+	start = now();
+	for (i = 0; i < LOOPS; i++)
+		acc += prng_next();
+	sink = acc;
+	report("prng_next() (64bit)", start);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,33 @@
+#!/bin/bash
+#
+# Run a fixed number of cheap syscalls with an increasing number of children
+# and report the throughput of each run. Useful for spotting contention on
+# state that is shared between the children.
+#
+# usage: bench-scaling.sh [max children] [syscalls per run]
+
+TRINITY=${TRINITY:-../trinity}
+MAX_CHILDREN=${1:-$(grep ^processor /proc/cpuinfo | /usr/bin/wc -l)}
+COUNT=${2:-1000000}
+
+if [ ! -x $TRINITY ]; then
+  echo "Can't find $TRINITY (set TRINITY=/path/to/trinity)"
+  exit 1
+fi
+
+if [ ! -d tmp ]; then
+  mkdir tmp
+fi
+chmod 755 tmp
+cd tmp
+
+printf "%8s %10s %12s\n" children seconds syscalls/sec
+
+for i in `seq 1 $MAX_CHILDREN`
+do
+  START=$(date +%s.%N)
+  $TRINITY -q -l off -m -c getpid -c getppid -c getuid -N $COUNT -C $i > /dev/null 2>&1
+  END=$(date +%s.%N)
+
+  echo "$i $START $END $COUNT" | awk '{ t = $3 - $2; printf "%8d %10.2f %12d\n", $1, t, $4 / t }'
+done
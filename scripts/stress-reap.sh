@@ -0,0 +1,81 @@
+#!/bin/bash
+#
+# Kill children as fast as we can for a while, then stop trinity, and check
+# that it kept track of its pid slots: main complains if running_childs and
+# the pidmap ever disagree, and nothing should be left running afterwards.
+#
+# usage: stress-reap.sh [seconds] [children]
+
+TRINITY=${TRINITY:-../trinity}
+DURATION=${1:-20}
+CHILDREN=${2:-16}
+
+if [ ! -x $TRINITY ]; then
+  echo "Can't find $TRINITY (set TRINITY=/path/to/trinity)"
+  exit 1
+fi
+
+if [ ! -d tmp ]; then
+  mkdir tmp
+fi
+chmod 755 tmp
+cd tmp
+
+LOG=stress-reap.log
+
+$TRINITY -q -l off -m -c read -c write -C $CHILDREN > $LOG 2>&1 &
+TRINITY_PID=$!
+
+# give it time to start its children.
+sleep 2
+
+KILLS=0
+END=$(($(date +%s) + $DURATION))
+while [ $(date +%s) -lt $END ]
+do
+  if ! kill -0 $TRINITY_PID 2>/dev/null; then
+    echo "FAIL: trinity exited while we were still killing children"
+    tail $LOG
+    exit 1
+  fi
+  for pid in $(pgrep '^trinity-child')
+  do
+    kill -KILL $pid 2>/dev/null && KILLS=$(($KILLS + 1))
+  done
+done
+
+kill -INT $TRINITY_PID
+wait $TRINITY_PID
+STATUS=$?
+
+FAILED=0
+
+if [ $STATUS -ne 0 ]; then
+  echo "FAIL: trinity exited with status $STATUS"
+  FAILED=1
+fi
+
+if grep -q "^## pidmap has" $LOG; then
+  echo "FAIL: slot accounting went wrong:"
+  grep "^## pidmap has" $LOG | sort | uniq -c
+  FAILED=1
+fi
+
+if grep -q "## Pid map was full" $LOG; then
+  echo "FAIL: ran out of pid slots"
+  FAILED=1
+fi
+
+sleep 1
+LEFT=$(pgrep '^trinity' | wc -l)
+if [ $LEFT -ne 0 ]; then
+  echo "FAIL: $LEFT trinity processes still running:"
+  pgrep -a '^trinity'
+  FAILED=1
+fi
+
+echo "Killed $KILLS children in $DURATION seconds."
+if [ $FAILED -eq 0 ]; then
+  echo "PASS"
+fi
+exit $FAILED
@@ -6,9 +6,13 @@
 #include "params.h"	// debug
 #include "signals.h"
 #include "shm.h"
+#include "files.h"
 
 jmp_buf ret_jump;
 
+/* set while a NEED_ALARM syscall is running, see do_syscall() */
+volatile sig_atomic_t in_timed_syscall = FALSE;
+
 static void ctrlc_handler(__unused__ int sig)
 {
 	shm->exit_reason = EXIT_SIGINT;
@@ -18,8 +22,13 @@ static void sighandler(int sig)
 {
 	switch (sig) {
 	case SIGALRM:
+		/* The syscall came back just as the timer went off. */
+		if (in_timed_syscall == FALSE)
+			break;
+		in_timed_syscall = FALSE;
+
 		/* if we blocked in read() or similar, we want to avoid doing it again. */
-		shm->fd_lifetime = 0;
+		drop_sticky_fd();
 
 		(void)signal(sig, sighandler);
 		siglongjmp(ret_jump, 1);
@@ -46,6 +55,10 @@ void mask_signals_child(void)
 	/* we want default behaviour for child process signals */
 	(void)signal(SIGCHLD, SIG_DFL);
 
+	/* main blocks SIGCHLD and SIGINT to read them from a signalfd. We want them back. */
+	(void)sigemptyset(&ss);
+	(void)sigprocmask(SIG_SETMASK, &ss, NULL);
+
 	/* ignore signals we don't care about */
 	(void)signal(SIGFPE, SIG_IGN);
 	(void)signal(SIGXCPU, SIG_IGN);
@@ -64,6 +77,9 @@ void mask_signals_child(void)
 
 	/* trap ctrl-c */
 	(void)signal(SIGINT, ctrlc_handler);
+
+	/* If the zygote dies, we find out from a failed write, not by dying too. */
+	(void)signal(SIGPIPE, SIG_IGN);
 }
 
 
@@ -7,6 +7,10 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/utsname.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <time.h>
 
 #include "trinity.h"
 #include "sanitise.h"
@@ -15,13 +19,48 @@
 #include "net.h"
 #include "log.h"
 #include "params.h"	// victim_path, verbose, do_specific_proto
+#include "random.h"
+#include "fdinfo.h"
 
 unsigned int nr_sockets = 0;
 
+/*
+ * Once they're all open, shm->sockets gets sorted by domain, so each family
+ * is one run of it. Sanitisers pick a family, then a socket in it, so the
+ * families we only got a couple of sockets for still get a look in.
+ */
+static unsigned int family_start[TRINITY_PF_MAX];
+static unsigned int family_count[TRINITY_PF_MAX];
+static unsigned int families[TRINITY_PF_MAX];
+static unsigned int nr_families = 0;
+
 static const char *cachefilename="trinity.socketcache";
 
-#define MAX_PER_DOMAIN 5
-#define MAX_TRIES_PER_DOMAIN 10
+/*
+ * Which (domain, type, protocol) triples this kernel will give us a socket
+ * for. Finding out means trying them all, which takes a while (and may load
+ * a lot of modules), so it's done once, in parallel, and the answer kept in
+ * the cachefile for as long as we're running on the same kernel as the same
+ * user. The pool of sockets is then built from triples known to work.
+ */
+#define NR_TRIPLES (TRINITY_PF_MAX * TYPE_MAX * PROTO_MAX)
+#define TRIPLE(domain, type, protocol) ((((domain) * TYPE_MAX) + (type)) * PROTO_MAX + (protocol))
+
+static unsigned char viable[NR_TRIPLES / 8];
+static unsigned int viable_in_domain[TRINITY_PF_MAX];
+
+#define SOCKETCACHE_MAGIC	0x4b434f53	/* "SOCK" */
+#define SOCKETCACHE_VERSION	2
+
+struct socketcache_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t uid;
+	uint32_t nr_domains;
+	uint32_t nr_types;
+	uint32_t nr_protos;
+	char release[sizeof(((struct utsname *) 0)->release)];
+};
 
 static int open_socket(unsigned int domain, unsigned int type, unsigned int protocol)
 {
@@ -33,7 +72,10 @@ static int open_socket(unsigned int domain, unsigned int type, unsigned int prot
 	if (fd == -1)
 		return fd;
 
-	shm->socket_fds[nr_sockets] = fd;
+	shm->sockets[nr_sockets].fd = fd;
+	shm->sockets[nr_sockets].domain = domain;
+	shm->sockets[nr_sockets].type = type;
+	shm->sockets[nr_sockets].protocol = protocol;
 
 	output(2, "fd[%i] = domain:%i (%s) type:0x%x protocol:%i\n",
 		fd, domain, get_proto_name(domain), type, protocol);
@@ -41,7 +83,7 @@ static int open_socket(unsigned int domain, unsigned int type, unsigned int prot
 	nr_sockets++;
 
 	/* Sometimes, listen on created sockets. */
-	if (rand() % 2) {
+	if (rnd_below(2)) {
 		__unused__ int ret;
 
 		/* fake a sockaddr. */
@@ -53,7 +95,7 @@ static int open_socket(unsigned int domain, unsigned int type, unsigned int prot
 		else
 			printf("bind: success!\n");
 */
-		ret = listen(fd, (rand() % 2) + 1);
+		ret = listen(fd, rnd_below(2) + 1);
 /*		if (ret == -1)
 			printf("listen: %s\n", strerror(errno));
 		else
@@ -64,193 +106,347 @@ static int open_socket(unsigned int domain, unsigned int type, unsigned int prot
 	return fd;
 }
 
-void generate_sockets(void)
+static bool is_viable(unsigned int domain, unsigned int type, unsigned int protocol)
 {
-	struct flock fl = {
-		.l_type = F_WRLCK,
-		.l_whence = SEEK_SET,
-	};
-
-	int fd, n;
-	int cachefile;
-	unsigned int nr_to_create = NR_SOCKET_FDS;
-
-	unsigned long domain, type, protocol;
-	unsigned int buffer[3];
-
-	cachefile = creat(cachefilename, S_IWUSR|S_IRUSR);
-	if (cachefile < 0) {
-		printf("Couldn't open cachefile for writing! (%s)\n",
-			strerror(errno));
-		exit(EXIT_FAILURE);
-	}
+	unsigned int i = TRIPLE(domain, type, protocol);
+
+	return (viable[i / 8] & (1 << (i % 8))) ? TRUE : FALSE;
+}
+
+static void count_viable(void)
+{
+	unsigned int domain, type, protocol;
 
-	if (verbose)
-		output(2, "taking writer lock for cachefile\n");
-	fl.l_pid = getpid();
-	fl.l_type = F_WRLCK;
-	if (fcntl(cachefile, F_SETLKW, &fl) == -1) {
-		perror("fcntl F_WRLCK F_SETLKW");
-		exit(EXIT_FAILURE);
+	for (domain = 0; domain < TRINITY_PF_MAX; domain++) {
+		viable_in_domain[domain] = 0;
+		for (type = 0; type < TYPE_MAX; type++) {
+			for (protocol = 0; protocol < PROTO_MAX; protocol++) {
+				if (is_viable(domain, type, protocol) == TRUE)
+					viable_in_domain[domain]++;
+			}
+		}
 	}
+}
 
-	if (verbose)
-		output(2, "took writer lock for cachefile\n");
+/* If the kernel doesn't know the family at all, there's no point trying every type and protocol. */
+static bool family_missing(unsigned int domain)
+{
+	unsigned int type;
+	int fd;
 
-	while (nr_to_create > 0) {
+	for (type = 0; type < TYPE_MAX; type++) {
+		fd = socket(domain, type, 0);
+		if (fd != -1) {
+			close(fd);
+			return FALSE;
+		}
+		if (errno != EAFNOSUPPORT)
+			return FALSE;
+	}
+	return TRUE;
+}
 
-		if (shm->exit_reason != STILL_RUNNING)
-			return;
+static unsigned int next_domain;
 
-		/* Pretend we're child 0 and we've called sys_socket */
-		sanitise_socket(0);
+static void * probe_thread(__unused__ void *arg)
+{
+	unsigned int domain, type, protocol, i;
+	int fd;
 
-		domain = shm->a1[0];
-		type = shm->a2[0];
-		protocol = shm->a3[0];
+	while ((domain = __sync_fetch_and_add(&next_domain, 1)) < TRINITY_PF_MAX) {
+		if (family_missing(domain) == TRUE)
+			continue;
 
-		fd = open_socket(domain, type, protocol);
-		if (fd > -1) {
-			nr_to_create--;
+		for (type = 0; type < TYPE_MAX; type++) {
+			for (protocol = 0; protocol < PROTO_MAX; protocol++) {
+				if (shm->exit_reason != STILL_RUNNING)
+					return NULL;
 
-			buffer[0] = domain;
-			buffer[1] = type;
-			buffer[2] = protocol;
-			n = write(cachefile, &buffer, sizeof(int) * 3);
-			if (n == -1) {
-				printf("something went wrong writing the cachefile!\n");
-				exit(EXIT_FAILURE);
-			}
+				fd = socket(domain, type, protocol);
+				if (fd == -1)
+					continue;
+				close(fd);
 
-			if (nr_to_create == 0)
-				goto done;
+				i = TRIPLE(domain, type, protocol);
+				__sync_fetch_and_or(&viable[i / 8], 1 << (i % 8));
+			}
 		}
+	}
+	return NULL;
+}
 
-		/* check for ctrl-c */
-		if (shm->exit_reason != STILL_RUNNING)
-			return;
+static void probe_sockets(void)
+{
+	pthread_t threads[TRINITY_PF_MAX];
+	struct timespec start, end;
+	unsigned int i, n, nr_threads;
+	long cpus, ms;
 
-		//FIXME: If we've passed -P and we're spinning here without making progress
-		// then we should abort after a few hundred loops.
-	}
+	cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if (cpus < 1)
+		cpus = 1;
+	if (cpus > TRINITY_PF_MAX)
+		cpus = TRINITY_PF_MAX;
+
+	memset(viable, 0, sizeof(viable));
+	next_domain = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
 
-done:
-	fl.l_type = F_UNLCK;
-	if (fcntl(cachefile, F_SETLK, &fl) == -1) {
-		perror("fcntl F_SETLK");
-		exit(1);
+	for (i = 1; i < cpus; i++) {
+		if (pthread_create(&threads[i], NULL, probe_thread, NULL) != 0)
+			break;
 	}
+	nr_threads = i;
+	probe_thread(NULL);
+	for (i = 1; i < nr_threads; i++)
+		pthread_join(threads[i], NULL);
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	ms = ((end.tv_sec - start.tv_sec) * 1000) + ((end.tv_nsec - start.tv_nsec) / 1000000);
 
-	if (verbose)
-		output(2, "dropped writer lock for cachefile\n");
-	output(1, "created %d sockets\n", nr_sockets);
+	count_viable();
+	for (i = 0, n = 0; i < TRINITY_PF_MAX; i++)
+		n += viable_in_domain[i];
 
-	close(cachefile);
+	output(0, "Probed %d socket types in %ld.%03lds (%u threads), %u of them work.\n",
+		NR_TRIPLES, ms / 1000, ms % 1000, nr_threads, n);
 }
 
+static void describe_cache(struct socketcache_header *hdr)
+{
+	struct utsname u;
+
+	memset(hdr, 0, sizeof(struct socketcache_header));
+	hdr->magic = SOCKETCACHE_MAGIC;
+	hdr->version = SOCKETCACHE_VERSION;
+	hdr->uid = getuid();
+	hdr->nr_domains = TRINITY_PF_MAX;
+	hdr->nr_types = TYPE_MAX;
+	hdr->nr_protos = PROTO_MAX;
+	if (uname(&u) == 0)
+		memcpy(hdr->release, u.release, sizeof(hdr->release) - 1);
+}
 
-static void close_sockets(void)
+static bool load_socketcache(void)
 {
-	unsigned int i;
+	struct socketcache_header hdr, want;
 	int fd;
 
-	for (i = 0; i < nr_sockets; i++) {
-		fd = shm->socket_fds[i];
-		shm->socket_fds[i] = 0;
-		if (close(fd) != 0) {
-			printf("failed to close socket.(%s)\n", strerror(errno));
-		}
+	fd = open(cachefilename, O_RDONLY);
+	if (fd == -1)
+		return FALSE;
+
+	describe_cache(&want);
+
+	if (read(fd, &hdr, sizeof(hdr)) != sizeof(hdr) ||
+	    memcmp(&hdr, &want, sizeof(hdr)) != 0) {
+		output(0, "%s is from another kernel or user, probing again.\n", cachefilename);
+		close(fd);
+		return FALSE;
 	}
 
-	nr_sockets = 0;
+	if (read(fd, viable, sizeof(viable)) != sizeof(viable)) {
+		output(0, "%s is truncated, probing again.\n", cachefilename);
+		close(fd);
+		return FALSE;
+	}
+	close(fd);
+
+	count_viable();
+	return TRUE;
 }
 
-void open_sockets(void)
+/* Write to a temporary file and rename it, so other instances never see half a cache. */
+static void save_socketcache(void)
 {
-	struct flock fl = {
-		.l_type = F_WRLCK,
-		.l_whence = SEEK_SET,
-	};
-
-	int cachefile;
-	unsigned int domain, type, protocol;
-	unsigned int buffer[3];
-	int bytesread=-1;
+	struct socketcache_header hdr;
+	char tmpname[64];
 	int fd;
 
-	/* If we have victim files, don't worry about sockets. */
-	if (victim_path != NULL)
-		return;
+	describe_cache(&hdr);
 
-	cachefile = open(cachefilename, O_RDONLY);
-	if (cachefile < 0) {
-		printf("Couldn't find socket cachefile. Regenerating.\n");
-		generate_sockets();
+	sprintf(tmpname, "%s.%d", cachefilename, getpid());
+	fd = open(tmpname, O_WRONLY | O_CREAT | O_TRUNC, S_IWUSR|S_IRUSR);
+	if (fd == -1) {
+		output(0, "Couldn't create %s: %s\n", tmpname, strerror(errno));
 		return;
 	}
 
-	if (verbose)
-		output(2, "taking reader lock for cachefile\n");
-	fl.l_pid = getpid();
-	fl.l_type = F_RDLCK;
-	if (fcntl(cachefile, F_SETLKW, &fl) == -1) {
-		perror("fcntl F_RDLCK F_SETLKW");
-		exit(1);
+	if (write(fd, &hdr, sizeof(hdr)) != sizeof(hdr) ||
+	    write(fd, viable, sizeof(viable)) != sizeof(viable)) {
+		output(0, "Couldn't write %s\n", tmpname);
+		close(fd);
+		unlink(tmpname);
+		return;
 	}
-	if (verbose)
-		output(2, "took reader lock for cachefile\n");
+	close(fd);
 
-	while (bytesread != 0) {
-		bytesread = read(cachefile, buffer, sizeof(int) * 3);
-		if (bytesread == 0)
-			break;
+	if (rename(tmpname, cachefilename) == -1) {
+		output(0, "Couldn't rename %s: %s\n", tmpname, strerror(errno));
+		unlink(tmpname);
+	}
+}
 
-		domain = buffer[0];
-		type = buffer[1];
-		protocol = buffer[2];
+/* Pick a family that has something that works, then something in it that works. */
+static bool pick_viable(unsigned int *domain, unsigned int *type, unsigned int *protocol)
+{
+	unsigned int d, t, p, n;
+
+	if (do_specific_proto == TRUE) {
+		d = specific_proto;
+		if (d >= TRINITY_PF_MAX || viable_in_domain[d] == 0)
+			return FALSE;
+	} else {
+		n = 0;
+		for (d = 0; d < TRINITY_PF_MAX; d++) {
+			if (viable_in_domain[d] != 0)
+				n++;
+		}
+		if (n == 0)
+			return FALSE;
+
+		n = rnd_below(n);
+		for (d = 0; d < TRINITY_PF_MAX; d++) {
+			if (viable_in_domain[d] == 0)
+				continue;
+			if (n-- == 0)
+				break;
+		}
+	}
 
-		if (do_specific_proto == TRUE) {
-			if (domain != specific_proto) {
-				printf("ignoring socket cachefile due to specific protocol request, and stale data in cachefile.\n");
-				generate_sockets();
-				return;
+	n = rnd_below(viable_in_domain[d]);
+	for (t = 0; t < TYPE_MAX; t++) {
+		for (p = 0; p < PROTO_MAX; p++) {
+			if (is_viable(d, t, p) == FALSE)
+				continue;
+			if (n-- == 0) {
+				*domain = d;
+				*type = t;
+				*protocol = p;
+				return TRUE;
 			}
 		}
+	}
+	return FALSE;
+}
+
+/* Something that used to work doesn't any more (module unloaded?), so stop trying it. */
+static void drop_viable(unsigned int domain, unsigned int type, unsigned int protocol)
+{
+	unsigned int i = TRIPLE(domain, type, protocol);
 
-		fd = open_socket(domain, type, protocol);
-		if (fd < 0) {
-			printf("Cachefile is stale. Need to regenerate.\n");
-regenerate:
-			close(cachefile);
-			unlink(cachefilename);
+	viable[i / 8] &= ~(1 << (i % 8));
+	viable_in_domain[domain]--;
+}
 
-			close_sockets();
+static int compare_sockets(const void *a, const void *b)
+{
+	const struct socketinfo *sa = a, *sb = b;
 
-			generate_sockets();
-			return;
+	if (sa->domain != sb->domain)
+		return (sa->domain < sb->domain) ? -1 : 1;
+	return sa->fd - sb->fd;
+}
+
+static void sort_sockets(void)
+{
+	unsigned int i, domain;
+
+	qsort(shm->sockets, nr_sockets, sizeof(struct socketinfo), compare_sockets);
+
+	for (i = 0; i < nr_sockets; i++) {
+		register_fd(shm->sockets[i].fd);
+		domain = shm->sockets[i].domain;
+		if (family_count[domain]++ == 0) {
+			family_start[domain] = i;
+			families[nr_families++] = domain;
 		}
+	}
+	output(1, "Sockets are from %u families.\n", nr_families);
+}
+
+struct socketinfo * get_random_socket(void)
+{
+	unsigned int domain;
+
+	if (nr_families == 0)
+		return NULL;
 
+	domain = families[rnd_below(nr_families)];
+	return &shm->sockets[family_start[domain] + rnd_below(family_count[domain])];
+}
+
+struct socketinfo * find_socket(int fd)
+{
+	unsigned int i;
+
+	for (i = 0; i < nr_sockets; i++) {
+		if (shm->sockets[i].fd == fd)
+			return &shm->sockets[i];
+	}
+	return NULL;
+}
+
+void open_sockets(void)
+{
+	unsigned int domain, type, protocol, flags;
+	unsigned int dropped = 0;
+	bool probed = FALSE;
+	int fd;
+
+	/* If we have victim files, don't worry about sockets. */
+	if (victim_path != NULL)
+		return;
+
+	if (load_socketcache() == FALSE) {
+		probe_sockets();
+		if (shm->exit_reason != STILL_RUNNING)
+			return;
+		save_socketcache();
+		probed = TRUE;
+	}
+
+	while (nr_sockets < NR_SOCKET_FDS) {
 		/* check for ctrl-c */
 		if (shm->exit_reason != STILL_RUNNING)
 			return;
 
-	}
+		if (pick_viable(&domain, &type, &protocol) == FALSE) {
+			if (do_specific_proto == TRUE) {
+				if (dropped != 0)
+					save_socketcache();
+				printf("Couldn't create any sockets of protocol %s.\n", specific_proto_optarg);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		}
 
-	if (nr_sockets < NR_SOCKET_FDS) {
-		printf("Insufficient sockets in cachefile (%d). Regenerating.\n", nr_sockets);
-		goto regenerate;
-	}
+		flags = 0;
+		if (rnd_below(100) < 25)
+			flags |= SOCK_CLOEXEC;
+		if (rnd_below(100) < 25)
+			flags |= SOCK_NONBLOCK;
+
+		fd = open_socket(domain, type | flags, protocol);
+		if (fd > -1)
+			continue;
+
+		/* Out of fds or memory, nothing to do with which socket it was. */
+		if (errno == EMFILE || errno == ENFILE || errno == ENOMEM || errno == ENOBUFS)
+			break;
 
-	output(1, "%d sockets created based on info from socket cachefile.\n", nr_sockets);
+		drop_viable(domain, type, protocol);
+		dropped++;
+	}
 
-	fl.l_pid = getpid();
-	fl.l_type = F_UNLCK;
-	if (fcntl(cachefile, F_SETLK, &fl) == -1) {
-		perror("fcntl F_UNLCK F_SETLK ");
-		exit(1);
+	if (dropped != 0) {
+		output(0, "Dropped %u socket types that stopped working.\n", dropped);
+		save_socketcache();
 	}
 
-	if (verbose)
-		output(2, "dropped reader lock for cachefile\n");
-	close(cachefile);
+	sort_sockets();
+
+	output(1, "%d sockets created based on info from %s%s.\n",
+		nr_sockets, cachefilename, probed ? " (just probed)" : "");
 }
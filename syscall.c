@@ -4,8 +4,10 @@
 
 #include <fcntl.h>
 #include <errno.h>
+#include <signal.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/ptrace.h>
@@ -22,6 +24,12 @@
 #include "params.h"
 #include "maps.h"
 #include "trinity.h"
+#include "trace.h"
+#include "files.h"
+#include "harvest.h"
+#include "fdinfo.h"
+#include "blocking.h"
+#include "signals.h"
 
 #define __syscall_return(type, res) \
 	do { \
@@ -64,73 +72,256 @@ static long syscall32(int num_args, unsigned int call,
 }
 
 
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+/*
+ * NEED_ALARM syscalls get interrupted after timeout_ms. Each child makes its
+ * timer once, arms it before the syscall and disarms it after. Leaving it
+ * running would save a syscall, but the SIGALRM would then land in some
+ * later syscall, costing a signal delivery and an rt_sigreturn, and
+ * EINTRing whatever it interrupted.
+ */
+static timer_t syscall_timer;
+static bool have_syscall_timer = FALSE;
+static bool used_alarm = FALSE;
+
+void init_syscall_timer(void)
+{
+	struct sigevent sev;
+
+	memset(&sev, 0, sizeof(sev));
+	sev.sigev_notify = SIGEV_THREAD_ID;
+	sev.sigev_signo = SIGALRM;
+	sev.sigev_notify_thread_id = syscall(SYS_gettid);
+
+	if (timer_create(CLOCK_MONOTONIC, &sev, &syscall_timer) == 0)
+		have_syscall_timer = TRUE;
+	else
+		have_syscall_timer = FALSE;
+}
+
+static void arm_syscall_timer(void)
+{
+	struct itimerspec its;
+
+	memset(&its, 0, sizeof(its));
+	its.it_value.tv_sec = timeout_ms / 1000;
+	its.it_value.tv_nsec = (timeout_ms % 1000) * 1000000;
+
+	if (have_syscall_timer == TRUE && timer_settime(syscall_timer, 0, &its, NULL) == 0)
+		return;
+
+	/* A fuzzed timer_delete() can take it away from us. */
+	init_syscall_timer();
+	if (have_syscall_timer == TRUE && timer_settime(syscall_timer, 0, &its, NULL) == 0)
+		return;
+
+	(void)alarm((timeout_ms + 999) / 1000);
+	used_alarm = TRUE;
+}
+
+static void disarm_syscall_timer(void)
+{
+	struct itimerspec its;
+
+	if (used_alarm == TRUE) {
+		(void)alarm(0);
+		used_alarm = FALSE;
+		return;
+	}
+
+	memset(&its, 0, sizeof(its));
+	(void)timer_settime(syscall_timer, 0, &its, NULL);
+}
+
+static void count_syscall_time(struct syscall *entry, const struct timespec *start)
+{
+	struct timespec end;
+	unsigned long usecs;
+	unsigned int bucket;
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	usecs = ((end.tv_sec - start->tv_sec) * 1000000) +
+		((end.tv_nsec - start->tv_nsec) / 1000);
+
+	if (usecs < 1000)
+		bucket = TIMING_1MS;
+	else if (usecs < 10000)
+		bucket = TIMING_10MS;
+	else if (usecs < 50000)
+		bucket = TIMING_50MS;
+	else
+		bucket = TIMING_SLOWER;
+
+	__sync_fetch_and_add(&entry->timings[bucket], 1);
+}
+
+/* The timer interrupted the syscall, and the handler jumped back to do_random_syscalls(). */
+void syscall_timed_out(int childno)
+{
+	struct childdata *child = &shm->children[childno];
+
+	/* It never got back to do_syscall(), so count it here, as a failure. */
+	child->total_syscalls++;
+	child->failures++;
+	child->holds_ticket = FALSE;
+	child->syscall_count++;
+
+	__sync_fetch_and_add(&syscalls[child->syscallno].entry->timings[TIMING_TIMED_OUT], 1);
+	note_syscall_timeout(childno);
+}
+
+static void dump_timings(const struct syscalltable *table, unsigned int nr, const char *prefix)
+{
+	struct syscall *entry;
+	unsigned int i;
+
+	for (i = 0; i < nr; i++) {
+		entry = table[i].entry;
+		if (!(entry->flags & NEED_ALARM))
+			continue;
+		if (entry->timings[TIMING_1MS] + entry->timings[TIMING_10MS] +
+		    entry->timings[TIMING_50MS] + entry->timings[TIMING_SLOWER] +
+		    entry->timings[TIMING_TIMED_OUT] == 0)
+			continue;
+
+		output(1, "%s%s: %lu <1ms, %lu <10ms, %lu <50ms, %lu slower, %lu timed out.\n",
+			prefix, entry->name,
+			entry->timings[TIMING_1MS], entry->timings[TIMING_10MS],
+			entry->timings[TIMING_50MS], entry->timings[TIMING_SLOWER],
+			entry->timings[TIMING_TIMED_OUT]);
+	}
+}
+
+/* How long the syscalls that might block took, to help pick --timeout-ms */
+void dump_syscall_timings(void)
+{
+	if (biarch == TRUE) {
+		dump_timings(syscalls_64bit, max_nr_64bit_syscalls, "");
+		dump_timings(syscalls_32bit, max_nr_32bit_syscalls, "32bit ");
+	} else
+		dump_timings(syscalls, max_nr_syscalls, "");
+}
+
 static unsigned long do_syscall(int childno, int *errno_saved)
 {
-	int nr = shm->syscallno[childno];
+	struct childdata *child = &shm->children[childno];
+	int nr = child->syscallno;
 	unsigned int num_args = syscalls[nr].entry->num_args;
 	unsigned long a1, a2, a3, a4, a5, a6;
 	unsigned long ret = 0;
-	int pidslot;
-
-	a1 = shm->a1[childno];
-	a2 = shm->a2[childno];
-	a3 = shm->a3[childno];
-	a4 = shm->a4[childno];
-	a5 = shm->a5[childno];
-	a6 = shm->a6[childno];
-
-	if (syscalls[nr].entry->flags & NEED_ALARM)
-		(void)alarm(1);
+	bool timed = (syscalls[nr].entry->flags & NEED_ALARM) ? TRUE : FALSE;
+	struct timespec start;
+
+	a1 = child->a1;
+	a2 = child->a2;
+	a3 = child->a3;
+	a4 = child->a4;
+	a5 = child->a5;
+	a6 = child->a6;
+
+	if (timed == TRUE) {
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		arm_syscall_timer();
+		in_timed_syscall = TRUE;
+	}
 
 	errno = 0;
 
-	if (shm->do32bit[childno] == FALSE)
+	if (child->do32bit == FALSE)
 		ret = syscall(nr, a1, a2, a3, a4, a5, a6);
 	else
 		ret = syscall32(num_args, nr, a1, a2, a3, a4, a5, a6);
 
 	*errno_saved = errno;
 
-	if (syscalls[nr].entry->flags & NEED_ALARM)
-		(void)alarm(0);
-
-	pidslot = find_pid_slot(getpid());
-	if (pidslot != PIDSLOT_NOT_FOUND) {
-		shm->total_syscalls_done++;
-		shm->child_syscall_count[pidslot]++;
-		(void)gettimeofday(&shm->tv[pidslot], NULL);
+	if (timed == TRUE) {
+		in_timed_syscall = FALSE;
+		disarm_syscall_timer();
+		count_syscall_time(syscalls[nr].entry, &start);
 	}
 
+	child->total_syscalls++;
+	child->holds_ticket = FALSE;
+	child->syscall_count++;
+	(void)gettimeofday(&child->tv, NULL);
+
 	return ret;
 }
 
+/*
+ * Each child only ever bumps the counters in its own record, so the
+ * cachelines don't bounce between cpus. Anyone wanting the totals for
+ * the whole run adds them up.
+ */
+unsigned long total_syscalls_done(void)
+{
+	unsigned long total = 0;
+	unsigned int i;
+
+	for_each_pidslot(i)
+		total += shm->children[i].total_syscalls;
+
+	return total;
+}
+
+void total_syscall_results(unsigned long *successes, unsigned long *failures)
+{
+	unsigned int i;
+
+	*successes = 0;
+	*failures = 0;
+
+	for_each_pidslot(i) {
+		*successes += shm->children[i].successes;
+		*failures += shm->children[i].failures;
+	}
+}
+
+/* Let the fd pool know how the fds we passed in got on. */
+static void note_fd_args(struct syscall *entry, struct childdata *child, unsigned long ret, int err)
+{
+	if (entry->num_args >= 1 && is_fd_argtype(entry->arg1type) == TRUE)
+		note_fd_result(child->a1, ret, err);
+	if (entry->num_args >= 2 && is_fd_argtype(entry->arg2type) == TRUE)
+		note_fd_result(child->a2, ret, err);
+	if (entry->num_args >= 3 && is_fd_argtype(entry->arg3type) == TRUE)
+		note_fd_result(child->a3, ret, err);
+	if (entry->num_args >= 4 && is_fd_argtype(entry->arg4type) == TRUE)
+		note_fd_result(child->a4, ret, err);
+	if (entry->num_args >= 5 && is_fd_argtype(entry->arg5type) == TRUE)
+		note_fd_result(child->a5, ret, err);
+	if (entry->num_args >= 6 && is_fd_argtype(entry->arg6type) == TRUE)
+		note_fd_result(child->a6, ret, err);
+}
+
 /*
  * Generate arguments, print them out, then call the syscall.
  */
 long mkcall(int childno)
 {
+	struct childdata *child = &shm->children[childno];
 	unsigned long olda1, olda2, olda3, olda4, olda5, olda6;
-	unsigned int call = shm->syscallno[childno];
-	unsigned int call32, call64;
+	unsigned int call = child->syscallno;
 	unsigned long ret = 0;
 	int errno_saved;
 	char string[512], *sptr;
 
-	shm->regenerate++;
-
 	sptr = string;
 
 	sptr += sprintf(sptr, "[%d] ", getpid());
-	sptr += sprintf(sptr, "[%ld] ", shm->child_syscall_count[childno]);
-	if (shm->do32bit[childno] == TRUE)
+	sptr += sprintf(sptr, "[%ld] ", child->syscall_count);
+	if (child->do32bit == TRUE)
 		sptr += sprintf(sptr, "[32BIT] ");
 
-	olda1 = shm->a1[childno] = rand64();
-	olda2 = shm->a2[childno] = rand64();
-	olda3 = shm->a3[childno] = rand64();
-	olda4 = shm->a4[childno] = rand64();
-	olda5 = shm->a5[childno] = rand64();
-	olda6 = shm->a6[childno] = rand64();
+	olda1 = child->a1 = rand64();
+	olda2 = child->a2 = rand64();
+	olda3 = child->a3 = rand64();
+	olda4 = child->a4 = rand64();
+	olda5 = child->a5 = rand64();
+	olda6 = child->a6 = rand64();
 
 	if (call > max_nr_syscalls)
 		sptr += sprintf(sptr, "%u", call);
@@ -141,6 +332,11 @@ long mkcall(int childno)
 	if (syscalls[call].entry->sanitise)
 		syscalls[call].entry->sanitise(childno);
 
+	if (binary_logging == TRUE) {
+		trace_syscall_start(childno);
+		goto args_logged;
+	}
+
 /*
  * I *really* loathe how this macro has grown. It should be a real function one day.
  */
@@ -170,6 +366,13 @@ long mkcall(int childno)
 			break;						\
 		case ARG_PID:						\
 		case ARG_FD:						\
+		case ARG_FD_SOCKET:					\
+		case ARG_FD_DIR:					\
+		case ARG_FD_EPOLL:					\
+		case ARG_FD_TIMERFD:					\
+		case ARG_FD_INOTIFY:					\
+		case ARG_FD_FANOTIFY:					\
+		case ARG_FD_IOCTL:					\
 			CRESET						\
 			sptr += sprintf(sptr, "%ld", REG);		\
 			break;						\
@@ -212,12 +415,12 @@ long mkcall(int childno)
 	CRESET
 	sptr += sprintf(sptr, "(");
 
-	COLOR_ARG(1, syscalls[call].entry->arg1name, 1<<5, olda1, shm->a1[childno], syscalls[call].entry->arg1type);
-	COLOR_ARG(2, syscalls[call].entry->arg2name, 1<<4, olda2, shm->a2[childno], syscalls[call].entry->arg2type);
-	COLOR_ARG(3, syscalls[call].entry->arg3name, 1<<3, olda3, shm->a3[childno], syscalls[call].entry->arg3type);
-	COLOR_ARG(4, syscalls[call].entry->arg4name, 1<<2, olda4, shm->a4[childno], syscalls[call].entry->arg4type);
-	COLOR_ARG(5, syscalls[call].entry->arg5name, 1<<1, olda5, shm->a5[childno], syscalls[call].entry->arg5type);
-	COLOR_ARG(6, syscalls[call].entry->arg6name, 1<<0, olda6, shm->a6[childno], syscalls[call].entry->arg6type);
+	COLOR_ARG(1, syscalls[call].entry->arg1name, 1<<5, olda1, child->a1, syscalls[call].entry->arg1type);
+	COLOR_ARG(2, syscalls[call].entry->arg2name, 1<<4, olda2, child->a2, syscalls[call].entry->arg2type);
+	COLOR_ARG(3, syscalls[call].entry->arg3name, 1<<3, olda3, child->a3, syscalls[call].entry->arg3type);
+	COLOR_ARG(4, syscalls[call].entry->arg4name, 1<<2, olda4, child->a4, syscalls[call].entry->arg4type);
+	COLOR_ARG(5, syscalls[call].entry->arg5name, 1<<1, olda5, child->a5, syscalls[call].entry->arg5type);
+	COLOR_ARG(6, syscalls[call].entry->arg6name, 1<<0, olda6, child->a6, syscalls[call].entry->arg6type);
 args_done:
 	CRESET
 	sptr += sprintf(sptr, ") ");
@@ -225,17 +428,18 @@ args_done:
 
 	output(2, "%s", string);
 
+args_logged:
 	if (dopause == TRUE) {
 		synclogs();
 		sleep(1);
 	}
 
-	if (((unsigned long)shm->a1 == (unsigned long) shm) ||
-	    ((unsigned long)shm->a2 == (unsigned long) shm) ||
-	    ((unsigned long)shm->a3 == (unsigned long) shm) ||
-	    ((unsigned long)shm->a4 == (unsigned long) shm) ||
-	    ((unsigned long)shm->a5 == (unsigned long) shm) ||
-	    ((unsigned long)shm->a6 == (unsigned long) shm)) {
+	if ((child->a1 == (unsigned long) shm) ||
+	    (child->a2 == (unsigned long) shm) ||
+	    (child->a3 == (unsigned long) shm) ||
+	    (child->a4 == (unsigned long) shm) ||
+	    (child->a5 == (unsigned long) shm) ||
+	    (child->a6 == (unsigned long) shm)) {
 		BUG("Address of shm ended up in a register!\n");
 	}
 
@@ -247,13 +451,27 @@ args_done:
 
 	ret = do_syscall(childno, &errno_saved);
 
+	if (IS_ERR(ret))
+		child->failures++;
+	else
+		child->successes++;
+
+	note_fd_args(syscalls[child->syscallno].entry, child, ret, errno_saved);
+	sticky_fd_tick();
+	if (!IS_ERR(ret))
+		harvest_result(syscalls[child->syscallno].entry, ret);
+
+	if (binary_logging == TRUE) {
+		trace_syscall_end(childno, ret, errno_saved);
+		goto result_logged;
+	}
+
 	sptr = string;
 
 	if (IS_ERR(ret)) {
 		RED
 		sptr += sprintf(sptr, "= %ld (%s)", ret, strerror(errno_saved));
 		CRESET
-		shm->failures++;
 	} else {
 		GREEN
 		if ((unsigned long)ret > 10000)
@@ -261,13 +479,14 @@ args_done:
 		else
 			sptr += sprintf(sptr, "= %ld", ret);
 		CRESET
-		shm->successes++;
 	}
 
 	*sptr = '\0';
 
 	output(2, "%s\n", string);
 
+result_logged:
+
 	/* If the syscall doesn't exist don't bother calling it next time. */
 	if ((ret == -1UL) && (errno_saved == ENOSYS)) {
 
@@ -285,15 +504,7 @@ args_done:
 
 		output(1, "%s (%d) returned ENOSYS, marking as inactive.\n", syscalls[call].entry->name, call);
 
-		if (biarch == FALSE) {
-			syscalls[call].entry->flags &= ~ACTIVE;
-		} else {
-			call32 = search_syscall_table(syscalls_32bit, max_nr_32bit_syscalls, syscalls[call].entry->name);
-			syscalls_32bit[call32].entry->flags &= ~ACTIVE;
-			call64 = search_syscall_table(syscalls_64bit, max_nr_64bit_syscalls, syscalls[call].entry->name);
-			syscalls_64bit[call64].entry->flags &= ~ACTIVE;
-			output(1, "Disabled syscalls 32bit:%d 64bit:%d\n", call32, call64);
-		}
+		deactivate_syscall(call);
 	}
 
 skip_enosys:
@@ -302,13 +513,13 @@ skip_enosys:
 	    syscalls[call].entry->post(ret);
 
 	/* store info for debugging. */
-	shm->previous_syscallno[childno] = shm->syscallno[childno];
-	shm->previous_a1[childno] = shm->a1[childno];
-	shm->previous_a2[childno] = shm->a2[childno];
-	shm->previous_a3[childno] = shm->a3[childno];
-	shm->previous_a4[childno] = shm->a4[childno];
-	shm->previous_a5[childno] = shm->a5[childno];
-	shm->previous_a6[childno] = shm->a6[childno];
+	child->previous_syscallno = child->syscallno;
+	child->previous_a1 = child->a1;
+	child->previous_a2 = child->a2;
+	child->previous_a3 = child->a3;
+	child->previous_a4 = child->a4;
+	child->previous_a5 = child->a5;
+	child->previous_a6 = child->a6;
 
 	return ret;
 }
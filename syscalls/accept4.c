@@ -16,7 +16,7 @@ struct syscall syscall_accept4 = {
 	.name = "accept4",
 	.num_args = 4,
 	.arg1name = "fd",
-	.arg1type = ARG_FD,
+	.arg1type = ARG_FD_SOCKET,
 	.arg2name = "upeer_sockaddr",
 	.arg2type = ARG_SOCKADDR,
 	.arg3name = "upeer_addrlen",
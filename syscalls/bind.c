@@ -10,7 +10,7 @@ struct syscall syscall_bind = {
 	.name = "bind",
 	.num_args = 3,
 	.arg1name = "fd",
-	.arg1type = ARG_FD,
+	.arg1type = ARG_FD_SOCKET,
 	.arg2name = "umyaddr",
 	.arg2type = ARG_SOCKADDR,
 	.arg3name = "addrlen",
@@ -10,7 +10,7 @@ struct syscall syscall_connect = {
 	.name = "connect",
 	.num_args = 3,
 	.arg1name = "fd",
-	.arg1type = ARG_FD,
+	.arg1type = ARG_FD_SOCKET,
 	.arg2name = "uservaddr",
 	.arg2type = ARG_SOCKADDR,
 	.arg3name = "addrlen",
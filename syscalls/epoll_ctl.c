@@ -11,7 +11,7 @@ struct syscall syscall_epoll_ctl = {
 	.name = "epoll_ctl",
 	.num_args = 4,
 	.arg1name = "epfd",
-	.arg1type = ARG_FD,
+	.arg1type = ARG_FD_EPOLL,
 	.arg2name = "op",
 	.arg2type = ARG_OP,
 	.arg2list = {
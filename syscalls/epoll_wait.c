@@ -11,11 +11,14 @@ struct syscall syscall_epoll_wait = {
 	.name = "epoll_wait",
 	.num_args = 4,
 	.arg1name = "epfd",
-	.arg1type = ARG_FD,
+	.arg1type = ARG_FD_EPOLL,
 	.arg2name = "events",
 	.arg2type = ARG_ADDRESS,
 	.arg3name = "maxevents",
 	.arg4name = "timeout",
+	.arg4type = ARG_RANGE,
+	.low4range = 0,
+	.hi4range = 1,
 	.rettype = RET_BORING,
 	.flags = NEED_ALARM,
 };
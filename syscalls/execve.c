@@ -16,12 +16,13 @@
 #include "sanitise.h"
 #include "shm.h"
 #include "maps.h"	// generate_random_page
+#include "random.h"
 
 static unsigned long ** gen_ptrs_to_crap(void)
 {
 	void **ptr;
 	unsigned int i;
-	unsigned int count = rand() % 32;
+	unsigned int count = rnd_below(32);
 
 	/* Fabricate argv */
 	ptr = malloc(count * sizeof(void *));	// FIXME: LEAK
@@ -39,14 +40,16 @@ static unsigned long ** gen_ptrs_to_crap(void)
 
 void sanitise_execve(__unused__ int childno)
 {
+	struct childdata *child = &shm->children[childno];
+
 	/* we don't want to block if something tries to read from stdin */
 	fclose(stdin);
 
 	/* Fabricate argv */
-	shm->a2[childno] = (unsigned long) gen_ptrs_to_crap();
+	child->a2 = (unsigned long) gen_ptrs_to_crap();
 
 	/* Fabricate envp */
-	shm->a3[childno] = (unsigned long) gen_ptrs_to_crap();
+	child->a3 = (unsigned long) gen_ptrs_to_crap();
 }
 
 struct syscall syscall_execve = {
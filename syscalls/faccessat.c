@@ -10,7 +10,7 @@ struct syscall syscall_faccessat = {
 	.name = "faccessat",
 	.num_args = 3,
 	.arg1name = "dfd",
-	.arg1type = ARG_FD,
+	.arg1type = ARG_FD_DIR,
 	.arg2name = "filename",
 	.arg2type = ARG_PATHNAME,
 	.arg3name = "mode",
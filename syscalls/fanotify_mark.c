@@ -5,6 +5,7 @@
 #include <stdlib.h>
 #include "sanitise.h"
 #include "shm.h"
+#include "random.h"
 
 /* flags used for fanotify_modify_mark() */
 #define FAN_MARK_ADD            0x00000001
@@ -34,25 +35,26 @@
 
 static void sanitise_fanotify_mark(int childno)
 {
+	struct childdata *child = &shm->children[childno];
 	unsigned int flagvals[5] = { FAN_MARK_DONT_FOLLOW, FAN_MARK_ONLYDIR, FAN_MARK_MOUNT,
 				    FAN_MARK_IGNORED_MASK, FAN_MARK_IGNORED_SURV_MODIFY };
 
 	unsigned int i;
-	unsigned int numflags = rand() % 5;
+	unsigned int numflags = rnd_below(5);
 
 	// set additional flags
 	for (i = 0; i < numflags; i++)
-		shm->a2[childno] |= flagvals[i];
+		child->a2 |= flagvals[i];
 
 	// Set mask
-	shm->a3[childno] &= 0xffffffff;
+	child->a3 &= 0xffffffff;
 }
 
 struct syscall syscall_fanotify_mark = {
 	.name = "fanotify_mark",
 	.num_args = 5,
 	.arg1name = "fanotify_fd",
-	.arg1type = ARG_FD,
+	.arg1type = ARG_FD_FANOTIFY,
 	.arg2name = "flags",
 	.arg2type = ARG_OP,
 	.arg2list = {
@@ -68,7 +70,7 @@ struct syscall syscall_fanotify_mark = {
 			    FAN_EVENT_ON_CHILD },
 	},
 	.arg4name = "dfd",
-	.arg4type = ARG_FD,
+	.arg4type = ARG_FD_DIR,
 	.arg5name = "pathname",
 	.arg5type = ARG_PATHNAME,
 	.sanitise = sanitise_fanotify_mark,
@@ -10,7 +10,7 @@ struct syscall syscall_fchdir = {
 	.name = "fchdir",
 	.num_args = 1,
 	.arg1name = "fd",
-	.arg1type = ARG_FD,
+	.arg1type = ARG_FD_DIR,
 	.rettype = RET_ZERO_SUCCESS,
 	.flags = NEED_ALARM,
 	.group = GROUP_VFS,
@@ -11,7 +11,7 @@ struct syscall syscall_fchownat = {
 	.name = "fchownat",
 	.num_args = 5,
 	.arg1name = "dfd",
-	.arg1type = ARG_FD,
+	.arg1type = ARG_FD_DIR,
 	.arg2name = "filename",
 	.arg2type = ARG_PATHNAME,
 	.arg3name = "user",
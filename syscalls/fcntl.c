@@ -23,19 +23,27 @@
 #include "sanitise.h"
 #include "shm.h"
 #include "compat.h"
+#include "fdinfo.h"
+#include "trinity.h"	// ARRAY_SIZE
 
 #if F_GETLK64 != F_GETLK
 #define HAVE_LK64
 #endif
 
+/* The ones F_SETFL can change. */
+static const int setfl_flags[] = { O_APPEND, O_ASYNC, O_DIRECT, O_NOATIME, O_NONBLOCK };
+
 void sanitise_fcntl(int childno)
 {
-	switch (shm->a2[childno]) {
+	struct childdata *child = &shm->children[childno];
+	int flags;
+
+	switch (child->a2) {
 	/* arg = fd */
 	case F_DUPFD:
 	case F_DUPFD_CLOEXEC:
 	case F_SETLEASE:
-		shm->a3[childno] = (unsigned long) get_random_fd();
+		child->a3 = (unsigned long) get_random_fd();
 		break;
 		break;
 
@@ -49,21 +57,28 @@ void sanitise_fcntl(int childno)
 		break;
 
 	case F_SETFD:	/* arg = flags */
-		shm->a3[childno] = (unsigned int) rand32();
+		child->a3 = (unsigned int) rand32();
 		break;
 
 	case F_SETFL:
-		shm->a3[childno] = 0L;
+		/* Usually flip one flag on what it was opened with, rather than clobbering the lot. */
+		flags = get_fd_flags(child->a1);
+		if (flags != -1 && rnd_below(4) != 0) {
+			child->a3 = flags ^ setfl_flags[rnd_below(ARRAY_SIZE(setfl_flags))];
+			break;
+		}
+
+		child->a3 = 0L;
 		if (rand_bool())
-			shm->a3[childno] |= O_APPEND;
+			child->a3 |= O_APPEND;
 		if (rand_bool())
-			shm->a3[childno] |= O_ASYNC;
+			child->a3 |= O_ASYNC;
 		if (rand_bool())
-			shm->a3[childno] |= O_DIRECT;
+			child->a3 |= O_DIRECT;
 		if (rand_bool())
-			shm->a3[childno] |= O_NOATIME;
+			child->a3 |= O_NOATIME;
 		if (rand_bool())
-			shm->a3[childno] |= O_NONBLOCK;
+			child->a3 |= O_NONBLOCK;
 		break;
 
 	/* arg = (struct flock *) */
@@ -81,7 +96,7 @@ void sanitise_fcntl(int childno)
 #endif
 
 	case F_SETOWN:
-		shm->a3[childno] = (unsigned long) get_pid();
+		child->a3 = (unsigned long) get_pid();
 		break;
 
 	/* arg = struct f_owner_ex *) */
@@ -90,29 +105,29 @@ void sanitise_fcntl(int childno)
 		break;
 
 	case F_SETSIG:
-		shm->a3[childno] = (unsigned long) rand32();
-		if (shm->a3[childno] == SIGINT)
-			shm->a3[childno] = 0; /* restore default (SIGIO) */
+		child->a3 = (unsigned long) rand32();
+		if (child->a3 == SIGINT)
+			child->a3 = 0; /* restore default (SIGIO) */
 		break;
 
 	case F_NOTIFY:
-		shm->a3[childno] = 0L;
+		child->a3 = 0L;
 		if (rand_bool())
-			shm->a3[childno] |= DN_ACCESS;
+			child->a3 |= DN_ACCESS;
 		if (rand_bool())
-			shm->a3[childno] |= DN_MODIFY;
+			child->a3 |= DN_MODIFY;
 		if (rand_bool())
-			shm->a3[childno] |= DN_CREATE;
+			child->a3 |= DN_CREATE;
 		if (rand_bool())
-			shm->a3[childno] |= DN_DELETE;
+			child->a3 |= DN_DELETE;
 		if (rand_bool())
-			shm->a3[childno] |= DN_RENAME;
+			child->a3 |= DN_RENAME;
 		if (rand_bool())
-			shm->a3[childno] |= DN_ATTRIB;
+			child->a3 |= DN_ATTRIB;
 		break;
 
 	case F_SETPIPE_SZ:
-		shm->a3[childno] = rand32();
+		child->a3 = rand32();
 		break;
 
 	default:
@@ -7,14 +7,17 @@
 #include "compat.h"
 #include "sanitise.h"
 #include "shm.h"
+#include "random.h"
 
 static void sanitise_getrlimit(int childno)
 {
-	if (rand() % 2 == 0)
+	struct childdata *child = &shm->children[childno];
+
+	if (rnd_below(2) == 0)
 		return;
 
 	/* set "resource" some random value half the time. */
-	shm->a1[childno] = get_interesting_32bit_value();
+	child->a1 = get_interesting_32bit_value();
 }
 
 struct syscall syscall_getrlimit = {
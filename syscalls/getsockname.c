@@ -7,7 +7,7 @@ struct syscall syscall_getsockname = {
 	.name = "getsockname",
 	.num_args = 3,
 	.arg1name = "fd",
-	.arg1type = ARG_FD,
+	.arg1type = ARG_FD_SOCKET,
 	.arg2name = "usockaddr",
 	.arg2type = ARG_SOCKADDR,
 	.arg3name = "usockaddr_len",
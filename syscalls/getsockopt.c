@@ -7,7 +7,7 @@ struct syscall syscall_getsockopt = {
 	.name = "getsockopt",
 	.num_args = 5,
 	.arg1name = "fd",
-	.arg1type = ARG_FD,
+	.arg1type = ARG_FD_SOCKET,
 	.arg2name = "level",
 	.arg3name = "optname",
 	.arg4name = "optval",
@@ -10,7 +10,7 @@ struct syscall syscall_inotify_add_watch = {
 	.name = "inotify_add_watch",
 	.num_args = 3,
 	.arg1name = "fd",
-	.arg1type = ARG_FD,
+	.arg1type = ARG_FD_INOTIFY,
 	.arg2name = "pathname",
 	.arg2type = ARG_PATHNAME,
 	.arg3name = "mask",
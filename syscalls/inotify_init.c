@@ -7,4 +7,5 @@ struct syscall syscall_inotify_init = {
 	.name = "inotify_init",
 	.num_args = 0,
 	.group = GROUP_VFS,
+	.rettype = RET_FD,
 };
@@ -17,4 +17,5 @@ struct syscall syscall_inotify_init1 = {
 		.values = { IN_CLOEXEC , IN_NONBLOCK },
 	},
 	.group = GROUP_VFS,
+	.rettype = RET_FD,
 };
@@ -7,7 +7,7 @@ struct syscall syscall_inotify_rm_watch = {
 	.name = "inotify_rm_watch",
 	.num_args = 2,
 	.arg1name = "fd",
-	.arg1type = ARG_FD,
+	.arg1type = ARG_FD_INOTIFY,
 	.arg2name = "wd",
 	.flags = NEED_ALARM,
 	.group = GROUP_VFS,
@@ -8,28 +8,33 @@
 #include "maps.h"
 #include "shm.h"
 #include "ioctls.h"
+#include "fdinfo.h"
+#include "random.h"
 
 static void ioctl_mangle_cmd(int childno)
 {
+	struct childdata *child = &shm->children[childno];
 	unsigned int i;
 
 	/* mangle the cmd by ORing up to 4 random bits */
-	for (i=0; i < (unsigned int)(rand() % 4); i++)
-		shm->a2[childno] |= 1L << (rand() % 32);
+	for (i=0; i < (unsigned int)(rnd_below(4)); i++)
+		child->a2 |= 1L << rnd_below(32);
 
 	/* mangle the cmd by ANDing up to 4 random bits */
-	for (i=0; i < (unsigned int)(rand() % 4); i++)
-		shm->a2[childno] &= 1L << (rand() % 32);
+	for (i=0; i < (unsigned int)(rnd_below(4)); i++)
+		child->a2 &= 1L << rnd_below(32);
 }
 
 static void ioctl_mangle_arg(int childno)
 {
+	struct childdata *child = &shm->children[childno];
+
 	/* the argument could mean anything, because ioctl sucks like that. */
-	switch (rand() % 2) {
-	case 0:	shm->a3[childno] = get_interesting_32bit_value();
+	switch (rnd_below(2)) {
+	case 0:	child->a3 = get_interesting_32bit_value();
 		break;
 
-	case 1:	shm->a3[childno] = (unsigned long) page_rand;
+	case 1:	child->a3 = (unsigned long) page_rand;
 		generate_random_page(page_rand);
 		break;
 	default: break;
@@ -38,7 +43,7 @@ static void ioctl_mangle_arg(int childno)
 
 static void generic_sanitise_ioctl(int childno)
 {
-	if ((rand() % 50)==0)
+	if (rnd_below(50)==0)
 		ioctl_mangle_cmd(childno);
 
 	ioctl_mangle_arg(childno);
@@ -46,19 +51,20 @@ static void generic_sanitise_ioctl(int childno)
 
 static void sanitise_ioctl(int childno)
 {
+	struct childdata *child = &shm->children[childno];
 	const struct ioctl_group *grp;
 
-	if (rand() % 100 == 0)
+	if (rnd_below(100) == 0)
 		grp = get_random_ioctl_group();
 	else
-		grp = find_ioctl_group(shm->a1[childno]);
+		grp = get_fd_ioctl_group(child->a1);
 
 	if (grp) {
 		ioctl_mangle_arg(childno);
 
 		grp->sanitise(grp, childno);
 
-		if (rand() % 100 == 0)
+		if (rnd_below(100) == 0)
 			ioctl_mangle_cmd(childno);
 	} else
 		generic_sanitise_ioctl(childno);
@@ -68,7 +74,7 @@ struct syscall syscall_ioctl = {
 	.name = "ioctl",
 	.num_args = 3,
 	.arg1name = "fd",
-	.arg1type = ARG_FD,
+	.arg1type = ARG_FD_IOCTL,
 	.arg2name = "cmd",
 	.arg3name = "arg",
 	.arg3type = ARG_RANDPAGE,
@@ -5,6 +5,18 @@
 #include <linux/keyctl.h>
 #include "sanitise.h"
 #include "compat.h"
+#include "harvest.h"
+#include "shm.h"
+
+/* Most of the commands want a key, so sometimes give them one add_key() made. */
+static void sanitise_keyctl(int childno)
+{
+	struct childdata *child = &shm->children[childno];
+	unsigned long key;
+
+	if (get_harvested(HARVEST_KEY, &key) == TRUE)
+		child->a2 = key;
+}
 
 struct syscall syscall_keyctl = {
 	.name = "keyctl",
@@ -24,4 +36,5 @@ struct syscall syscall_keyctl = {
 	.arg3name = "arg3",
 	.arg4name = "arg4",
 	.arg5name = "arg5",
+	.sanitise = sanitise_keyctl,
 };
@@ -10,11 +10,11 @@ struct syscall syscall_linkat = {
 	.name = "linkat",
 	.num_args = 5,
 	.arg1name = "olddfd",
-	.arg1type = ARG_FD,
+	.arg1type = ARG_FD_DIR,
 	.arg2name = "oldname",
 	.arg2type = ARG_ADDRESS,
 	.arg3name = "newdfd",
-	.arg3type = ARG_FD,
+	.arg3type = ARG_FD_DIR,
 	.arg4name = "newname",
 	.arg4type = ARG_ADDRESS,
 	.arg5name = "flags",
@@ -7,7 +7,7 @@ struct syscall syscall_listen = {
 	.name = "listen",
 	.num_args = 2,
 	.arg1name = "fd",
-	.arg1type = ARG_FD,
+	.arg1type = ARG_FD_SOCKET,
 	.arg2name = "backlog",
 	.flags = NEED_ALARM,
 };
@@ -7,10 +7,13 @@
 #include "sanitise.h"
 #include "compat.h"
 #include "shm.h"
+#include "random.h"
 
 static void sanitise_madvise(int childno)
 {
-	shm->a2[childno] = rand() % page_size;
+	struct childdata *child = &shm->children[childno];
+
+	child->a2 = rnd_below(page_size);
 }
 
 struct syscall syscall_madvise = {
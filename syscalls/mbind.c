@@ -15,17 +15,18 @@
 
 static void sanitise_mbind(int childno)
 {
+	struct childdata *child = &shm->children[childno];
 	unsigned long maxnode;
 
-	shm->a2[childno] &= PAGE_MASK;
+	child->a2 &= PAGE_MASK;
 
 retry_maxnode:
-	shm->a5[childno] &= ~((page_size * 8) - 1);
+	child->a5 &= ~((page_size * 8) - 1);
 
-	maxnode = shm->a5[childno];
+	maxnode = child->a5;
 
 	if (maxnode < 2 || (maxnode) > (page_size * 8)) {
-		shm->a5[childno] = get_interesting_32bit_value();
+		child->a5 = get_interesting_32bit_value();
 		goto retry_maxnode;
 	}
 }
@@ -7,7 +7,7 @@ struct syscall syscall_mknodat = {
 	.name = "mknodat",
 	.num_args = 4,
 	.arg1name = "dfd",
-	.arg1type = ARG_FD,
+	.arg1type = ARG_FD_DIR,
 	.arg2name = "filename",
 	.arg2type = ARG_PATHNAME,
 	.arg3name = "mode",
@@ -7,8 +7,10 @@
 
 static void sanitise_mlock(int childno)
 {
-	if (shm->a2[childno] == 0)
-		shm->a2[childno] = 1;	// must be non-null.
+	struct childdata *child = &shm->children[childno];
+
+	if (child->a2 == 0)
+		child->a2 = 1;	// must be non-null.
 }
 
 struct syscall syscall_mlock = {
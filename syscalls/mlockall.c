@@ -4,19 +4,22 @@
 #include <stdlib.h>
 #include "sanitise.h"
 #include "shm.h"
+#include "random.h"
 
 #define MCL_CURRENT     1
 #define MCL_FUTURE      2
 
 static void sanitise_mlockall(int childno)
 {
-	if (shm->a1[childno] != 0)
+	struct childdata *child = &shm->children[childno];
+
+	if (child->a1 != 0)
 		return;
 
-	if ((rand() % 2) == 0)
-		shm->a1[childno] = MCL_CURRENT;
+	if (rnd_below(2) == 0)
+		child->a1 = MCL_CURRENT;
 	else
-		shm->a1[childno] = MCL_FUTURE;
+		child->a1 = MCL_FUTURE;
 }
 
 
@@ -10,6 +10,7 @@
 #include "shm.h"
 #include "arch.h"
 #include "compat.h"
+#include "random.h"
 
 #define NUM_FLAGS 12
 
@@ -18,38 +19,39 @@
 
 void sanitise_mmap(int childno)
 {
+	struct childdata *child = &shm->children[childno];
 	unsigned int i;
 	unsigned int flagvals[NUM_FLAGS] = { MAP_FIXED, MAP_ANONYMOUS,
 			    MAP_GROWSDOWN, MAP_DENYWRITE, MAP_EXECUTABLE, MAP_LOCKED,
 			    MAP_NORESERVE, MAP_POPULATE, MAP_NONBLOCK, MAP_STACK,
 			    MAP_HUGETLB, MAP_UNINITIALIZED };
-	unsigned int numflags = rand() % NUM_FLAGS;
+	unsigned int numflags = rnd_below(NUM_FLAGS);
 
 	/* Don't actually set a hint right now, in case we give out
 	   something that we don't want changed.  One day, we'll recycle
 	   mappings from mmap results and the like here instead.
 	   Right now, ARG_ADDRESS is a bad choice, as it causes page_rand()
 	   to be remapped as unwritable/unreadable, and then we segfault */
-	shm->a1[childno] = 0;
+	child->a1 = 0;
 
-	shm->a2[childno] = page_size;
-	if (shm->a2[childno] == 0)
-		shm->a2[childno] = page_size;
+	child->a2 = page_size;
+	if (child->a2 == 0)
+		child->a2 = page_size;
 
 
 	// set additional flags
 	for (i = 0; i < numflags; i++)
-		shm->a4[childno] |= flagvals[rand() % NUM_FLAGS];
+		child->a4 |= flagvals[rnd_below(NUM_FLAGS)];
 
 	/* no fd if anonymous mapping. */
-	if (shm->a4[childno] & MAP_ANONYMOUS)
-		shm->a5[childno] = -1;
+	if (child->a4 & MAP_ANONYMOUS)
+		child->a5 = -1;
 
 	/* page align non-anonymous mappings. */
-	if (shm->a4[childno] & MAP_ANONYMOUS)
-		shm->a6[childno] &= PAGE_MASK;
+	if (child->a4 & MAP_ANONYMOUS)
+		child->a6 &= PAGE_MASK;
 	else
-		shm->a6[childno] = 0;
+		child->a6 = 0;
 
 }
 
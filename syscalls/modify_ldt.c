@@ -15,17 +15,18 @@
 
 static void sanitise_modify_ldt(int childno)
 {
+	struct childdata *child = &shm->children[childno];
 	void *ldt;
 	//struct user_desc *desc;
 
-	switch (shm->a1[childno]) {
+	switch (child->a1) {
 	case 0:
 		/* read the ldt into the memory pointed to by ptr.
 		   The number of bytes read is the smaller of bytecount and the actual size of the ldt. */
 		ldt = malloc(ALLOCSIZE);
 		if (ldt == NULL)
 			return;
-		shm->a3[childno] = ALLOCSIZE;
+		child->a3 = ALLOCSIZE;
 		break;
 
 	case 1:
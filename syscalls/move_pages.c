@@ -15,12 +15,14 @@
 #include "sanitise.h"
 #include "arch.h"
 #include "shm.h"
+#include "random.h"
 
 //FIXME: This leaks memory.
 // A ->post function should free up the allocations.
 
 static void sanitise_move_pages(int childno)
 {
+	struct childdata *child = &shm->children[childno];
 	int *nodes;
 	unsigned long *page_alloc;
 	unsigned int i;
@@ -28,18 +30,18 @@ static void sanitise_move_pages(int childno)
 
 	// Needs CAP_SYS_NICE to move pages in another process
 	if (getuid() != 0) {
-		shm->a1[childno] = 0;
-		shm->a6[childno] &= ~MPOL_MF_MOVE_ALL;
+		child->a1 = 0;
+		child->a6 &= ~MPOL_MF_MOVE_ALL;
 	}
 
 	page_alloc = (unsigned long *) malloc(page_size);
 	if (page_alloc == NULL)
 		return;
 
-	count = rand() % (page_size / sizeof(void *));
+	count = rnd_below(page_size / sizeof(void *));
 	count = max(1, count);
 
-	shm->a2[childno] = count;
+	child->a2 = count;
 
 	for (i = 0; i < count; i++) {
 		page_alloc[i] = (unsigned long) malloc(page_size);
@@ -48,14 +50,14 @@ static void sanitise_move_pages(int childno)
 		page_alloc[i] &= PAGE_MASK;
 	}
 
-	shm->a3[childno] = (unsigned long) page_alloc;
+	child->a3 = (unsigned long) page_alloc;
 
 	nodes = malloc(count * sizeof(int));
 	for (i = 0; i < count; i++)
-		nodes[i] = (int) rand() % 2;
-	shm->a4[childno] = (unsigned long) nodes;
+		nodes[i] = (int) rnd_below(2);
+	child->a4 = (unsigned long) nodes;
 
-	shm->a5[childno] = (unsigned long) malloc(count * sizeof(int));
+	child->a5 = (unsigned long) malloc(count * sizeof(int));
 }
 
 struct syscall syscall_move_pages = {
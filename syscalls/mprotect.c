@@ -10,21 +10,22 @@
 
 static void sanitise_mprotect(int childno)
 {
+	struct childdata *child = &shm->children[childno];
 	unsigned long end;
 
-	shm->a1[childno] &= PAGE_MASK;
+	child->a1 &= PAGE_MASK;
 
 retry_end:
-	end = shm->a1[childno] + shm->a2[childno];
+	end = child->a1 + child->a2;
 	/* Length must not be zero. */
-	if (shm->a2[childno] == 0) {
-		shm->a2[childno] = rand64();
+	if (child->a2 == 0) {
+		child->a2 = rand64();
 		goto retry_end;
 	}
 
 	/* End must be after start */
-	if (end <= shm->a1[childno]) {
-		shm->a2[childno] = rand64();
+	if (end <= child->a1) {
+		child->a2 = rand64();
 		goto retry_end;
 	}
 }
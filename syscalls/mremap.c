@@ -16,13 +16,15 @@
 
 static void sanitise_mremap(int childno)
 {
-	shm->a1[childno] &= PAGE_MASK;
+	struct childdata *child = &shm->children[childno];
 
-	if (shm->a4[childno] & MREMAP_FIXED) {
+	child->a1 &= PAGE_MASK;
+
+	if (child->a4 & MREMAP_FIXED) {
 		// Can't be fixed, and maymove.
-		shm->a4[childno] &= ~MREMAP_MAYMOVE;
+		child->a4 &= ~MREMAP_MAYMOVE;
 
-		shm->a3[childno] &= TASK_SIZE - shm->a3[childno];
+		child->a3 &= TASK_SIZE - child->a3;
 	}
 }
 
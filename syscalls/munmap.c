@@ -7,7 +7,9 @@
 
 void sanitise_munmap(int childno)
 {
-	shm->a2[childno] = page_size;
+	struct childdata *child = &shm->children[childno];
+
+	child->a2 = page_size;
 }
 
 struct syscall syscall_munmap = {
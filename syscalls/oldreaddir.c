@@ -8,7 +8,7 @@ struct syscall syscall_oldreaddir = {
 	.name = "old_readdir",
 	.num_args = 3,
 	.arg1name = "fd",
-	.arg1type = ARG_FD,
+	.arg1type = ARG_FD_DIR,
 	.arg2name = "dirent",
 	.arg2type = ARG_ADDRESS,
 	.arg3name = "count",
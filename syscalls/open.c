@@ -26,4 +26,5 @@ struct syscall syscall_open = {
 	},
 	.arg3name = "mode",
 	.arg3type = ARG_MODE_T,
+	.rettype = RET_FD,
 };
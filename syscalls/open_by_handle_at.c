@@ -26,5 +26,6 @@ struct syscall syscall_open_by_handle_at = {
 				O_DIRECT, O_NOATIME, O_PATH,
 				O_DSYNC, O_LARGEFILE },
 	},
+	.rettype = RET_FD,
 	.flags = NEED_ALARM,
 };
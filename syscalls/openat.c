@@ -9,7 +9,7 @@ struct syscall syscall_openat = {
 	.name = "openat",
 	.num_args = 4,
 	.arg1name = "dfd",
-	.arg1type = ARG_FD,
+	.arg1type = ARG_FD_DIR,
 	.arg2name = "filename",
 	.arg2type = ARG_PATHNAME,
 	.arg3name = "flags",
@@ -26,5 +26,6 @@ struct syscall syscall_openat = {
 	},
 	.arg4name = "mode",
 	.arg4type = ARG_MODE_T,
+	.rettype = RET_FD,
 	.flags = NEED_ALARM,
 };
@@ -414,11 +414,11 @@ static long long random_sysfs_config(__u32 *type, __u64 *config1) {
 		return rand64();
 	}
 
-	i=rand()%num_pmus;
+	i=rnd_below(num_pmus);
 
 	*type=pmus[i].type;
 
-	switch(rand()%3) {
+	switch(rnd_below(3)) {
 		/* Random by Format */
 		case 0:
 			if (pmus[i].num_formats==0) goto out;
@@ -440,7 +440,7 @@ static long long random_sysfs_config(__u32 *type, __u64 *config1) {
 		/* Random by generic event */
 		case 1:
 			if (pmus[i].num_generic_events==0) goto out;
-			j=rand()%pmus[i].num_generic_events;
+			j=rnd_below(pmus[i].num_generic_events);
 			c=pmus[i].generic_events[j].config;
 			c1=pmus[i].generic_events[j].config1;
 			break;
@@ -452,8 +452,8 @@ static long long random_sysfs_config(__u32 *type, __u64 *config1) {
 	*config1=c1;
 	return c;
 out:
-	*config1=rand()%64;
-	return rand()%64;
+	*config1=rnd_below(64);
+	return rnd_below(64);
 }
 
 /* arbitrary high number unlikely to be used by perf_event */
@@ -465,7 +465,7 @@ static long long random_cache_config(void)
 
 	int cache_id, hw_cache_op_id, hw_cache_op_result_id;
 
-	switch (rand() % 8) {
+	switch (rnd_below(8)) {
 	case 0:
 		cache_id = PERF_COUNT_HW_CACHE_L1D;
 		break;
@@ -488,14 +488,14 @@ static long long random_cache_config(void)
 		cache_id = PERF_COUNT_HW_CACHE_NODE;
 		break;
 	case 7:
-		cache_id = rand() % 256;
+		cache_id = rnd_below(256);
 		break;
 	default:
 		cache_id = 0;
 		break;
 	}
 
-	switch (rand() % 4) {
+	switch (rnd_below(4)) {
 	case 0:
 		hw_cache_op_id = PERF_COUNT_HW_CACHE_OP_READ;
 		break;
@@ -506,14 +506,14 @@ static long long random_cache_config(void)
 		hw_cache_op_id = PERF_COUNT_HW_CACHE_OP_PREFETCH;
 		break;
 	case 3:
-		hw_cache_op_id = rand() % 256;
+		hw_cache_op_id = rnd_below(256);
 		break;
 	default:
 		hw_cache_op_id = 0;
 		break;
 	}
 
-	switch (rand() % 3) {
+	switch (rnd_below(3)) {
 	case 0:
 		hw_cache_op_result_id = PERF_COUNT_HW_CACHE_RESULT_ACCESS;
 		break;
@@ -521,7 +521,7 @@ static long long random_cache_config(void)
 		hw_cache_op_result_id = PERF_COUNT_HW_CACHE_RESULT_MISS;
 		break;
 	case 2:
-		hw_cache_op_result_id = rand() % 256;
+		hw_cache_op_result_id = rnd_below(256);
 		break;
 	default:
 		hw_cache_op_result_id = 0;
@@ -536,7 +536,7 @@ static int random_event_type(void)
 
 	int type=0;
 
-	switch (rand() % 8) {
+	switch (rnd_below(8)) {
 	case 0:
 		type = PERF_TYPE_HARDWARE;
 		break;
@@ -573,7 +573,7 @@ static long long random_event_config(__u32 *event_type, __u64 *config1)
 
 	switch (*event_type) {
 	case PERF_TYPE_HARDWARE:
-		switch (rand() % 11) {
+		switch (rnd_below(11)) {
 		case 0:
 			config = PERF_COUNT_HW_CPU_CYCLES;
 			break;
@@ -612,7 +612,7 @@ static long long random_event_config(__u32 *event_type, __u64 *config1)
 		}
 		break;
 	case PERF_TYPE_SOFTWARE:
-		switch (rand() % 10) {
+		switch (rnd_below(10)) {
 		case 0:
 			config = PERF_COUNT_SW_CPU_CLOCK;
 			break;
@@ -686,7 +686,7 @@ static long long random_event_config(__u32 *event_type, __u64 *config1)
 static void setup_breakpoints(struct perf_event_attr *attr)
 {
 
-	switch (rand() % 6) {
+	switch (rnd_below(6)) {
 	case 0:
 		attr->bp_type = HW_BREAKPOINT_EMPTY;
 		break;
@@ -714,7 +714,7 @@ static void setup_breakpoints(struct perf_event_attr *attr)
 	/* or a valid mem location for R/W/RW             */
 	attr->bp_addr = (long)get_address();
 
-	switch (rand() % 5) {
+	switch (rnd_below(5)) {
 	case 0:
 		attr->bp_len = HW_BREAKPOINT_LEN_1;
 		break;
@@ -740,7 +740,7 @@ static long long random_sample_type(void)
 
 	long long sample_type = 0;
 
-	if (rand() % 2)
+	if (rnd_below(2))
 		return rand64();
 
 	if (rand_bool())
@@ -780,7 +780,7 @@ static long long random_read_format(void)
 
 	long long read_format = 0;
 
-	if (rand() % 2)
+	if (rnd_below(2))
 		return rand64();
 
 	if (rand_bool())
@@ -799,7 +799,7 @@ static int random_attr_size(void) {
 
 	int size=0;
 
-	switch(rand() % 8) {
+	switch(rnd_below(8)) {
 	case 0:	size = PERF_ATTR_SIZE_VER0;
 		break;
 	case 1: size = PERF_ATTR_SIZE_VER1;
@@ -854,7 +854,7 @@ static void create_mostly_valid_counting_event(struct perf_event_attr *attr,
 	attr->enable_on_exec = rand_bool();
 	attr->task = rand_bool();
 	attr->watermark = rand_bool();
-	attr->precise_ip = rand() % 4;	// two bits
+	attr->precise_ip = rnd_below(4);	// two bits
 	attr->mmap_data = rand_bool();
 	attr->sample_id_all = rand_bool();
 	attr->exclude_host = rand_bool();
@@ -908,7 +908,7 @@ static void create_mostly_valid_sampling_event(struct perf_event_attr *attr,
 	attr->enable_on_exec = rand_bool();
 	attr->task = rand_bool();
 	attr->watermark = rand_bool();
-	attr->precise_ip = rand() % 4;	// two bits
+	attr->precise_ip = rnd_below(4);	// two bits
 	attr->mmap_data = rand_bool();
 	attr->sample_id_all = rand_bool();
 	attr->exclude_host = rand_bool();
@@ -958,7 +958,7 @@ static void create_random_event(struct perf_event_attr *attr)
 	attr->enable_on_exec = rand_bool();
 	attr->task = rand_bool();
 	attr->watermark = rand_bool();
-	attr->precise_ip = rand() % 4;
+	attr->precise_ip = rnd_below(4);
 	attr->mmap_data = rand_bool();
 	attr->sample_id_all = rand_bool();
 	attr->exclude_host = rand_bool();
@@ -969,7 +969,7 @@ static void create_random_event(struct perf_event_attr *attr)
 	attr->wakeup_events=rand32();
 
 	/* Breakpoints are unioned with the config values */
-	if (rand() % 2) {
+	if (rnd_below(2)) {
 		setup_breakpoints(attr);
 	}
 	else {
@@ -985,13 +985,14 @@ static void create_random_event(struct perf_event_attr *attr)
 
 static void sanitise_perf_event_open(int childno)
 {
+	struct childdata *child = &shm->children[childno];
 	struct perf_event_attr *attr;
 	unsigned long flags;
 	pid_t pid;
 	int group_leader=0;
 
-	shm->a1[childno] = (unsigned long)page_rand;
-	attr = (struct perf_event_attr *)shm->a1[childno];
+	child->a1 = (unsigned long)page_rand;
+	attr = (struct perf_event_attr *)child->a1;
 
 	/* this makes sure we clear out the reserved fields. */
 	memset(page_rand, 0, sizeof(struct perf_event_attr));
@@ -999,22 +1000,22 @@ static void sanitise_perf_event_open(int childno)
 	/* cpu */
 	/* requires ROOT to select CPU if paranoid level not 0 */
 	/* -1 means all CPUs */
-	//shm->a3[childno] = cpu;
+	//child->a3 = cpu;
 	// the default get_cpu() is good enough here
 
 	/* group_fd */
 	/* should usually be -1 or another perf_event fd         */
 	/* Anything but -1 unlikely to work unless the other pid */
 	/* was properly set up to be a group master              */
-	switch (rand() % 3) {
+	switch (rnd_below(3)) {
 	case 0:
-		shm->a4[childno] = -1;
+		child->a4 = -1;
 		group_leader = 1;
 		break;
 	case 1:
 		/* Try to get a previous random perf_event_open() fd  */
 		/* It's unclear whether get_random_fd() would do this */
-		shm->a4[childno] = rand() % 1024;
+		child->a4 = rnd_below(1024);
 		break;
 	case 2:
 		/* Rely on ARG_FD */
@@ -1026,7 +1027,7 @@ static void sanitise_perf_event_open(int childno)
 	/* flags */
 	/* You almost never set these unless you're playing with cgroups */
 	flags = 0;
-	if (rand() % 2) {
+	if (rnd_below(2)) {
 		flags = rand64();
 	} else {
 		if (rand_bool())
@@ -1036,7 +1037,7 @@ static void sanitise_perf_event_open(int childno)
 		if (rand_bool())
 			flags |= PERF_FLAG_PID_CGROUP;
 	}
-	shm->a5[childno] = flags;
+	child->a5 = flags;
 
 	/* pid */
 	/* requires ROOT to select pid that doesn't belong to us */
@@ -1047,15 +1048,15 @@ static void sanitise_perf_event_open(int childno)
 		/* In theory in this case we should pass in */
 		/* a file descriptor from /dev/cgroup       */
 		pid = get_random_fd();
-	} else if (rand() % 2) {
+	} else if (rnd_below(2)) {
 		pid = 0;
 	} else {
 		pid = get_pid();
 	}
-	shm->a2[childno] = pid;
+	child->a2 = pid;
 
 	/* set up attr structure */
-	switch (rand() % 3) {
+	switch (rnd_below(3)) {
 	case 0:
 		create_mostly_valid_counting_event(attr,group_leader);
 		break;
@@ -1091,5 +1092,6 @@ struct syscall syscall_perf_event_open = {
 	},
 	.sanitise = sanitise_perf_event_open,
 	.init = init_pmus,
+	.rettype = RET_FD,
 	.flags = NEED_ALARM,
 };
@@ -16,6 +16,7 @@
 #include "maps.h"
 #include "shm.h"
 #include "compat.h"
+#include "random.h"
 
 #define NR_PRCTL_OPTS 28
 static int prctl_opts[NR_PRCTL_OPTS] = {
@@ -31,20 +32,21 @@ static int prctl_opts[NR_PRCTL_OPTS] = {
 /* We already got a generic_sanitise at this point */
 void sanitise_prctl(int childno)
 {
-	int option = prctl_opts[rand() % NR_PRCTL_OPTS];
+	struct childdata *child = &shm->children[childno];
+	int option = prctl_opts[rnd_below(NR_PRCTL_OPTS)];
 
 	/* Also allow crap by small chance */
-	if (rand() % 100 != 0)
-		shm->a1[childno] = option;
+	if (rnd_below(100) != 0)
+		child->a1 = option;
 
 	switch (option) {
 	case PR_SET_SECCOMP:
 #ifdef USE_SECCOMP
-		if (rand() % 3 == SECCOMP_MODE_FILTER) {
+		if (rnd_below(3) == SECCOMP_MODE_FILTER) {
 			gen_seccomp_bpf((unsigned long *) page_rand, NULL);
 
-			shm->a2[childno] = SECCOMP_MODE_FILTER;
-			shm->a3[childno] = (unsigned long) page_rand;
+			child->a2 = SECCOMP_MODE_FILTER;
+			child->a3 = (unsigned long) page_rand;
 		}
 #endif
 		break;
@@ -7,10 +7,12 @@
 #include "shm.h"
 #include "compat.h"
 #include "arch.h"
+#include "random.h"
 
 
 static void sanitise_ptrace(int childno)
 {
+	struct childdata *child = &shm->children[childno];
 	unsigned int i;
 
 	/* We must be careful to not give out ARG_PID to ptrace,
@@ -23,8 +25,8 @@ static void sanitise_ptrace(int childno)
 	 * Or at least, that's the theory. In reality, this is currently causing 'no such process' errors.
 	 *  but broken is at least better than hanging.
 	 */
-	i  = rand() % shm->running_childs;
-	shm->a2[childno] = shm->pids[i];
+	i  = rnd_below(shm->running_childs);
+	child->a2 = shm->pids[i];
 }
 
 
@@ -7,10 +7,11 @@
 
 static void sanitise_pwrite64(int childno)
 {
+	struct childdata *child = &shm->children[childno];
 
 retry_pos:
-	if ((int) shm->a4[childno] < 0) {
-		shm->a4[childno] = rand64();
+	if ((int) child->a4 < 0) {
+		child->a4 = rand64();
 		goto retry_pos;
 	}
 }
@@ -7,11 +7,14 @@
 #include "sanitise.h"
 #include "shm.h"
 #include "arch.h"
+#include "random.h"
 
 static void sanitise_read(int childno)
 {
-	shm->a2[childno] = (unsigned long) page_rand;
-	shm->a3[childno] = rand() % page_size;
+	struct childdata *child = &shm->children[childno];
+
+	child->a2 = (unsigned long) page_rand;
+	child->a3 = rnd_below(page_size);
 }
 
 struct syscall syscall_read = {
@@ -8,7 +8,7 @@ struct syscall syscall_readlinkat = {
 	.name = "readlinkat",
 	.num_args = 4,
 	.arg1name = "dfd",
-	.arg1type = ARG_FD,
+	.arg1type = ARG_FD_DIR,
 	.arg2name = "pathname",
 	.arg2type = ARG_PATHNAME,
 	.arg3name = "buf",
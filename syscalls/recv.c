@@ -11,7 +11,7 @@ struct syscall syscall_recv = {
 	.name = "recv",
 	.num_args = 4,
 	.arg1name = "fd",
-	.arg1type = ARG_FD,
+	.arg1type = ARG_FD_SOCKET,
 	.arg2name = "ubuf",
 	.arg2type = ARG_ADDRESS,
 	.arg3name = "size",
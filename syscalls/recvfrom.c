@@ -12,7 +12,7 @@ struct syscall syscall_recvfrom = {
 	.name = "recvfrom",
 	.num_args = 6,
 	.arg1name = "fd",
-	.arg1type = ARG_FD,
+	.arg1type = ARG_FD_SOCKET,
 	.arg2name = "ubuf",
 	.arg2type = ARG_ADDRESS,
 	.arg3name = "size",
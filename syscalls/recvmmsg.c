@@ -12,7 +12,7 @@ struct syscall syscall_recvmmsg = {
 	.name = "recvmmsg",
 	.num_args = 5,
 	.arg1name = "fd",
-	.arg1type = ARG_FD,
+	.arg1type = ARG_FD_SOCKET,
 	.arg2name = "mmsg",
 	.arg2type = ARG_ADDRESS,
 	.arg3name = "vlen",
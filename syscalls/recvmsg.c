@@ -10,7 +10,7 @@ struct syscall syscall_recvmsg = {
 	.name = "recvmsg",
 	.num_args = 3,
 	.arg1name = "fd",
-	.arg1type = ARG_FD,
+	.arg1type = ARG_FD_SOCKET,
 	.arg2name = "msg",
 	.arg2type = ARG_ADDRESS,
 	.arg3name = "flags",
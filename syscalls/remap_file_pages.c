@@ -10,26 +10,27 @@
 
 static void sanitise_remap_file_pages(int childno)
 {
+	struct childdata *child = &shm->children[childno];
 
-	shm->a1[childno] &= PAGE_MASK;
-	shm->a2[childno] &= PAGE_MASK;
+	child->a1 &= PAGE_MASK;
+	child->a2 &= PAGE_MASK;
 
 
 retry_size:
-	if (shm->a1[childno] + shm->a2[childno] <= shm->a1[childno]) {
-		shm->a2[childno] = get_interesting_32bit_value() & PAGE_MASK;
+	if (child->a1 + child->a2 <= child->a1) {
+		child->a2 = get_interesting_32bit_value() & PAGE_MASK;
 		goto retry_size;
 	}
 
 retry_pgoff:
-	if (shm->a5[childno] + (shm->a2[childno] >> PAGE_SHIFT) < shm->a5[childno]) {
-		shm->a5[childno] = get_interesting_value();
+	if (child->a5 + (child->a2 >> PAGE_SHIFT) < child->a5) {
+		child->a5 = get_interesting_value();
 		goto retry_pgoff;
 	}
 
 retry_pgoff_bits:
-	if (shm->a5[childno] + (shm->a2[childno] >> PAGE_SHIFT) >= (1UL << PTE_FILE_MAX_BITS)) {
-		shm->a5[childno] = (shm->a5[childno] >> 1);
+	if (child->a5 + (child->a2 >> PAGE_SHIFT) >= (1UL << PTE_FILE_MAX_BITS)) {
+		child->a5 = (child->a5 >> 1);
 		goto retry_pgoff_bits;
 	}
 }
@@ -8,11 +8,11 @@ struct syscall syscall_renameat = {
 	.name = "renameat",
 	.num_args = 4,
 	.arg1name = "olddfd",
-	.arg1type = ARG_FD,
+	.arg1type = ARG_FD_DIR,
 	.arg2name = "oldname",
 	.arg2type = ARG_ADDRESS,
 	.arg3name = "newdfd",
-	.arg3type = ARG_FD,
+	.arg3type = ARG_FD_DIR,
 	.arg4name = "newname",
 	.arg4type = ARG_ADDRESS,
 	.flags = NEED_ALARM,
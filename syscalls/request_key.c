@@ -16,4 +16,5 @@ struct syscall syscall_request_key = {
 	.arg3name = "_callout_info",
 	.arg3type = ARG_ADDRESS,
 	.arg4name = "destringid",
+	.rettype = RET_KEY_SERIAL_T,
 };
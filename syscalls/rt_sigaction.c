@@ -8,16 +8,19 @@
 #include <stdlib.h>
 #include "sanitise.h"
 #include "shm.h"
+#include "random.h"
 
 void sanitise_rt_sigaction(int childno)
 {
-	if ((rand() % 2) == 0)
-		shm->a2[childno] = 0;
+	struct childdata *child = &shm->children[childno];
 
-	if ((rand() % 2) == 0)
-		shm->a3[childno] = 0;
+	if (rnd_below(2) == 0)
+		child->a2 = 0;
 
-	shm->a4[childno] = sizeof(sigset_t);
+	if (rnd_below(2) == 0)
+		child->a3 = 0;
+
+	child->a4 = sizeof(sigset_t);
 }
 
 struct syscall syscall_rt_sigaction = {
@@ -8,7 +8,9 @@
 
 static void sanitise_rt_sigprocmask(int childno)
 {
-	shm->a4[childno] = sizeof(sigset_t);
+	struct childdata *child = &shm->children[childno];
+
+	child->a4 = sizeof(sigset_t);
 }
 
 struct syscall syscall_rt_sigprocmask = {
@@ -9,7 +9,7 @@ struct syscall syscall_send = {
 	.name = "send",
 	.num_args = 4,
 	.arg1name = "fd",
-	.arg1type = ARG_FD,
+	.arg1type = ARG_FD_SOCKET,
 	.arg2name = "buff",
 	.arg2type = ARG_ADDRESS,
 	.arg3name = "len",
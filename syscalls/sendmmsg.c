@@ -10,7 +10,7 @@ struct syscall syscall_sendmmsg = {
 	.name = "sendmmsg",
 	.num_args = 4,
 	.arg1name = "fd",
-	.arg1type = ARG_FD,
+	.arg1type = ARG_FD_SOCKET,
 	.arg2name = "mmsg",
 	.arg2type = ARG_ADDRESS,
 	.arg3name = "vlen",
@@ -6,37 +6,51 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include "compat.h"
+#include "net.h"
+#include "params.h"	// sockaddr_mismatch
 #include "random.h"
 #include "sanitise.h"
 #include "shm.h"
 
 static void sanitise_sendmsg(int childno)
 {
+	struct childdata *child = &shm->children[childno];
 	struct msghdr *msg;
+	struct socketinfo *si;
+	unsigned long name = 0, namelen = 0;
 
 	// FIXME: Convert to use generic ARG_IOVEC
         msg = malloc(sizeof(struct msghdr));
 	if (msg == NULL) {
-		shm->a2[childno] = (unsigned long) get_address();
+		child->a2 = (unsigned long) get_address();
 		return;
 	}
 
-	msg->msg_name = get_address();
-	msg->msg_namelen = get_len();
+	/* Usually, a socket and an address that goes with it. */
+	if (rnd_below(100) >= sockaddr_mismatch) {
+		si = get_socket_and_sockaddr(&name, &namelen);
+		if (si != NULL)
+			child->a1 = si->fd;
+		msg->msg_name = (void *) name;
+		msg->msg_namelen = namelen;
+	} else {
+		msg->msg_name = get_address();
+		msg->msg_namelen = get_len();
+	}
 	msg->msg_iov = get_address();
 	msg->msg_iovlen = get_len();
 	msg->msg_control = get_address();
 	msg->msg_controllen = get_len();
 	msg->msg_flags = rand32();
 
-	shm->a2[childno] = (unsigned long) msg;
+	child->a2 = (unsigned long) msg;
 }
 
 struct syscall syscall_sendmsg = {
 	.name = "sendmsg",
 	.num_args = 3,
 	.arg1name = "fd",
-	.arg1type = ARG_FD,
+	.arg1type = ARG_FD_SOCKET,
 	.arg2name = "msg",
 	.arg3name = "flags",
 	.arg3type = ARG_LIST,
@@ -13,7 +13,7 @@ struct syscall syscall_sendto = {
 	.name = "sendto",
 	.num_args = 6,
 	.arg1name = "fd",
-	.arg1type = ARG_FD,
+	.arg1type = ARG_FD_SOCKET,
 	.arg2name = "buff",
 	.arg2type = ARG_ADDRESS,
 	.arg3name = "len",
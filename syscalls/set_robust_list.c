@@ -7,7 +7,9 @@
 
 static void sanitise_set_robust_list(int childno)
 {
-	shm->a2[childno] = sizeof(struct robust_list_head);
+	struct childdata *child = &shm->children[childno];
+
+	child->a2 = sizeof(struct robust_list_head);
 }
 
 struct syscall syscall_set_robust_list = {
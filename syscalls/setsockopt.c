@@ -12,18 +12,20 @@
 #include "net.h"
 #include "config.h"
 #include "syscalls/setsockopt.h"
+#include "random.h"
 
 void sanitise_setsockopt(int childno)
 {
+	struct childdata *child = &shm->children[childno];
 	int level;
 	unsigned char val;
 
-	shm->a4[childno] = (unsigned long) page_rand;
-	shm->a5[childno] = sizeof(int);	// at the minimum, we want an int (overridden below)
+	child->a4 = (unsigned long) page_rand;
+	child->a5 = sizeof(int);	// at the minimum, we want an int (overridden below)
 
 	/* First we pick a level  */
 
-	switch (rand() % 35) {
+	switch (rnd_below(35)) {
 	case 0:	level = SOL_IP;	break;
 	case 1:	level = SOL_SOCKET; break;
 	case 2:	level = SOL_TCP; break;
@@ -59,7 +61,7 @@ void sanitise_setsockopt(int childno)
 	case 32: level = SOL_ALG; break;
 	case 33: level = SOL_NFC; break;
 	default:
-		level = rand();
+		level = rnd();
 		break;
 	}
 
@@ -68,25 +70,25 @@ void sanitise_setsockopt(int childno)
 
 	switch (level) {
 	case SOL_IP:
-		val = rand() % NR_SOL_IP_OPTS;
-		shm->a3[childno] = ip_opts[val];
+		val = rnd_below(NR_SOL_IP_OPTS);
+		child->a3 = ip_opts[val];
 		break;
 
 	case SOL_SOCKET:
-		val = rand() % NR_SOL_SOCKET_OPTS;
-		shm->a3[childno] = socket_opts[val];
+		val = rnd_below(NR_SOL_SOCKET_OPTS);
+		child->a3 = socket_opts[val];
 
 		/* Adjust length according to operation set. */
-		switch (shm->a3[childno]) {
-		case SO_LINGER:	shm->a5[childno] = sizeof(struct linger);
+		switch (child->a3) {
+		case SO_LINGER:	child->a5 = sizeof(struct linger);
 			break;
 		case SO_RCVTIMEO:
 		case SO_SNDTIMEO:
-			shm->a5[childno] = sizeof(struct timeval);
+			child->a5 = sizeof(struct timeval);
 			break;
 		case SO_ATTACH_FILTER:
 			gen_bpf((unsigned long *) page_rand, NULL);
-			shm->a5[childno] = sizeof(struct sock_fprog);
+			child->a5 = sizeof(struct sock_fprog);
 			break;
 		default:
 			break;
@@ -94,19 +96,19 @@ void sanitise_setsockopt(int childno)
 		break;
 
 	case SOL_TCP:
-		val = rand() % NR_SOL_TCP_OPTS;
-		shm->a3[childno] = tcp_opts[val];
+		val = rnd_below(NR_SOL_TCP_OPTS);
+		child->a3 = tcp_opts[val];
 		break;
 
 	case SOL_UDP:
-		val = rand() % NR_SOL_UDP_OPTS;
-		shm->a3[childno] = udp_opts[val];
+		val = rnd_below(NR_SOL_UDP_OPTS);
+		child->a3 = udp_opts[val];
 
-		switch (shm->a3[childno]) {
+		switch (child->a3) {
 		case UDP_CORK:
 			break;
 		case UDP_ENCAP:
-			page_rand[0] = (rand() % 3) + 1;	// Encapsulation types.
+			page_rand[0] = rnd_below(3) + 1;	// Encapsulation types.
 			break;
 		default:
 			break;
@@ -114,29 +116,29 @@ void sanitise_setsockopt(int childno)
 		break;
 
 	case SOL_IPV6:
-		val = rand() % NR_SOL_IPV6_OPTS;
-		shm->a3[childno] = ipv6_opts[val];
+		val = rnd_below(NR_SOL_IPV6_OPTS);
+		child->a3 = ipv6_opts[val];
 		break;
 
 	case SOL_ICMPV6:
-		val = rand() % NR_SOL_ICMPV6_OPTS;
-		shm->a3[childno] = icmpv6_opts[val];
+		val = rnd_below(NR_SOL_ICMPV6_OPTS);
+		child->a3 = icmpv6_opts[val];
 		break;
 
 	case SOL_SCTP:
-		val = rand() % NR_SOL_SCTP_OPTS;
-		shm->a3[childno] = sctp_opts[val];
+		val = rnd_below(NR_SOL_SCTP_OPTS);
+		child->a3 = sctp_opts[val];
 		break;
 
 	case SOL_UDPLITE:
-		val = rand() % NR_SOL_UDPLITE_OPTS;
-		shm->a3[childno] = udplite_opts[val];
+		val = rnd_below(NR_SOL_UDPLITE_OPTS);
+		child->a3 = udplite_opts[val];
 
-		switch (shm->a3[childno]) {
+		switch (child->a3) {
 		case UDP_CORK:
 			break;
 		case UDP_ENCAP:
-			page_rand[0] = (rand() % 3) + 1;	// Encapsulation types.
+			page_rand[0] = rnd_below(3) + 1;	// Encapsulation types.
 			break;
 		case UDPLITE_SEND_CSCOV:
 			break;
@@ -149,59 +151,59 @@ void sanitise_setsockopt(int childno)
 		break;
 
 	case SOL_RAW:
-		shm->a3[childno] = ICMP_FILTER;	// that's all (for now?)
+		child->a3 = ICMP_FILTER;	// that's all (for now?)
 		break;
 
 	case SOL_IPX:
-		shm->a3[childno] = IPX_TYPE;
+		child->a3 = IPX_TYPE;
 		break;
 
 	case SOL_AX25:
-		val = rand() % NR_SOL_AX25_OPTS;
-		shm->a3[childno] = ax25_opts[val];
+		val = rnd_below(NR_SOL_AX25_OPTS);
+		child->a3 = ax25_opts[val];
 		break;
 
 	case SOL_ATALK:	/* sock_no_setsockopt */
 		break;
 
 	case SOL_NETROM:
-		val = rand() % NR_SOL_NETROM_OPTS;
-		shm->a3[childno] = netrom_opts[val];
+		val = rnd_below(NR_SOL_NETROM_OPTS);
+		child->a3 = netrom_opts[val];
 		break;
 
 	case SOL_ROSE:
-		val = rand() % NR_SOL_ROSE_OPTS;
-		shm->a3[childno] = rose_opts[val];
+		val = rnd_below(NR_SOL_ROSE_OPTS);
+		child->a3 = rose_opts[val];
 		break;
 
 	case SOL_DECNET:
 		// TODO: set size correctly
-		val = rand() % NR_SOL_DECNET_OPTS;
-		shm->a3[childno] = decnet_opts[val];
+		val = rnd_below(NR_SOL_DECNET_OPTS);
+		child->a3 = decnet_opts[val];
 		break;
 
 	case SOL_X25:
-		page_rand[0] = rand() % 2;	/* Just a bool */
-		shm->a4[childno] = sizeof(int);
+		page_rand[0] = rnd_below(2);	/* Just a bool */
+		child->a4 = sizeof(int);
 		break;
 
 	case SOL_PACKET:
-		val = rand() % NR_SOL_PACKET_OPTS;
-		shm->a3[childno] = packet_opts[val];
+		val = rnd_below(NR_SOL_PACKET_OPTS);
+		child->a3 = packet_opts[val];
 
 		/* Adjust length according to operation set. */
-		switch (shm->a3[childno]) {
+		switch (child->a3) {
 		case PACKET_VERSION:
-			page_rand[0] = rand() % 3; /* tpacket versions 1/2/3 */
+			page_rand[0] = rnd_below(3); /* tpacket versions 1/2/3 */
 			break;
 		case PACKET_TX_RING:
 		case PACKET_RX_RING:
 #ifdef TPACKET3_HDRLEN
-			if (rand() % 3 == 0)
-				shm->a5[childno] = sizeof(struct tpacket_req3);
+			if (rnd_below(3) == 0)
+				child->a5 = sizeof(struct tpacket_req3);
 			else
 #endif
-				shm->a5[childno] = sizeof(struct tpacket_req);
+				child->a5 = sizeof(struct tpacket_req);
 			break;
 		default:
 			break;
@@ -209,55 +211,55 @@ void sanitise_setsockopt(int childno)
 		break;
 
 	case SOL_ATM:
-		val = rand() % NR_SOL_ATM_OPTS;
-		shm->a3[childno] = atm_opts[val];
+		val = rnd_below(NR_SOL_ATM_OPTS);
+		child->a3 = atm_opts[val];
 		break;
 
 	case SOL_AAL:	/* no setsockopt */
 		break;
 
 	case SOL_IRDA:
-		val = rand() % NR_SOL_IRDA_OPTS;
-		shm->a3[childno] = irda_opts[val];
+		val = rnd_below(NR_SOL_IRDA_OPTS);
+		child->a3 = irda_opts[val];
 		break;
 
 	case SOL_NETBEUI:	/* no setsockopt */
 		break;
 
 	case SOL_LLC:
-		val = rand() % NR_SOL_LLC_OPTS;
-		shm->a3[childno] = llc_opts[val];
+		val = rnd_below(NR_SOL_LLC_OPTS);
+		child->a3 = llc_opts[val];
 		break;
 
 	case SOL_DCCP:
-		val = rand() % NR_SOL_DCCP_OPTS;
-		shm->a3[childno] = dccp_opts[val];
+		val = rnd_below(NR_SOL_DCCP_OPTS);
+		child->a3 = dccp_opts[val];
 		break;
 
 	case SOL_NETLINK:
-		val = rand() % NR_SOL_NETLINK_OPTS;
-		shm->a3[childno] = netlink_opts[val];
+		val = rnd_below(NR_SOL_NETLINK_OPTS);
+		child->a3 = netlink_opts[val];
 		break;
 
 	case SOL_TIPC:
-		shm->a4[childno] = sizeof(__u32);
-		val = rand() % NR_SOL_TIPC_OPTS;
-		shm->a3[childno] = tipc_opts[val];
+		child->a4 = sizeof(__u32);
+		val = rnd_below(NR_SOL_TIPC_OPTS);
+		child->a3 = tipc_opts[val];
 		break;
 
 	case SOL_RXRPC:
-		val = rand() % NR_SOL_RXRPC_OPTS;
-		shm->a3[childno] = rxrpc_opts[val];
+		val = rnd_below(NR_SOL_RXRPC_OPTS);
+		child->a3 = rxrpc_opts[val];
 		break;
 
 	case SOL_PPPOL2TP:
-		shm->a4[childno] = sizeof(int);
-		val = rand() % NR_SOL_PPPOL2TP_OPTS;
-		shm->a3[childno] = pppol2tp_opts[val];
+		child->a4 = sizeof(int);
+		val = rnd_below(NR_SOL_PPPOL2TP_OPTS);
+		child->a3 = pppol2tp_opts[val];
 		break;
 
 	case SOL_BLUETOOTH:
-		switch(rand() % 5) {
+		switch(rnd_below(5)) {
 		case 0: level = SOL_HCI; break;
 		case 1: level = SOL_L2CAP; break;
 		case 2: level = SOL_SCO; break;
@@ -270,26 +272,26 @@ void sanitise_setsockopt(int childno)
 
 		switch (level) {
 		case SOL_HCI:
-			val = rand() % NR_SOL_BLUETOOTH_HCI_OPTS;
-			shm->a3[childno] = bluetooth_hci_opts[val];
+			val = rnd_below(NR_SOL_BLUETOOTH_HCI_OPTS);
+			child->a3 = bluetooth_hci_opts[val];
 			break;
 
 		case SOL_L2CAP:
-			val = rand() % NR_SOL_BLUETOOTH_L2CAP_OPTS;
-			shm->a3[childno] = bluetooth_l2cap_opts[val];
+			val = rnd_below(NR_SOL_BLUETOOTH_L2CAP_OPTS);
+			child->a3 = bluetooth_l2cap_opts[val];
 			break;
 
 		case SOL_SCO:	/* no options currently */
 			break;
 
 		case SOL_RFCOMM:
-			val = rand() % NR_SOL_BLUETOOTH_RFCOMM_OPTS;
-			shm->a3[childno] = bluetooth_rfcomm_opts[val];
+			val = rnd_below(NR_SOL_BLUETOOTH_RFCOMM_OPTS);
+			child->a3 = bluetooth_rfcomm_opts[val];
 			break;
 
 		case SOL_BLUETOOTH:
-			val = rand() % NR_SOL_BLUETOOTH_OPTS;
-			shm->a3[childno] = bluetooth_opts[val];
+			val = rnd_below(NR_SOL_BLUETOOTH_OPTS);
+			child->a3 = bluetooth_opts[val];
 			break;
 
 		default: break;
@@ -301,21 +303,21 @@ void sanitise_setsockopt(int childno)
 
 #ifdef USE_RDS
 	case SOL_RDS:
-		val = rand() % NR_SOL_RDS_OPTS;
-		shm->a3[childno] = rds_opts[val];
+		val = rnd_below(NR_SOL_RDS_OPTS);
+		child->a3 = rds_opts[val];
 		break;
 #endif
 
 	case SOL_IUCV:
-		val = rand() % NR_SOL_IUCV_OPTS;
-		shm->a3[childno] = iucv_opts[val];
-		shm->a4[childno] = sizeof(int);
+		val = rnd_below(NR_SOL_IUCV_OPTS);
+		child->a3 = iucv_opts[val];
+		child->a4 = sizeof(int);
 		break;
 
 #ifdef USE_CAIF
 	case SOL_CAIF:
-		val = rand() % NR_SOL_CAIF_OPTS;
-		shm->a3[childno] = caif_opts[val];
+		val = rnd_below(NR_SOL_CAIF_OPTS);
+		child->a3 = caif_opts[val];
 		break;
 #endif
 
@@ -327,32 +329,32 @@ void sanitise_setsockopt(int childno)
 		break;
 
 	default:
-		shm->a3[childno] = (rand() % 0x100);	/* random operation. */
+		child->a3 = rnd_below(0x100);	/* random operation. */
 	}
 
-	shm->a2[childno] = level;
+	child->a2 = level;
 
 
 	/*
 	 * 10% of the time, mangle the options.
 	 * This should catch new options we don't know about, and also maybe some missing bounds checks.
 	 */
-	if ((rand() % 100) < 10)
-		shm->a3[childno] |= (1 << (rand() % 32));
+	if (rnd_below(100) < 10)
+		child->a3 |= (1 << rnd_below(32));
 
 
 	/* optval should be nonzero to enable a boolean option, or zero if the option is to be disabled.
 	 * Let's disable it half the time.
 	 */
-	if (rand() % 2)
-		shm->a4[childno] = 0;
+	if (rnd_below(2))
+		child->a4 = 0;
 }
 
 struct syscall syscall_setsockopt = {
 	.name = "setsockopt",
 	.num_args = 5,
 	.arg1name = "fd",
-	.arg1type = ARG_FD,
+	.arg1type = ARG_FD_SOCKET,
 	.arg2name = "level",
 	.arg3name = "optname",
 	.arg4name = "optval",
@@ -8,7 +8,7 @@ struct syscall syscall_shutdown = {
 	.name = "shutdown",
 	.num_args = 2,
 	.arg1name = "fd",
-	.arg1type = ARG_FD,
+	.arg1type = ARG_FD_SOCKET,
 	.arg2name = "how",
 	.arg2type = ARG_LIST,
 	.arg2list = {
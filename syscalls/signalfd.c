@@ -12,5 +12,6 @@ struct syscall syscall_signalfd = {
 	.arg2type = ARG_ADDRESS,
 	.arg3name = "sizemask",
 	.arg3type = ARG_LEN,
+	.rettype = RET_FD,
 	.flags = NEED_ALARM,
 };
@@ -21,5 +21,6 @@ struct syscall syscall_signalfd4 = {
 		.num = 2,
 		.values = { SFD_CLOEXEC , SFD_NONBLOCK },
 	},
+	.rettype = RET_FD,
 	.flags = NEED_ALARM,
 };
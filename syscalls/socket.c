@@ -39,18 +39,19 @@ static int ax25_protocols[NR_AX25_PROTOS] = {
 	0xF0	/* No layer 3 protocol impl.  */
 };
 
-/* note: also called from generate_sockets() & sanitise_socketcall() */
+/* note: also called from sanitise_socketcall() */
 void sanitise_socket(int childno)
 {
+	struct childdata *child = &shm->children[childno];
 	unsigned long family, type, protocol;
 
 	if (do_specific_proto == TRUE)
 		family = specific_proto;
 	else
-		family = rand() % PF_MAX;
+		family = rnd_below(PF_MAX);
 
-	type = rand() % TYPE_MAX;
-	protocol = rand() % PROTO_MAX;
+	type = rnd_below(TYPE_MAX);
+	protocol = rnd_below(PROTO_MAX);
 
 	switch (family) {
 
@@ -66,12 +67,12 @@ void sanitise_socket(int childno)
 		break;
 
 	case AF_AX25:
-		switch (rand() % 3) {
+		switch (rnd_below(3)) {
 		case 0:	type = SOCK_DGRAM;
 			protocol = 0;
 			break;
 		case 1:	type = SOCK_SEQPACKET;
-			protocol = ax25_protocols[rand() % NR_AX25_PROTOS];
+			protocol = ax25_protocols[rnd_below(NR_AX25_PROTOS)];
 			break;
 		case 2:	type = SOCK_RAW;
 			break;
@@ -81,7 +82,7 @@ void sanitise_socket(int childno)
 
 #ifdef USE_CAIF
 	case AF_CAIF:
-		protocol = rand() % _CAIFPROTO_MAX;
+		protocol = rnd_below(_CAIFPROTO_MAX);
 		switch (rand_bool()) {
 		case 0:	type = SOCK_SEQPACKET;
 			break;
@@ -93,7 +94,7 @@ void sanitise_socket(int childno)
 #endif
 
 	case AF_CAN:
-		protocol = rand() % 7;	// CAN_NPROTO
+		protocol = rnd_below(7);	// CAN_NPROTO
 		break;
 
 	case AF_DECnet:
@@ -106,7 +107,7 @@ void sanitise_socket(int childno)
 		break;
 
 	case AF_INET:
-		switch (rand() % 3) {
+		switch (rnd_below(3)) {
 		case 0:	type = SOCK_STREAM;	// TCP
 			if (rand_bool())
 				protocol = 0;
@@ -127,7 +128,7 @@ void sanitise_socket(int childno)
 
 
 	case AF_INET6:
-		switch (rand() % 3) {
+		switch (rnd_below(3)) {
 		case 0:	type = SOCK_STREAM;	// TCP
 			protocol = 0;
 			break;
@@ -148,7 +149,7 @@ void sanitise_socket(int childno)
 		break;
 
 	case AF_IRDA:
-		switch (rand() % 3) {
+		switch (rnd_below(3)) {
 		case 0:	type = SOCK_STREAM;
 			break;
 		case 1:	type = SOCK_SEQPACKET;
@@ -182,13 +183,13 @@ void sanitise_socket(int childno)
 		case 1:	type = SOCK_DGRAM;
 		default:break;
 		}
-		protocol = rand() % (NETLINK_CRYPTO + 1);	// Current highest netlink socket.
+		protocol = rnd_below(NETLINK_CRYPTO + 1);	// Current highest netlink socket.
 		break;
 
 	case AF_NFC:
 		switch (rand_bool()) {
 		case 0:	protocol = NFC_SOCKPROTO_LLCP;
-			switch (rand() % 2) {
+			switch (rnd_below(2)) {
 			case 0:	type = SOCK_DGRAM;
 				break;
 			case 1:	type = SOCK_STREAM;
@@ -207,12 +208,12 @@ void sanitise_socket(int childno)
 
 	case AF_PACKET:
 		protocol = htons(ETH_P_ALL);
-		if (rand() % 8 == 0) {
-			protocol = rand();
+		if (rnd_below(8) == 0) {
+			protocol = rnd();
 			if (rand_bool())
-				protocol = (uint16_t) rand();
+				protocol = (uint16_t) rnd();
 		}
-		switch (rand() % 3) {
+		switch (rnd_below(3)) {
 		case 0:	type = SOCK_DGRAM;
 			break;
 		case 1:	type = SOCK_RAW;
@@ -241,7 +242,7 @@ void sanitise_socket(int childno)
 
 	case AF_TIPC:
 		protocol = 0;
-		switch (rand() % 3) {
+		switch (rnd_below(3)) {
 		case 0:	type = SOCK_STREAM;
 			break;
 		case 1:	type = SOCK_SEQPACKET;
@@ -254,7 +255,7 @@ void sanitise_socket(int childno)
 
 	case AF_UNIX:
 		protocol = PF_UNIX;
-		switch (rand() % 3) {
+		switch (rnd_below(3)) {
 		case 0:	type = SOCK_STREAM;
 			break;
 		case 1:	type = SOCK_DGRAM;
@@ -271,7 +272,7 @@ void sanitise_socket(int childno)
 		break;
 
 	default:
-		switch (rand() % 6) {
+		switch (rnd_below(6)) {
 		case 0:	type = SOCK_DGRAM;	break;
 		case 1:	type = SOCK_STREAM;	break;
 		case 2:	type = SOCK_SEQPACKET;	break;
@@ -284,14 +285,14 @@ void sanitise_socket(int childno)
 		break;
 	}
 
-	if ((rand() % 100) < 25)
+	if (rnd_below(100) < 25)
 		type |= SOCK_CLOEXEC;
-	if ((rand() % 100) < 25)
+	if (rnd_below(100) < 25)
 		type |= SOCK_NONBLOCK;
 
-	shm->a1[childno] = family;
-	shm->a2[childno] = type;
-	shm->a3[childno] = protocol;
+	child->a1 = family;
+	child->a2 = type;
+	child->a3 = protocol;
 }
 
 struct syscall syscall_socket = {
@@ -301,4 +302,5 @@ struct syscall syscall_socket = {
 	.arg2name = "type",
 	.arg3name = "protocol",
 	.sanitise = sanitise_socket,
+	.rettype = RET_FD,
 };
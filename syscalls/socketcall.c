@@ -6,19 +6,21 @@
 #include "compat.h"
 #include "sanitise.h"
 #include "shm.h"
+#include "random.h"
 
 static void sanitise_socketcall(int childno)
 {
+	struct childdata *child = &shm->children[childno];
 	unsigned long *args;
 
 	args = malloc(6 * sizeof(unsigned long));
 
-	shm->a1[childno] = rand() % 20;
+	child->a1 = rnd_below(20);
 
-	switch (shm->a1[childno]) {
+	switch (child->a1) {
 	case SYS_SOCKET:
 		sanitise_socket(childno);
-		shm->syscallno[childno] = search_syscall_table(syscalls, max_nr_syscalls, "socket");
+		child->syscallno = search_syscall_table(syscalls, max_nr_syscalls, "socket");
 		break;
 	case SYS_BIND:
 		break;
@@ -62,7 +64,7 @@ static void sanitise_socketcall(int childno)
 		break;
 	}
 
-	shm->a2[childno] = (unsigned long) args;
+	child->a2 = (unsigned long) args;
 }
 
 struct syscall syscall_socketcall = {
@@ -6,6 +6,8 @@
 #include <stdlib.h>
 #include "sanitise.h"
 #include "shm.h"
+#include "files.h"
+#include "random.h"
 
 # define SPLICE_F_MOVE          1       /* Move pages instead of copying.  */
 # define SPLICE_F_NONBLOCK      2       /* Don't block on the pipe splicing
@@ -16,17 +18,19 @@
 
 void sanitise_splice(int childno)
 {
-	if ((rand() % 10) < 3)
+	struct childdata *child = &shm->children[childno];
+
+	if (rnd_below(10) < 3)
 		return;
 
-	if (rand() % 2) {
-		shm->a1[childno] = shm->pipe_fds[rand() % MAX_PIPE_FDS];
-		shm->a2[childno] = 0;
+	if (rnd_below(2)) {
+		child->a1 = get_pipe_reader();
+		child->a2 = 0;
 	}
 
-	if (rand() % 2) {
-		shm->a3[childno] = shm->pipe_fds[rand() % MAX_PIPE_FDS];
-		shm->a4[childno] = 0;
+	if (rnd_below(2)) {
+		child->a3 = get_pipe_writer();
+		child->a4 = 0;
 	}
 }
 
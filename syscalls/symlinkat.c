@@ -10,7 +10,7 @@ struct syscall syscall_symlinkat = {
 	.arg1name = "oldname",
 	.arg1type = ARG_PATHNAME,
 	.arg2name = "newdfd",
-	.arg2type = ARG_FD,
+	.arg2type = ARG_FD_DIR,
 	.arg3name = "newname",
 	.arg3type = ARG_PATHNAME,
 	.flags = NEED_ALARM,
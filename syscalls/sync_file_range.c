@@ -8,20 +8,22 @@
 #include "arch.h"
 #include "sanitise.h"
 #include "shm.h"
+#include "random.h"
 
 struct syscall syscall_sync_file_range;
 
 static void sanitise_sync_file_range(int childno)
 {
-	unsigned int call = shm->syscallno[childno];
+	struct childdata *child = &shm->children[childno];
+	unsigned int call = child->syscallno;
 	struct syscall *syscall_entry = syscalls[call].entry;
 	long endbyte;
 	loff_t nbytes;
 	loff_t off;
 
 retry:
-	off = rand() & 0xfffffff;
-	nbytes = rand() & 0xfffffff;
+	off = rnd() & 0xfffffff;
+	nbytes = rnd() & 0xfffffff;
 	endbyte = off + nbytes;
 	if (endbyte < off)
 		goto retry;
@@ -30,11 +32,11 @@ retry:
 		goto retry;
 
 	if (syscall_entry == &syscall_sync_file_range) {
-		shm->a2[childno] = off;
-		shm->a3[childno] = nbytes;
+		child->a2 = off;
+		child->a3 = nbytes;
 	} else {
-		shm->a3[childno] = off;
-		shm->a4[childno] = nbytes;
+		child->a3 = off;
+		child->a4 = nbytes;
 	}
 }
 
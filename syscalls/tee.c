@@ -4,6 +4,8 @@
 #include <stdlib.h>
 #include "sanitise.h"
 #include "shm.h"
+#include "files.h"
+#include "random.h"
 
 # define SPLICE_F_MOVE          1       /* Move pages instead of copying.  */
 # define SPLICE_F_NONBLOCK      2       /* Don't block on the pipe splicing
@@ -14,9 +16,11 @@
 
 void sanitise_tee(int childno)
 {
-	if ((rand() % 10) > 0) {
-		shm->a1[childno] = shm->pipe_fds[rand() % MAX_PIPE_FDS];
-		shm->a2[childno] = shm->pipe_fds[rand() % MAX_PIPE_FDS];
+	struct childdata *child = &shm->children[childno];
+
+	if (rnd_below(10) > 0) {
+		child->a1 = get_pipe_reader();
+		child->a2 = get_pipe_writer();
 	}
 }
 
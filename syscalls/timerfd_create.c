@@ -20,4 +20,5 @@ struct syscall syscall_timerfd_create = {
 		.num = 2,
 		.values = { TFD_NONBLOCK, TFD_CLOEXEC },
 	},
+	.rettype = RET_FD,
 };
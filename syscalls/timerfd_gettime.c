@@ -7,7 +7,7 @@ struct syscall syscall_timerfd_gettime = {
 	.name = "timerfd_gettime",
 	.num_args = 2,
 	.arg1name = "ufd",
-	.arg1type = ARG_FD,
+	.arg1type = ARG_FD_TIMERFD,
 	.arg2name = "otmr",
 	.arg2type = ARG_ADDRESS,
 	.flags = NEED_ALARM,
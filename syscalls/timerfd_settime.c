@@ -12,7 +12,7 @@ struct syscall syscall_timerfd_settime = {
 	.name = "timerfd_settime",
 	.num_args = 4,
 	.arg1name = "ufd",
-	.arg1type = ARG_FD,
+	.arg1type = ARG_FD_TIMERFD,
 	.arg2name = "flags",
 	.arg2type = ARG_LIST,
 	.arg2list = {
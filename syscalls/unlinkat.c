@@ -7,7 +7,7 @@ struct syscall syscall_unlinkat = {
 	.name = "unlinkat",
 	.num_args = 3,
 	.arg1name = "dfd",
-	.arg1type = ARG_FD,
+	.arg1type = ARG_FD_DIR,
 	.arg2name = "pathname",
 	.arg2type = ARG_PATHNAME,
 	.arg3name = "flag",
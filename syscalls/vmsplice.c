@@ -8,12 +8,17 @@
 #include <stdlib.h>
 #include "sanitise.h"
 #include "shm.h"
+#include "files.h"
+#include "random.h"
 
 static void sanitise_vmsplice(int childno)
 {
-	if ((rand() % 10) > 0)
-		shm->a1[childno] = shm->pipe_fds[rand() % MAX_PIPE_FDS];
-	shm->a3[childno] = rand() % UIO_MAXIOV;
+	struct childdata *child = &shm->children[childno];
+
+	/* Either take pages from a pipe with something in it, or give them to one with room. */
+	if (rnd_below(10) > 0)
+		child->a1 = rnd_below(2) ? get_pipe_reader() : get_pipe_writer();
+	child->a3 = rnd_below(UIO_MAXIOV);
 }
 
 struct syscall syscall_vmsplice = {
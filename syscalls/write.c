@@ -6,14 +6,17 @@
 #include "sanitise.h"
 #include "shm.h"
 #include "arch.h"	// page_size
+#include "random.h"
 
 static void sanitise_write(int childno)
 {
-	shm->a2[childno] = (unsigned long) page_rand;
-	if ((rand() % 100) > 50)
-		shm->a3[childno] = 1;
+	struct childdata *child = &shm->children[childno];
+
+	child->a2 = (unsigned long) page_rand;
+	if (rnd_below(100) > 50)
+		child->a3 = 1;
 	else
-		shm->a3[childno] = rand() % page_size;
+		child->a3 = rnd_below(page_size);
 }
 
 struct syscall syscall_write = {
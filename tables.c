@@ -13,6 +13,8 @@
 #include "syscall.h"
 #include "params.h"
 #include "log.h"
+#include "shm.h"
+#include "random.h"
 
 const struct syscalltable *syscalls;
 const struct syscalltable *syscalls_32bit;
@@ -28,6 +30,27 @@ bool use_32bit = FALSE;
 bool use_64bit = FALSE;
 bool biarch = FALSE;
 
+/*
+ * Dense per-process copies of the enabled entries of each syscall table.
+ * Selection is done through an alias table (Vose's method), so picking a
+ * weighted random syscall costs the same whether 3 or 300 are enabled.
+ * The flags live in shared memory and can be changed by any process
+ * (a child hitting ENOSYS for eg), so anything that changes them bumps
+ * shm->syscalls_generation, and each process rebuilds lazily on next use.
+ */
+struct active_syscalls {
+	unsigned int generation;
+	unsigned int nr_alloced;
+	unsigned int count;
+	unsigned long total_weight;
+	unsigned int *nr;
+	unsigned int *alias;
+	unsigned long *prob;
+};
+
+static struct active_syscalls active_32bit = { .generation = -1 };
+static struct active_syscalls active_64bit = { .generation = -1 };
+
 int search_syscall_table(const struct syscalltable *table, unsigned int nr_syscalls, const char *arg)
 {
 	unsigned int i;
@@ -69,6 +92,184 @@ int validate_specific_syscall_silent(const struct syscalltable *table, int call)
 	return TRUE;
 }
 
+/* Called whenever any ACTIVE/AVOID flags, or the tables themselves change. */
+void syscall_tables_changed(void)
+{
+	if (shm != NULL)
+		shm->syscalls_generation++;
+	active_32bit.generation = -1;
+	active_64bit.generation = -1;
+}
+
+static unsigned int syscall_weight(struct syscall *entry)
+{
+	if (entry->weight == 0)
+		return SYSCALL_WEIGHT_DEFAULT;
+	return entry->weight;
+}
+
+static void build_active_syscalls(struct active_syscalls *active,
+		const struct syscalltable *table, unsigned int nr_syscalls)
+{
+	unsigned int *small, *large;
+	unsigned long *scaled;
+	unsigned int nr_small = 0, nr_large = 0;
+	unsigned int i, n = 0;
+
+	if (active->nr_alloced < nr_syscalls) {
+		free(active->nr);
+		free(active->alias);
+		free(active->prob);
+		active->nr = malloc(nr_syscalls * sizeof(unsigned int));
+		active->alias = malloc(nr_syscalls * sizeof(unsigned int));
+		active->prob = malloc(nr_syscalls * sizeof(unsigned long));
+		if (!active->nr || !active->alias || !active->prob) {
+			printf("Couldn't allocate active syscall table!\n");
+			exit(EXIT_FAILURE);
+		}
+		active->nr_alloced = nr_syscalls;
+	}
+
+	active->total_weight = 0;
+	for (i = 0; i < nr_syscalls; i++) {
+		if (!(table[i].entry->flags & ACTIVE))
+			continue;
+		if (validate_specific_syscall_silent(table, i) == FALSE)
+			continue;
+
+		active->nr[n++] = i;
+		active->total_weight += syscall_weight(table[i].entry);
+	}
+	active->count = n;
+
+	if (n == 0)
+		return;
+
+	small = malloc(n * sizeof(unsigned int));
+	large = malloc(n * sizeof(unsigned int));
+	scaled = malloc(n * sizeof(unsigned long));
+	if (!small || !large || !scaled) {
+		printf("Couldn't allocate alias table scratch space!\n");
+		exit(EXIT_FAILURE);
+	}
+
+	/*
+	 * Each of the n columns holds total_weight units. A column is either
+	 * filled entirely by its own syscall, or split between it and an alias.
+	 */
+	for (i = 0; i < n; i++) {
+		scaled[i] = syscall_weight(table[active->nr[i]].entry) * n;
+		if (scaled[i] < active->total_weight)
+			small[nr_small++] = i;
+		else
+			large[nr_large++] = i;
+	}
+
+	while (nr_small > 0 && nr_large > 0) {
+		unsigned int s = small[--nr_small];
+		unsigned int l = large[--nr_large];
+
+		active->prob[s] = scaled[s];
+		active->alias[s] = l;
+
+		scaled[l] = (scaled[l] + scaled[s]) - active->total_weight;
+		if (scaled[l] < active->total_weight)
+			small[nr_small++] = l;
+		else
+			large[nr_large++] = l;
+	}
+
+	while (nr_large > 0) {
+		i = large[--nr_large];
+		active->prob[i] = active->total_weight;
+		active->alias[i] = i;
+	}
+	/* only reachable through rounding, treat as full columns. */
+	while (nr_small > 0) {
+		i = small[--nr_small];
+		active->prob[i] = active->total_weight;
+		active->alias[i] = i;
+	}
+
+	free(small);
+	free(large);
+	free(scaled);
+}
+
+static struct active_syscalls * get_active_syscalls(bool do32bit)
+{
+	struct active_syscalls *active;
+	unsigned int generation = shm->syscalls_generation;
+
+	if (biarch == FALSE) {
+		active = &active_64bit;
+		if (active->generation != generation) {
+			build_active_syscalls(active, syscalls, max_nr_syscalls);
+			active->generation = generation;
+		}
+		return active;
+	}
+
+	if (do32bit == TRUE) {
+		active = &active_32bit;
+		if (active->generation != generation) {
+			build_active_syscalls(active, syscalls_32bit, max_nr_32bit_syscalls);
+			active->generation = generation;
+		}
+	} else {
+		active = &active_64bit;
+		if (active->generation != generation) {
+			build_active_syscalls(active, syscalls_64bit, max_nr_64bit_syscalls);
+			active->generation = generation;
+		}
+	}
+	return active;
+}
+
+unsigned int nr_active_syscalls(bool do32bit)
+{
+	return get_active_syscalls(do32bit)->count;
+}
+
+/*
+ * Pick a random, enabled syscall from the 32 or 64 bit table (or the only
+ * table on non-biarch). Returns -1 if nothing is enabled.
+ */
+int pick_random_syscall(bool do32bit)
+{
+	struct active_syscalls *active = get_active_syscalls(do32bit);
+	unsigned int i;
+
+	if (active->count == 0)
+		return -1;
+
+	i = rnd_below(active->count);
+	if (rnd_below(active->total_weight) >= active->prob[i])
+		i = active->alias[i];
+
+	return active->nr[i];
+}
+
+/* If the syscall doesn't exist, don't bother calling it again. */
+void deactivate_syscall(unsigned int call)
+{
+	int call32, call64;
+
+	if (biarch == FALSE) {
+		syscalls[call].entry->flags &= ~ACTIVE;
+	} else {
+		call32 = search_syscall_table(syscalls_32bit, max_nr_32bit_syscalls, syscalls[call].entry->name);
+		if (call32 != -1)
+			syscalls_32bit[call32].entry->flags &= ~ACTIVE;
+		call64 = search_syscall_table(syscalls_64bit, max_nr_64bit_syscalls, syscalls[call].entry->name);
+		if (call64 != -1)
+			syscalls_64bit[call64].entry->flags &= ~ACTIVE;
+		output(1, "Disabled syscalls 32bit:%d 64bit:%d\n", call32, call64);
+	}
+
+	syscall_tables_changed();
+}
+
 void count_syscalls_enabled(void)
 {
 	unsigned int i;
@@ -137,51 +338,31 @@ void init_syscalls(void)
 
 bool no_syscalls_enabled(void)
 {
-	unsigned int i;
-
 	if (biarch == TRUE) {
-		for_each_64bit_syscall(i) {
-			if (syscalls_64bit[i].entry->flags & ACTIVE)
-				return FALSE;
-		}
-		for_each_32bit_syscall(i) {
-			if (syscalls_32bit[i].entry->flags & ACTIVE)
-				return FALSE;
-		}
+		if (nr_active_syscalls(FALSE) != 0)
+			return FALSE;
+		if (nr_active_syscalls(TRUE) != 0)
+			return FALSE;
 		return TRUE;
 	}
 
 	/* non-biarch */
-	for_each_syscall(i) {
-		if (syscalls[i].entry->flags & ACTIVE)
-			return FALSE;
-	}
+	if (nr_active_syscalls(FALSE) != 0)
+		return FALSE;
 	return TRUE;
 }
 
 int validate_syscall_table_64(void)
 {
-	unsigned int i;
-
-	for_each_64bit_syscall(i) {
-		if (syscalls_64bit[i].entry->flags & ACTIVE) {
-			use_64bit = TRUE;
-			break;
-		}
-	}
+	if (nr_active_syscalls(FALSE) != 0)
+		use_64bit = TRUE;
 	return use_64bit;
 }
 
 int validate_syscall_table_32(void)
 {
-	unsigned int i;
-
-	for_each_32bit_syscall(i) {
-		if (syscalls_32bit[i].entry->flags & ACTIVE) {
-			use_32bit = TRUE;
-			break;
-		}
-	}
+	if (nr_active_syscalls(TRUE) != 0)
+		use_32bit = TRUE;
 	return use_32bit;
 }
 
@@ -279,6 +460,7 @@ void mark_all_syscalls_active(void)
 		for_each_syscall(i)
 			syscalls[i].entry->flags |= ACTIVE;
 	}
+	syscall_tables_changed();
 }
 
 static void toggle_syscall_biarch(const char *arg, unsigned char state)
@@ -314,6 +496,8 @@ static void toggle_syscall_biarch(const char *arg, unsigned char state)
 		exit(EXIT_FAILURE);
 	}
 
+	syscall_tables_changed();
+
 	/* biarch? */
 	if ((specific_syscall64 != -1) && (specific_syscall32 != -1)) {
 		printf("[%d] Marking syscall %s (64bit:%d 32bit:%d) as to be %sabled.\n",
@@ -360,6 +544,8 @@ void toggle_syscall(const char *arg, unsigned char state)
 	else
 		syscalls[specific_syscall].entry->flags |= TO_BE_DEACTIVATED;
 
+	syscall_tables_changed();
+
 	printf("[%d] Marking syscall %s (%d) as to be %sabled.\n",
 		getpid(), arg, specific_syscall,
 		state ? "en" : "dis");
@@ -396,6 +582,7 @@ void deactivate_disabled_syscalls(void)
 			}
 		}
 	}
+	syscall_tables_changed();
 }
 
 static void show_state(unsigned int state)
@@ -597,6 +784,8 @@ try_64bit:
 		printf("Found %d syscalls in group\n", max_nr_syscalls);
 	}
 
+	syscall_tables_changed();
+
 	return TRUE;
 }
 
@@ -782,7 +971,7 @@ void enable_random_syscalls(void)
 
 retry:
 		if (biarch == TRUE) {
-			call64 = rand() % max_nr_64bit_syscalls;
+			call64 = rnd_below(max_nr_64bit_syscalls);
 			syscallname = lookup_name(call64);
 			call32 = search_syscall_table(syscalls_32bit, max_nr_32bit_syscalls, syscallname);
 
@@ -804,7 +993,7 @@ retry:
 				goto retry;
 
 		} else {
-			call = rand() % max_nr_syscalls;
+			call = rnd_below(max_nr_syscalls);
 
 			if (validate_specific_syscall_silent(syscalls, call) == FALSE)
 				goto retry;
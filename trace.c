@@ -0,0 +1,309 @@
+/*
+ * Binary syscall logging, and the decoder that turns it back into text.
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#include "trinity.h"	// biarch
+#include "shm.h"
+#include "syscall.h"
+#include "trace.h"
+
+static struct trace_header *trace_hdr;
+static struct trace_ring *trace_rings;
+static size_t trace_len;
+static int trace_fd = -1;
+
+static size_t trace_file_size(unsigned int nr_rings)
+{
+	return sizeof(struct trace_header) + (nr_rings * sizeof(struct trace_ring));
+}
+
+void open_trace(void)
+{
+	void *p;
+
+	unlink(TRACE_FILENAME);
+	trace_fd = open(TRACE_FILENAME, O_RDWR | O_CREAT | O_EXCL, 0644);
+	if (trace_fd == -1) {
+		printf("## couldn't open %s: %s\n", TRACE_FILENAME, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+
+	trace_len = trace_file_size(shm->max_children);
+	if (ftruncate(trace_fd, trace_len) == -1) {
+		printf("## couldn't size %s: %s\n", TRACE_FILENAME, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+
+	p = mmap(NULL, trace_len, PROT_READ | PROT_WRITE, MAP_SHARED, trace_fd, 0);
+	if (p == MAP_FAILED) {
+		printf("## couldn't mmap %s: %s\n", TRACE_FILENAME, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+
+	trace_hdr = p;
+	trace_hdr->magic = TRACE_MAGIC;
+	trace_hdr->version = TRACE_VERSION;
+	trace_hdr->nr_rings = shm->max_children;
+	trace_hdr->ring_entries = TRACE_RING_ENTRIES;
+	trace_hdr->record_size = sizeof(struct trace_record);
+	trace_hdr->seed = shm->seed;
+
+	trace_rings = p + sizeof(struct trace_header);
+}
+
+void close_trace(void)
+{
+	if (trace_hdr == NULL)
+		return;
+
+	sync_trace();
+	munmap(trace_hdr, trace_len);
+	close(trace_fd);
+	trace_hdr = NULL;
+}
+
+/* Only the dirty pages get written back, so this is cheap enough to do often. */
+void sync_trace(void)
+{
+	if (trace_fd != -1)
+		(void)fdatasync(trace_fd);
+}
+
+/*
+ * Each ring is only written by the child currently in that pidslot, so no
+ * locking is needed. The record goes in before the call, so if we never
+ * come back the last record still shows what we were doing.
+ */
+void trace_syscall_start(int childno)
+{
+	struct childdata *child = &shm->children[childno];
+	struct trace_ring *ring = &trace_rings[childno];
+	struct trace_record *rec;
+	struct timeval tv;
+
+	rec = &ring->recs[ring->head % TRACE_RING_ENTRIES];
+
+	gettimeofday(&tv, NULL);
+
+	rec->seq = ring->head;
+	rec->timestamp = (tv.tv_sec * 1000000ULL) + tv.tv_usec;
+	rec->args[0] = child->a1;
+	rec->args[1] = child->a2;
+	rec->args[2] = child->a3;
+	rec->args[3] = child->a4;
+	rec->args[4] = child->a5;
+	rec->args[5] = child->a6;
+	rec->retval = 0;
+	rec->pid = getpid();
+	rec->nr = child->syscallno;
+	rec->err = 0;
+	rec->flags = (child->do32bit == TRUE) ? TRACE_32BIT : 0;
+
+	ring->head++;
+}
+
+void trace_syscall_end(int childno, unsigned long ret, int err)
+{
+	struct trace_ring *ring = &trace_rings[childno];
+	struct trace_record *rec;
+
+	rec = &ring->recs[(ring->head - 1) % TRACE_RING_ENTRIES];
+	rec->retval = ret;
+	rec->err = err;
+	rec->flags |= TRACE_DONE;
+}
+
+static const char * argname(struct syscall *entry, unsigned int argnum)
+{
+	switch (argnum) {
+	case 1:	return entry->arg1name;
+	case 2:	return entry->arg2name;
+	case 3:	return entry->arg3name;
+	case 4:	return entry->arg4name;
+	case 5:	return entry->arg5name;
+	case 6:	return entry->arg6name;
+	default:
+		return NULL;
+	}
+}
+
+static enum argtype argtype(struct syscall *entry, unsigned int argnum)
+{
+	switch (argnum) {
+	case 1:	return entry->arg1type;
+	case 2:	return entry->arg2type;
+	case 3:	return entry->arg3type;
+	case 4:	return entry->arg4type;
+	case 5:	return entry->arg5type;
+	case 6:	return entry->arg6type;
+	default:
+		return ARG_UNDEFINED;
+	}
+}
+
+/* Print a record the same way mkcall() would have logged it. */
+static void decode_record(struct trace_record *rec)
+{
+	const struct syscalltable *table = syscalls;
+	unsigned int max = max_nr_syscalls;
+	struct syscall *entry;
+	unsigned long reg;
+	unsigned int i;
+
+	if (biarch == TRUE) {
+		if (rec->flags & TRACE_32BIT) {
+			table = syscalls_32bit;
+			max = max_nr_32bit_syscalls;
+		} else {
+			table = syscalls_64bit;
+			max = max_nr_64bit_syscalls;
+		}
+	}
+
+	printf("[%d] [%lu] ", rec->pid, (unsigned long) rec->seq);
+	if (rec->flags & TRACE_32BIT)
+		printf("[32BIT] ");
+
+	if (rec->nr >= max) {
+		printf("%u(?)\n", rec->nr);
+		return;
+	}
+
+	entry = table[rec->nr].entry;
+	printf("%s(", entry->name);
+
+	for (i = 1; i <= entry->num_args; i++) {
+		const char *name = argname(entry, i);
+
+		if (!name)
+			break;
+		if (i != 1)
+			printf(", ");
+
+		reg = rec->args[i - 1];
+		printf("%s=", name);
+
+		switch (argtype(entry, i)) {
+		case ARG_PID:
+		case ARG_FD:
+		case ARG_FD_SOCKET:
+		case ARG_FD_DIR:
+		case ARG_FD_EPOLL:
+		case ARG_FD_TIMERFD:
+		case ARG_FD_INOTIFY:
+		case ARG_FD_FANOTIFY:
+		case ARG_FD_IOCTL:
+			printf("%ld", reg);
+			break;
+		case ARG_MODE_T:
+			printf("%o", (mode_t) reg);
+			break;
+		case ARG_UNDEFINED:
+		case ARG_LEN:
+		case ARG_ADDRESS:
+		case ARG_NON_NULL_ADDRESS:
+		case ARG_PATHNAME:
+		case ARG_RANGE:
+		case ARG_OP:
+		case ARG_LIST:
+		case ARG_RANDPAGE:
+		case ARG_CPU:
+		case ARG_RANDOM_INT:
+		case ARG_IOVEC:
+		case ARG_IOVECLEN:
+		case ARG_SOCKADDR:
+		case ARG_SOCKADDRLEN:
+		default:
+			if (reg > 8 * 1024)
+				printf("0x%lx", reg);
+			else
+				printf("%ld", reg);
+			break;
+		}
+	}
+	printf(") ");
+
+	if (!(rec->flags & TRACE_DONE)) {
+		printf("= ?\n");
+		return;
+	}
+
+	reg = rec->retval;
+	if (IS_ERR(reg))
+		printf("= %ld (%s)\n", reg, strerror(rec->err));
+	else if (reg > 10000)
+		printf("= 0x%lx\n", reg);
+	else
+		printf("= %ld\n", reg);
+}
+
+int decode_trace(const char *filename)
+{
+	struct trace_header *hdr;
+	struct trace_ring *rings;
+	struct stat sb;
+	unsigned int i;
+	uint64_t seq, first;
+	void *p;
+	int fd;
+
+	fd = open(filename, O_RDONLY);
+	if (fd == -1) {
+		printf("Couldn't open %s: %s\n", filename, strerror(errno));
+		return FALSE;
+	}
+
+	if (fstat(fd, &sb) == -1 || (size_t) sb.st_size < sizeof(struct trace_header)) {
+		printf("%s is too short to be a trace.\n", filename);
+		close(fd);
+		return FALSE;
+	}
+
+	p = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (p == MAP_FAILED) {
+		printf("Couldn't mmap %s: %s\n", filename, strerror(errno));
+		return FALSE;
+	}
+
+	hdr = p;
+	if ((hdr->magic != TRACE_MAGIC) ||
+	    (hdr->version != TRACE_VERSION) ||
+	    (hdr->ring_entries != TRACE_RING_ENTRIES) ||
+	    (hdr->record_size != sizeof(struct trace_record)) ||
+	    ((size_t) sb.st_size < trace_file_size(hdr->nr_rings))) {
+		printf("%s isn't a trace from this version of trinity.\n", filename);
+		munmap(p, sb.st_size);
+		return FALSE;
+	}
+
+	printf("Trace of %u children, seed %u\n", hdr->nr_rings, hdr->seed);
+
+	rings = p + sizeof(struct trace_header);
+
+	for (i = 0; i < hdr->nr_rings; i++) {
+		struct trace_ring *ring = &rings[i];
+
+		first = 0;
+		if (ring->head > TRACE_RING_ENTRIES)
+			first = ring->head - TRACE_RING_ENTRIES;
+
+		printf("\n### pidslot %u: %lu syscalls, showing the last %lu\n",
+			i, (unsigned long) ring->head, (unsigned long) (ring->head - first));
+
+		for (seq = first; seq < ring->head; seq++)
+			decode_record(&ring->recs[seq % TRACE_RING_ENTRIES]);
+	}
+
+	munmap(p, sb.st_size);
+	return TRUE;
+}
@@ -29,8 +29,10 @@
 #include "random.h"
 #include "signals.h"
 #include "shm.h"
+#include "blocking.h"
 #include "syscall.h"
 #include "ioctls.h"
+#include "trace.h"
 #include "config.h"	// for VERSION
 
 char *progname = NULL;
@@ -63,9 +65,6 @@ static int create_shm(void)
 
 	memset(shm, 0, sizeof(struct shm_s));
 
-	shm->total_syscalls_done = 1;
-	shm->regenerate = 0;
-
 	memset(shm->pids, EMPTY_PIDSLOT, sizeof(shm->pids));
 
 	shm->parentpid = getpid();
@@ -96,6 +95,17 @@ static void setup_shm_postargs(void)
 		printf("Increase MAX_NR_CHILDREN!\n");
 		exit(EXIT_FAILURE);
 	}
+
+	if (replay_from != 0) {
+		unsigned int i;
+
+		if (user_set_seed == FALSE)
+			printf("Replaying without -s makes little sense, the seed is random.\n");
+		printf("Starting all children at syscall %lu of their random stream.\n", replay_from);
+
+		for_each_pidslot(i)
+			shm->children[i].stream_pos = replay_from;
+	}
 }
 
 /* This is run *after* we've parsed params */
@@ -152,6 +162,7 @@ int main(int argc, char* argv[])
 {
 	int ret = EXIT_SUCCESS;
 	int childstatus;
+	unsigned long successes, failures;
 	unsigned int i;
 
 	printf("Trinity v" __stringify(VERSION) "  Dave Jones <davej@redhat.com>\n");
@@ -168,11 +179,20 @@ int main(int argc, char* argv[])
 	parse_args(argc, argv);
 	printf("Done parsing arguments.\n");
 
+	if (decode_log_file != NULL) {
+		if (decode_trace(decode_log_file) == FALSE)
+			ret = EXIT_FAILURE;
+		goto out;
+	}
+
 	setup_shm_postargs();
 
 	if (logging == TRUE)
 		open_logfiles();
 
+	if (binary_logging == TRUE)
+		open_trace();
+
 	if (munge_tables() == FALSE) {
 		ret = EXIT_FAILURE;
 		goto out;
@@ -234,6 +254,11 @@ int main(int argc, char* argv[])
 	if (shm->exit_reason != STILL_RUNNING)
 		goto cleanup_fds;
 
+	if (logging == TRUE)
+		init_logwriter();
+
+	init_main_eventfd();
+
 	init_watchdog();
 
 	do_main_loop();
@@ -241,8 +266,19 @@ int main(int argc, char* argv[])
 	/* Shutting down. */
 	waitpid(shm->watchdog_pid, &childstatus, 0);
 
+	stop_logwriter();
+
+	total_syscall_results(&successes, &failures);
 	printf("\nRan %ld syscalls. Successes: %ld  Failures: %ld\n",
-		shm->total_syscalls_done - 1, shm->successes, shm->failures);
+		total_syscalls_done(), successes, failures);
+
+	if (shm->respawns != 0)
+		printf("Respawned %ld children. Average latency %ldus, worst %ldus\n",
+			shm->respawns, shm->respawn_usecs / shm->respawns,
+			shm->respawn_max_usecs);
+
+	dump_syscall_timings();
+	dump_blocking_fds();
 
 	ret = EXIT_SUCCESS;
 
@@ -252,9 +288,9 @@ cleanup_fds:
 		struct linger ling;
 
 		ling.l_onoff = FALSE;	/* linger active */
-		setsockopt(shm->socket_fds[i], SOL_SOCKET, SO_LINGER, &ling, sizeof(struct linger));
-		shutdown(shm->socket_fds[i], SHUT_RDWR);
-		close(shm->socket_fds[i]);
+		setsockopt(shm->sockets[i].fd, SOL_SOCKET, SO_LINGER, &ling, sizeof(struct linger));
+		shutdown(shm->sockets[i].fd, SHUT_RDWR);
+		close(shm->sockets[i].fd);
 	}
 
 	destroy_maps();
@@ -262,6 +298,8 @@ cleanup_fds:
 	if (logging == TRUE)
 		close_logfiles();
 
+	close_trace();
+
 out:
 
 	exit(ret);
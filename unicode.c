@@ -16,6 +16,7 @@
 #include <unistd.h>
 #include <string.h>
 #include "arch.h"
+#include "random.h"
 
 void gen_unicode_page(char *page)
 {
@@ -39,7 +40,7 @@ void gen_unicode_page(char *page)
 
 	while (i < (page_size - zalgolen)) {
 
-		j = rand() % 9;
+		j = rnd_below(9);
 
 		switch (j) {
 
@@ -49,7 +50,7 @@ void gen_unicode_page(char *page)
 			i += 4;
 			break;
 
-		case 1: unilen = rand() % 10;
+		case 1: unilen = rnd_below(10);
 			for (l = 0; l < unilen; l++) {
 				strncpy(ptr, unicode2, 6);
 				ptr += 6;
@@ -73,7 +74,7 @@ void gen_unicode_page(char *page)
 			ptr += 4;
 			break;
 
-		case 5: unilen = rand() % 10;
+		case 5: unilen = rnd_below(10);
 			for (l = 0; l < unilen; l++) {
 				strncpy(ptr, unicode6, 4);
 				ptr += 4;
@@ -104,7 +105,7 @@ void gen_unicode_page(char *page)
 		}
 	}
 
-	page[rand() % page_size] = 0;
+	page[rnd_below(page_size)] = 0;
 }
 
 #ifdef STANDALONE
@@ -116,6 +117,15 @@ void gen_unicode_page(char *page)
 #include <string.h>
 
 unsigned int page_size = 4096;
+uint64_t prng_state[4];
+
+void prng_seed(uint64_t s)
+{
+	prng_state[0] = s;
+	prng_state[1] = ~s;
+	prng_state[2] = s << 32;
+	prng_state[3] = s >> 32 | 1;
+}
 
 void main(int argc, char* argv[])
 {
@@ -124,7 +134,7 @@ void main(int argc, char* argv[])
 	struct timeval t;
 
 	gettimeofday(&t, 0);
-	srand((t.tv_sec * getpid()) ^ t.tv_usec);
+	prng_seed((t.tv_sec * getpid()) ^ t.tv_usec);
 
 	page = malloc(4096);
 	memset(page, 0, 4096);
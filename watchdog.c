@@ -5,7 +5,9 @@
 #include <string.h>
 #include <stdlib.h>
 #include <signal.h>
+#include <sys/epoll.h>
 #include <sys/prctl.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/wait.h>
@@ -19,6 +21,12 @@
 #include "params.h"	// quiet_level
 #include "log.h"
 #include "child.h"
+#include "constants.h"
+#include "fdinfo.h"
+
+#ifndef __NR_pidfd_open
+#define __NR_pidfd_open 434
+#endif
 
 static void watchdog(void);
 
@@ -41,6 +49,7 @@ void init_watchdog(void)
 
 static int check_shm_sanity(void)
 {
+	unsigned long total;
 	unsigned int i;
 	pid_t pid;
 
@@ -61,16 +70,36 @@ static int check_shm_sanity(void)
 	// FIXME: The '500000' is magic, and should be dynamically calculated.
 	// On startup, we should figure out how many getpid()'s per second we can do,
 	// and use that.
-	if (shm->total_syscalls_done - shm->previous_count > 500000) {
+	total = total_syscalls_done();
+	if (total - shm->previous_count > 500000) {
 		output(0, "[watchdog] Execcount increased dramatically! (old:%ld new:%ld):\n",
-			shm->previous_count, shm->total_syscalls_done);
+			shm->previous_count, total);
 		shm->exit_reason = EXIT_SHM_CORRUPTION;
 	}
-	shm->previous_count = shm->total_syscalls_done;
+	shm->previous_count = total;
 
 	return SHM_OK;
 }
 
+/*
+ * What each child was doing last, in terms of its random stream.
+ * Rerunning with -s <seed> -R <syscall> starts that slot's child right there.
+ */
+static void dump_stream_positions(void)
+{
+	unsigned int i;
+
+	for_each_pidslot(i) {
+		struct childdata *child = &shm->children[i];
+
+		if (child->stream_pos == 0)
+			continue;
+
+		output(0, "[watchdog] pidslot %u: seed %u syscall %lu\n",
+			i, child->seed, child->stream_pos - 1);
+	}
+}
+
 static void check_main(void)
 {
 	int ret;
@@ -126,24 +155,158 @@ static unsigned int reap_dead_kids(void)
 }
 
 
+/*
+ * We aren't the children's parent, so we can't wait for them. Instead we hold
+ * a pidfd for each one, which becomes readable the moment it exits, and sleep
+ * in epoll_wait() on those rather than kill(pid, 0)'ing every child every second.
+ */
+static int watch_epollfd = -1;
+static int pidfds[MAX_NR_CHILDREN];
+static pid_t watched[MAX_NR_CHILDREN];
+static bool exited[MAX_NR_CHILDREN];
+static bool use_pidfds = FALSE;
+
+static void init_pidfds(void)
+{
+	unsigned int i;
+	int fd;
+
+	for (i = 0; i < MAX_NR_CHILDREN; i++) {
+		pidfds[i] = -1;
+		watched[i] = EMPTY_PIDSLOT;
+	}
+
+	/* Older kernels don't have pidfds, in which case we fall back to polling. */
+	fd = syscall(__NR_pidfd_open, getpid(), 0);
+	if (fd == -1) {
+		output(0, "[watchdog] No pidfd support, polling children instead.\n");
+		return;
+	}
+	close(fd);
+
+	watch_epollfd = epoll_create1(EPOLL_CLOEXEC);
+	if (watch_epollfd == -1)
+		return;
+
+	use_pidfds = TRUE;
+}
+
+/*
+ * A child we were watching has exited. Normally main reaps it straight away,
+ * but if it's gone completely and is still in the pidmap, main missed it.
+ */
+static void check_exited_child(unsigned int i)
+{
+	pid_t pid = watched[i];
+
+	if (shm->pids[i] != pid)
+		return;
+
+	if (kill(pid, 0) == -1 && errno == ESRCH) {
+		output(0, "[watchdog] pid %d has disappeared. Reaping.\n", pid);
+		reap_child(pid);
+	}
+}
+
+/* Keep our pidfds in step with the pidmap. */
+static void update_pidfds(void)
+{
+	struct epoll_event ev;
+	unsigned int i;
+
+	for_each_pidslot(i) {
+		pid_t pid = shm->pids[i];
+
+		if (pid == watched[i]) {
+			if (exited[i] == TRUE)
+				check_exited_child(i);
+			continue;
+		}
+
+		if (pidfds[i] != -1) {
+			close(pidfds[i]);
+			pidfds[i] = -1;
+		}
+		watched[i] = pid;
+		exited[i] = FALSE;
+
+		if (pid == EMPTY_PIDSLOT)
+			continue;
+
+		pidfds[i] = syscall(__NR_pidfd_open, pid, 0);
+		if (pidfds[i] == -1) {
+			/* Already gone. */
+			exited[i] = TRUE;
+			continue;
+		}
+
+		/* one-shot: once it has fired, the pid stays dead, so there's no point hearing about it again. */
+		memset(&ev, 0, sizeof(ev));
+		ev.events = EPOLLIN | EPOLLONESHOT;
+		ev.data.u32 = i;
+		epoll_ctl(watch_epollfd, EPOLL_CTL_ADD, pidfds[i], &ev);
+	}
+}
+
+/* Sleep for up to a second, dealing with any children that exit meanwhile. */
+static void watch_children(void)
+{
+	struct epoll_event events[16];
+	struct timespec now, deadline;
+	int timeout, i, n;
+
+	if (use_pidfds == FALSE) {
+		sleep(1);
+		return;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &deadline);
+	deadline.tv_sec++;
+
+	do {
+		update_pidfds();
+
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		timeout = ((deadline.tv_sec - now.tv_sec) * 1000) +
+			  ((deadline.tv_nsec - now.tv_nsec) / 1000000);
+		if (timeout <= 0)
+			break;
+
+		n = epoll_wait(watch_epollfd, events, ARRAY_SIZE(events), timeout);
+		for (i = 0; i < n; i++) {
+			unsigned int slot = events[i].data.u32;
+
+			exited[slot] = TRUE;
+			check_exited_child(slot);
+		}
+	} while (shm->exit_reason == STILL_RUNNING);
+}
+
 static void check_children(void)
 {
 	struct timeval tv;
 	time_t diff;
-	time_t old, now;
+	time_t old, now, stuck;
 	pid_t pid;
 	unsigned int i;
 
 	gettimeofday(&tv, NULL);
 	now = tv.tv_sec;
 
+	/* 30 seconds with the old 1s alarm. Never less than 10, some syscalls are just slow. */
+	stuck = ((timeout_ms * 30) + 999) / 1000;
+	if (stuck < 10)
+		stuck = 10;
+
 	for_each_pidslot(i) {
+		struct childdata *child = &shm->children[i];
+
 		pid = shm->pids[i];
 
 		if (pid == EMPTY_PIDSLOT)
 			continue;
 
-		old = shm->tv[i].tv_sec;
+		old = child->tv.tv_sec;
 
 		if (old == 0)
 			continue;
@@ -151,7 +314,7 @@ static void check_children(void)
 		/* if we wrapped, just reset it, we'll pick it up next time around. */
 		if (old > (now + 3)) {
 			printf("[watchdog] child %d wrapped! old=%ld now=%ld\n", i, old, now);
-			shm->tv[i].tv_sec = now;
+			child->tv.tv_sec = now;
 			continue;
 		}
 
@@ -159,54 +322,80 @@ static void check_children(void)
 
 		/* if we're way off, we're comparing garbage. Reset it. */
 		if (diff > 1000) {
-			output(0, "[watchdog] huge delta! pid slot %d [%d]: old:%ld now:%ld diff:%d.  Setting to now.\n", i, pid, old, now, diff);
-			shm->tv[i].tv_sec = now;
+			output(0, "[watchdog] huge delta! pid slot %d [%d]: old:%ld now:%ld diff:%ld.  Setting to now.\n", i, pid, old, now, diff);
+			child->tv.tv_sec = now;
 			continue;
 		}
 
-		/* After 30 seconds of no progress, send a kill signal. */
-		if (diff == 30) {
-			unsigned int callno = shm->syscallno[i];
+		/* After 30 timeouts worth of no progress, send a kill signal. */
+		if (diff == stuck) {
+			unsigned int callno = child->syscallno;
 			char fdstr[20];
 
 			memset(fdstr, 0, sizeof(fdstr));
 
 			/* if the first arg was an fd, find out which one it was. */
 			if (biarch == FALSE) {
-				if (syscalls[callno].entry->arg1type == ARG_FD)
-					sprintf(fdstr, "(fd = %ld)", shm->a1[i]);
+				if (is_fd_argtype(syscalls[callno].entry->arg1type) == TRUE)
+					sprintf(fdstr, "(fd = %ld)", child->a1);
 			} else {
-				if (shm->do32bit[i] == TRUE) {
-					if (syscalls_32bit[callno].entry->arg1type == ARG_FD)
-						sprintf(fdstr, "(fd = %ld)", shm->a1[i]);
+				if (child->do32bit == TRUE) {
+					if (is_fd_argtype(syscalls_32bit[callno].entry->arg1type) == TRUE)
+						sprintf(fdstr, "(fd = %ld)", child->a1);
 				} else {
-					if (syscalls_64bit[callno].entry->arg1type == ARG_FD)
-						sprintf(fdstr, "(fd = %ld)", shm->a1[i]);
+					if (is_fd_argtype(syscalls_64bit[callno].entry->arg1type) == TRUE)
+						sprintf(fdstr, "(fd = %ld)", child->a1);
 				}
 			}
 
-			output(0, "[watchdog] pid %d hasn't made progress in 30 seconds! (last:%ld now:%ld diff:%d). "
+			output(0, "[watchdog] pid %d hasn't made progress in %ld seconds! (last:%ld now:%ld diff:%ld). "
 				"Stuck in syscall %d:%s%s%s. Sending SIGKILL.\n",
-				pid, old, now, diff, callno,
-				print_syscall_name(shm->syscallno[i], shm->do32bit[i]),
-				shm->do32bit[i] ? " (32bit)" : "",
+				pid, stuck, old, now, diff, callno,
+				print_syscall_name(child->syscallno, child->do32bit),
+				child->do32bit ? " (32bit)" : "",
 				fdstr);
 
 			kill(pid, SIGKILL);
 			break;
 		}
 
-		/* If it's still around after 60 seconds, we have bigger problems.
+		/* If it's still around after twice that, we have bigger problems.
 		 * Find out what's going on. */
 
-		if (diff > 60) {
-			output(0, "[watchdog] pid %d hasn't made progress in 60 seconds! (last:%ld now:%ld diff:%d)\n",
-				pid, old, now, diff);
-			shm->tv[i].tv_sec = now;
+		if (diff > stuck * 2) {
+			output(0, "[watchdog] pid %d hasn't made progress in %ld seconds! (last:%ld now:%ld diff:%ld)\n",
+				pid, stuck * 2, old, now, diff);
+			child->tv.tv_sec = now;
 		}
 	}
 }
 
+/*
+ * Throughput since the last time we were called, for the periodic
+ * progress line. Useful for comparing runs with lots of children.
+ */
+static unsigned long syscall_rate(unsigned long done)
+{
+	static struct timeval last = { 0, 0 };
+	struct timeval now;
+	unsigned long usecs;
+
+	gettimeofday(&now, NULL);
+
+	if (last.tv_sec == 0) {
+		last = now;
+		return 0;
+	}
+
+	usecs = ((now.tv_sec - last.tv_sec) * 1000000) + (now.tv_usec - last.tv_usec);
+	last = now;
+
+	if (usecs == 0)
+		return 0;
+
+	return (done * 1000000) / usecs;
+}
+
 static void kill_all_kids(void)
 {
 	/* Wait for all the children to exit. */
@@ -248,6 +437,7 @@ static void watchdog(void)
 {
 	static const char watchdogname[17]="trinity-watchdog";
 	static unsigned long lastcount = 0;
+	unsigned long total, successes, failures;
 	bool watchdog_exit = FALSE;
 	int ret = 0;
 
@@ -257,6 +447,10 @@ static void watchdog(void)
 	prctl(PR_SET_NAME, (unsigned long) &watchdogname);
 	(void)signal(SIGSEGV, SIG_DFL);
 
+	(void)syscall_rate(0);
+
+	init_pidfds();
+
 	while (watchdog_exit == FALSE) {
 
 		if (shm->regenerating == FALSE) {
@@ -264,26 +458,31 @@ static void watchdog(void)
 			if (check_shm_sanity() == SHM_CORRUPT)
 				goto corrupt;
 
-			reap_dead_kids();
+			if (use_pidfds == FALSE)
+				reap_dead_kids();
 
 			check_main();
 
 			check_children();
 
-			if (syscalls_todo && (shm->total_syscalls_done >= syscalls_todo)) {
-				output(0, "[watchdog] Reached limit %d. Telling children to exit.\n", syscalls_todo);
+			total = total_syscalls_done();
+
+			if (syscalls_todo && (total >= syscalls_todo)) {
+				output(0, "[watchdog] Reached limit %lu. Telling children to exit.\n", syscalls_todo);
 				shm->exit_reason = EXIT_REACHED_COUNT;
 			}
 
-			// Periodic log syncing. FIXME: This is kinda ugly, and mostly unnecessary.
-			if (shm->total_syscalls_done % 1000 == 0)
-				synclogs();
-
-			if ((quiet_level > 1) && (shm->total_syscalls_done > 1)) {
-				if (shm->total_syscalls_done - lastcount > 10000) {
-					printf("[watchdog] %ld iterations. [F:%ld S:%ld]\n",
-						shm->total_syscalls_done, shm->failures, shm->successes);
-					lastcount = shm->total_syscalls_done;
+			/* main only looks at this when something wakes it up. */
+			if (total - shm->regenerated_at >= REGENERATION_POINT)
+				wake_main();
+
+			if ((quiet_level > 1) && (total > 1)) {
+				if (total - lastcount > 10000) {
+					total_syscall_results(&successes, &failures);
+					printf("[watchdog] %ld iterations. [F:%ld S:%ld] %ld syscalls/sec\n",
+						total, failures, successes,
+						syscall_rate(total - lastcount));
+					lastcount = total;
 				}
 			}
 		}
@@ -293,6 +492,7 @@ static void watchdog(void)
 			ret = check_tainted();
 			if (ret != 0) {
 				output(0, "[watchdog] kernel became tainted! (%d) Last seed was %u\n", ret, shm->seed);
+				dump_stream_positions();
 				shm->exit_reason = EXIT_KERNEL_TAINTED;
 			}
 		}
@@ -304,11 +504,14 @@ static void watchdog(void)
 				output(0, "[watchdog] Triggering periodic reseed.\n");
 				shm->need_reseed = TRUE;
 				shm->reseed_counter = 0;
+				wake_main();
 			}
 		}
 
 		/* Are we done ? */
 		if (shm->exit_reason != STILL_RUNNING) {
+			wake_main();
+
 			/* Give children a chance to exit. */
 			sleep(1);
 
@@ -322,13 +525,12 @@ static void watchdog(void)
 			}
 		}
 
-		sleep(1);
+		watch_children();
 	}
 
 corrupt:
 	/* We don't want to ever exit before main is waiting for us. */
-	while (shm->regenerating == TRUE)
-		sleep(1);
+	wait_while_set(&shm->regenerating);
 
 	kill_all_kids();
 
@@ -0,0 +1,352 @@
+/*
+ * The zygote keeps a few children forked, set up and waiting, so that when
+ * a child dies main can hand its pidslot to one of them instead of doing a
+ * fork of its own plus all the per-child setup.
+ *
+ * Children get forked via an intermediate process that exits straight away,
+ * so they get reparented to main (a child subreaper) and main still gets
+ * SIGCHLD for them and can wait for them like before.
+ *
+ * When main replaces a file fd (see roll_fds), it passes the new one over
+ * a socket, so the zygote doesn't have to be restarted to pick it up.
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "trinity.h"
+#include "child.h"
+#include "signals.h"
+#include "shm.h"
+#include "pids.h"
+#include "log.h"
+#include "params.h"
+#include "files.h"
+
+/* How many ready-to-go children the zygote tries to keep around. */
+#define ZYGOTE_POOL	4
+
+/* main writes a pidslot, a waiting child reads it. */
+static int dispatch_pipe[2] = { -1, -1 };
+/* a child that took a pidslot writes a byte, so the zygote forks a replacement. */
+static int refill_pipe[2] = { -1, -1 };
+/* main sends replacement file fds down this. */
+static int fd_socket[2] = { -1, -1 };
+
+static pid_t zygote_pid = 0;
+
+static void oom_score_adj(int adj)
+{
+	FILE *fp;
+
+	fp = fopen("/proc/self/oom_score_adj", "w");
+	if (!fp)
+		return;
+
+	fprintf(fp, "%d", adj);
+	fclose(fp);
+}
+
+/* Note how long the slot sat empty, for the stats printed at exit. */
+static void account_respawn(struct childdata *child)
+{
+	struct timeval now;
+	unsigned long usecs;
+
+	if (child->reaped_at.tv_sec == 0)
+		return;
+
+	gettimeofday(&now, NULL);
+	usecs = ((now.tv_sec - child->reaped_at.tv_sec) * 1000000) +
+		(now.tv_usec - child->reaped_at.tv_usec);
+	child->reaped_at.tv_sec = 0;
+
+	__sync_fetch_and_add(&shm->respawns, 1);
+	__sync_fetch_and_add(&shm->respawn_usecs, usecs);
+	if (usecs > shm->respawn_max_usecs)
+		shm->respawn_max_usecs = usecs;
+}
+
+/* Runs in the pre-forked child: all the setup that doesn't depend on the pidslot, then wait. */
+static void pool_child(pid_t intermediate)
+{
+	static char childname[17];
+	int pidslot, ret;
+
+	close(refill_pipe[0]);
+	close(fd_socket[0]);
+
+	mask_signals_child();
+	oom_score_adj(500);
+
+	/* Don't go anywhere until we've been handed over to main, or check_parent_pid() will complain. */
+	while (getppid() == intermediate)
+		usleep(10);
+
+	ret = read(dispatch_pipe[0], &pidslot, sizeof(pidslot));
+	if (ret != sizeof(pidslot))
+		_exit(EXIT_SUCCESS);	/* main closed the pipe, we're not needed. */
+
+	close(dispatch_pipe[0]);
+
+	if (write(refill_pipe[1], "", 1) != 1) {
+		/* If the zygote is gone, main will start another. */
+	}
+	close(refill_pipe[1]);
+
+	/* If main gave up waiting for us, the slot isn't ours any more. */
+	lock(&shm->reaper_lock);
+	if (shm->children[pidslot].spawn_requested == 0) {
+		unlock(&shm->reaper_lock);
+		_exit(EXIT_SUCCESS);
+	}
+	shm->pids[pidslot] = getpid();
+	shm->children[pidslot].spawn_requested = 0;
+	unlock(&shm->reaper_lock);
+
+	memset(childname, 0, sizeof(childname));
+	sprintf(childname, "trinity-child%d", pidslot);
+	prctl(PR_SET_NAME, (unsigned long) &childname);
+
+	account_respawn(&shm->children[pidslot]);
+
+	init_child(pidslot);
+
+	ret = child_process(pidslot);
+
+	output(1, "child %d exiting\n", getpid());
+
+	_exit(ret);
+}
+
+static void fork_pool_child(void)
+{
+	int childstatus;
+	pid_t pid;
+
+	pid = fork();
+	if (pid == -1)
+		return;
+
+	if (pid == 0) {
+		/* The intermediate. Fork the real child, and orphan it. */
+		pid = getpid();
+		if (fork() == 0)
+			pool_child(pid);
+		_exit(EXIT_SUCCESS);
+	}
+
+	(void)waitpid(pid, &childstatus, 0);
+}
+
+/* A pool slot and the fd main replaced it with. */
+static void receive_fd(void)
+{
+	char cbuf[CMSG_SPACE(sizeof(int))];
+	struct cmsghdr *cmsg;
+	struct msghdr msg;
+	struct iovec iov;
+	unsigned int slot;
+	int fd;
+
+	iov.iov_base = &slot;
+	iov.iov_len = sizeof(slot);
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = cbuf;
+	msg.msg_controllen = sizeof(cbuf);
+
+	if (recvmsg(fd_socket[0], &msg, 0) != sizeof(slot))
+		return;
+
+	cmsg = CMSG_FIRSTHDR(&msg);
+	if (cmsg == NULL || cmsg->cmsg_type != SCM_RIGHTS)
+		return;
+	memcpy(&fd, CMSG_DATA(cmsg), sizeof(fd));
+
+	if (slot >= nr_file_fds) {
+		close(fd);
+		return;
+	}
+	adopt_file_fd(slot, fd);
+}
+
+static void zygote(void)
+{
+	static const char name[17] = "trinity-zygote";
+	unsigned int pool = 0;
+	unsigned int want;
+	struct pollfd pfds[2];
+	char c;
+
+	/* The pool children would get these too. */
+	close_main_fds();
+
+	prctl(PR_SET_NAME, (unsigned long) &name);
+
+	/* We only go away when main kills us, or if main dies. */
+	prctl(PR_SET_PDEATHSIG, SIGKILL);
+
+	close(dispatch_pipe[1]);
+	close(fd_socket[1]);
+
+	pfds[0].fd = refill_pipe[0];
+	pfds[0].events = POLLIN;
+	pfds[1].fd = fd_socket[0];
+	pfds[1].events = POLLIN;
+
+	want = shm->max_children;
+	if (want > ZYGOTE_POOL)
+		want = ZYGOTE_POOL;
+
+	while (shm->exit_reason == STILL_RUNNING) {
+		while (pool < want) {
+			fork_pool_child();
+			pool++;
+		}
+
+		if (poll(pfds, 2, -1) == -1) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+
+		if (pfds[1].revents & POLLIN)
+			receive_fd();
+
+		if (!(pfds[0].revents & (POLLIN | POLLHUP)))
+			continue;
+
+		if (read(refill_pipe[0], &c, 1) != 1) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		pool--;
+	}
+
+	_exit(EXIT_SUCCESS);
+}
+
+void start_zygote(void)
+{
+	if (pipe(dispatch_pipe) == -1 || pipe(refill_pipe) == -1 ||
+	    socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fd_socket) == -1) {
+		printf("## couldn't create zygote pipes: %s\n", strerror(errno));
+		shm->exit_reason = EXIT_FORK_FAILURE;
+		return;
+	}
+
+	fflush(stdout);
+	zygote_pid = fork();
+	if (zygote_pid == 0)
+		zygote();	// Never returns.
+
+	close(dispatch_pipe[0]);
+	close(refill_pipe[0]);
+	close(refill_pipe[1]);
+	close(fd_socket[0]);
+
+	if (zygote_pid == -1) {
+		printf("## couldn't fork zygote: %s\n", strerror(errno));
+		shm->exit_reason = EXIT_FORK_FAILURE;
+		return;
+	}
+
+	output(1, "[%d] Started zygote, pid %d\n", getpid(), zygote_pid);
+}
+
+/*
+ * Closing the dispatch pipe tells any children still waiting that they won't
+ * be needed. The zygote itself we just kill.
+ */
+void stop_zygote(void)
+{
+	int childstatus;
+
+	if (zygote_pid == 0)
+		return;
+
+	close(dispatch_pipe[1]);
+	dispatch_pipe[1] = -1;
+	close(fd_socket[1]);
+	fd_socket[1] = -1;
+
+	kill(zygote_pid, SIGKILL);
+	(void)waitpid(zygote_pid, &childstatus, 0);
+	zygote_pid = 0;
+}
+
+/* main reaped something that wasn't in the pidmap. If it was the zygote, start over next time. */
+bool zygote_exited(pid_t pid)
+{
+	if (pid != zygote_pid)
+		return FALSE;
+
+	close(dispatch_pipe[1]);
+	dispatch_pipe[1] = -1;
+	close(fd_socket[1]);
+	fd_socket[1] = -1;
+	zygote_pid = 0;
+	return TRUE;
+}
+
+/* Hand a pidslot to one of the waiting children. */
+int zygote_spawn(int pidslot)
+{
+	if (zygote_pid == 0)
+		start_zygote();
+	if (zygote_pid == 0)
+		return FALSE;
+
+	if (write(dispatch_pipe[1], &pidslot, sizeof(pidslot)) != sizeof(pidslot))
+		return FALSE;
+
+	return TRUE;
+}
+
+/*
+ * Pass a replaced file fd to the zygote (see roll_fds). If there's no zygote,
+ * the next one gets forked with it anyway. If it isn't keeping up, start over.
+ */
+void zygote_send_fd(unsigned int slot, int fd)
+{
+	char cbuf[CMSG_SPACE(sizeof(int))];
+	struct cmsghdr *cmsg;
+	struct msghdr msg;
+	struct iovec iov;
+
+	if (zygote_pid == 0)
+		return;
+
+	iov.iov_base = &slot;
+	iov.iov_len = sizeof(slot);
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = cbuf;
+	msg.msg_controllen = sizeof(cbuf);
+
+	cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+	memcpy(CMSG_DATA(cmsg), &fd, sizeof(fd));
+
+	if (sendmsg(fd_socket[1], &msg, MSG_DONTWAIT | MSG_NOSIGNAL) != sizeof(slot)) {
+		output(0, "[%d] couldn't pass fd %d to the zygote: %s, restarting it.\n",
+			getpid(), fd, strerror(errno));
+		stop_zygote();
+	}
+}